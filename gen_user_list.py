@@ -2,6 +2,42 @@ from pathlib import Path
 import sys
 import zlib
 
+# MSVC refuses string literals over this many bytes, even when they're made of smaller pieces
+MAX_LITERAL_SIZE = 0xffff
+
+def escape(name):
+    return name.replace("\\", "\\\\").replace("\"", "\\\"")
+
+def write_table(f, name, users):
+    # sorted by hash for the binary search, the first name wins if two share a hash
+    entries = {}
+    for user in users:
+        entries.setdefault(zlib.crc32(user.encode("utf-8")), user)
+    hashes = sorted(entries)
+    names = [entries[h] for h in hashes]
+
+    offsets = [0]
+    for user in names:
+        offsets.append(offsets[-1] + len(user.encode("utf-8")))
+    blob_size = offsets[-1] + 1
+    if blob_size > MAX_LITERAL_SIZE:
+        raise ValueError(f"{name} needs {blob_size} bytes of names, more than one string literal can hold on MSVC")
+
+    f.write(f"inline constexpr UserNameTable<{len(names)}, {blob_size}> {name} = {{\n    {{\n")
+    for i in range(0, len(hashes), 8):
+        f.write("        " + " ".join(f"{h:#010x}," for h in hashes[i:i + 8]) + "\n")
+    f.write("    },\n    {\n")
+    for i in range(0, len(offsets), 12):
+        f.write("        " + " ".join(f"{o}," for o in offsets[i:i + 12]) + "\n")
+    f.write("    },\n")
+    line = ""
+    for user in names:
+        line += escape(user)
+        if len(line) >= 100:
+            f.write(f"    \"{line}\"\n")
+            line = ""
+    f.write(f"    \"{line}\",\n}};\n")
+
 if __name__ == "__main__":
     elink_users = []
     slink_users = []
@@ -19,29 +55,52 @@ if __name__ == "__main__":
         else:
             if line:
                 current.append(line.strip())
-    
+
     with open("include/usernames.inc", "w", encoding="utf-8") as f:
         f.write(
 """#pragma once
 
+// generated by gen_user_list.py, don't edit by hand
+
 #include "util/types.h"
 
-#include <string>
-#include <unordered_map>
+#include <array>
+#include <string_view>
 
 namespace banana {
 
-const static inline std::unordered_map<u32, std::string_view> sELinkUserNames = {
-"""
-        )
-        for user in elink_users:
-            f.write(f"    {{{zlib.crc32(user.encode("utf-8")):#010x}, \"{user}\"}},\n")
-        f.write(
-"""};
+// known user names by hash, built entirely at compile time so there's nothing to set up when the program starts
+// hashes are sorted for a binary search and the names are packed into one blob in the same order
+template <size_t Count, size_t BlobSize>
+struct UserNameTable {
+    std::array<u32, Count> hashes;
+    std::array<u32, Count + 1> offsets; // name i is blob[offsets[i], offsets[i + 1])
+    char blob[BlobSize];
+
+    // empty if the hash isn't a known name
+    constexpr std::string_view find(u32 hash) const {
+        if constexpr (Count == 0) {
+            return {};
+        } else {
+            // branchless lower bound, the compare ends up as a conditional move
+            const u32* base = hashes.data();
+            size_t size = Count;
+            while (size > 1) {
+                const size_t half = size / 2;
+                base = base[half] < hash ? base + half : base;
+                size -= half;
+            }
+            const size_t index = static_cast<size_t>(base - hashes.data()) + (*base < hash ? 1 : 0);
+            if (index == Count || hashes[index] != hash)
+                return {};
+            return {blob + offsets[index], offsets[index + 1] - offsets[index]};
+        }
+    }
+};
 
-const static inline std::unordered_map<u32, std::string_view> sSLinkUserNames = {
 """
         )
-        for user in slink_users:
-            f.write(f"    {{{zlib.crc32(user.encode("utf-8")):#010x}, \"{user}\"}},\n")
-        f.write("};\n\n} // namespace banana")
\ No newline at end of file
+        write_table(f, "sELinkUserNames", elink_users)
+        f.write("\n")
+        write_table(f, "sSLinkUserNames", slink_users)
+        f.write("\n} // namespace banana\n")
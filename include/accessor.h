@@ -115,6 +115,10 @@ public:
         return reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(mParamDefineTable) + util::align(static_cast<uintptr_t>(mParamDefineTable->size), sizeof(uintptr_t)));
     }
 
+    const void* getDirectValueTable() const {
+        return mDirectValueTable;
+    }
+
     s32 getDirectValueS32(size_t index) const {
         if (index >= static_cast<size_t>(mHeader->numDirectValues)) {
             return 0;
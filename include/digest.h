@@ -0,0 +1,322 @@
+#pragma once
+
+#include "act.h"
+#include "action.h"
+#include "arrange.h"
+#include "condition.h"
+#include "container.h"
+#include "param.h"
+#include "pdt.h"
+#include "property.h"
+#include "trigger.h"
+#include "value.h"
+
+#include <bit>
+#include <string>
+#include <type_traits>
+
+namespace banana {
+
+// feeds the fields that make up the identity of a pooled entity into a sink
+// a sink is anything with update(const void*, size_t) - floats are fed as raw bits so -0.0 and 0.0 stay distinct
+
+template <typename Sink, typename T, typename std::enable_if_t<std::is_trivially_copyable_v<T>>* = nullptr>
+inline void digestValue(Sink& sink, const T value) {
+    sink.update(&value, sizeof(T));
+}
+
+template <typename Sink>
+inline void digestString(Sink& sink, const std::string_view str) {
+    digestValue(sink, static_cast<u32>(str.size()));
+    sink.update(str.data(), str.size());
+}
+
+template <typename Sink>
+void digest(Sink& sink, const Param& param) {
+    digestValue(sink, param.type);
+    digestValue(sink, param.index);
+    if (const auto* str = std::get_if<std::string_view>(&param.value)) {
+        digestString(sink, *str);
+    } else {
+        digestValue(sink, std::get<u32>(param.value));
+    }
+}
+
+template <typename Sink>
+void digest(Sink& sink, const ParamSet& params) {
+    digestValue(sink, static_cast<u32>(params.params.size()));
+    for (const auto& param : params.params) {
+        digest(sink, param);
+    }
+}
+
+template <typename Sink>
+void digest(Sink& sink, const Curve& curve) {
+    digestString(sink, curve.propertyName);
+    digestValue(sink, curve.propertyIndex);
+    digestValue(sink, curve.type);
+    digestValue(sink, curve.unk);
+    digestValue(sink, curve.unk2);
+    digestValue(sink, curve.isGlobal);
+    digestValue(sink, static_cast<u32>(curve.points.size()));
+    for (const auto& point : curve.points) {
+        digestValue(sink, std::bit_cast<u32>(point.x));
+        digestValue(sink, std::bit_cast<u32>(point.y));
+    }
+}
+
+template <typename Sink>
+void digest(Sink& sink, const Random& random) {
+    digestValue(sink, std::bit_cast<u32>(random.min));
+    digestValue(sink, std::bit_cast<u32>(random.max));
+}
+
+template <typename Sink>
+void digest(Sink& sink, const ArrangeGroupParams& params) {
+    digestValue(sink, static_cast<u32>(params.groups.size()));
+    for (const auto& group : params.groups) {
+        digestString(sink, group.groupName);
+        digestValue(sink, group.limitType);
+        digestValue(sink, group.limitThreshold);
+        digestValue(sink, group.unk);
+    }
+}
+
+template <typename Sink>
+void digest(Sink& sink, const Condition& condition) {
+    using Type = xlink2::ContainerType;
+    digestValue(sink, condition.parentContainerType);
+    switch (condition.parentContainerType) {
+        case Type::Switch: {
+            const auto cond = condition.getAs<Type::Switch>();
+            digestValue(sink, cond->propType);
+            digestValue(sink, cond->compareType);
+            digestValue(sink, cond->isGlobal);
+            digestValue(sink, cond->actionHash);
+            digestValue(sink, cond->conditionValue.i);
+            // the enum name is only serialized for enum properties
+            if (cond->propType == xlink2::PropertyType::Enum) {
+                digestString(sink, cond->enumName);
+            }
+            break;
+        }
+        case Type::Random:
+        case Type::Random2: {
+            const auto cond = condition.getAs<Type::Random>();
+            digestValue(sink, std::bit_cast<u32>(cond->weight));
+            break;
+        }
+        case Type::Blend: {
+            const auto cond = condition.getAs<Type::Blend>();
+            digestValue(sink, std::bit_cast<u32>(cond->min));
+            digestValue(sink, std::bit_cast<u32>(cond->max));
+            digestValue(sink, cond->blendTypeToMin);
+            digestValue(sink, cond->blendTypeToMax);
+            break;
+        }
+        case Type::Sequence: {
+            const auto cond = condition.getAs<Type::Sequence>();
+            digestValue(sink, cond->continueOnFade);
+            break;
+        }
+        default:
+            // Grid and Jump conditions carry no data
+            break;
+    }
+}
+
+template <typename Sink>
+void digest(Sink& sink, const ParamDefine& param) {
+    digestString(sink, param.getName());
+    digestValue(sink, param.getType());
+    switch (param.getType()) {
+        case xlink2::ParamType::Int:
+            digestValue(sink, param.getValue<xlink2::ParamType::Int>());
+            break;
+        case xlink2::ParamType::Float:
+            digestValue(sink, std::bit_cast<u32>(param.getValue<xlink2::ParamType::Float>()));
+            break;
+        case xlink2::ParamType::Bool:
+            digestValue(sink, param.getValue<xlink2::ParamType::Bool>());
+            break;
+        case xlink2::ParamType::Enum:
+            digestValue(sink, param.getValue<xlink2::ParamType::Enum>());
+            break;
+        case xlink2::ParamType::String:
+            digestString(sink, param.getValue<xlink2::ParamType::String>());
+            break;
+        case xlink2::ParamType::Bitfield:
+            digestValue(sink, param.getValue<xlink2::ParamType::Bitfield>());
+            break;
+        default:
+            break;
+    }
+}
+
+template <typename Sink>
+void digest(Sink& sink, const ParamDefineTable& pdt) {
+    digestValue(sink, pdt.getSystemUserParamCount());
+    digestValue(sink, pdt.getSystemAssetParamCount());
+    const auto digestParams = [&sink, &pdt](size_t count, ParamType type) {
+        digestValue(sink, static_cast<u32>(count));
+        for (size_t i = 0; i < count; ++i) {
+            digest(sink, pdt.getParam(i, type));
+        }
+    };
+    digestParams(pdt.getUserParamCount(), ParamType::USER);
+    digestParams(pdt.getAssetParamCount(), ParamType::ASSET);
+    digestParams(pdt.getTriggerParamCount(), ParamType::TRIGGER);
+}
+
+template <typename Sink>
+void digest(Sink& sink, const AssetCallTable& act) {
+    digestString(sink, act.keyName);
+    digestValue(sink, act.assetIndex);
+    digestValue(sink, act.flag);
+    digestValue(sink, act.duration);
+    digestValue(sink, act.parentIndex);
+    digestValue(sink, act.guid);
+    digestValue(sink, act.keyNameHash);
+    digestValue(sink, act.assetParamIdx);
+    digestValue(sink, act.conditionIdx);
+}
+
+template <typename Sink>
+void digest(Sink& sink, const Container& container) {
+    using Type = xlink2::ContainerType;
+    digestValue(sink, container.type);
+    digestValue(sink, container.childContainerStartIdx);
+    digestValue(sink, container.childCount);
+#if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
+    digestValue(sink, container.isNotBlendAll);
+    digestValue(sink, container.isNeedObserve);
+#endif
+    const auto digestSwitch = [&sink](const SwitchContainerParam* param) {
+        digestString(sink, param->actionSlotName);
+        digestValue(sink, param->propertyIndex);
+        digestValue(sink, param->isGlobal);
+#if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
+        digestValue(sink, param->unk);
+        digestValue(sink, param->isActionTrigger);
+#else
+        digestValue(sink, param->watchPropertyId);
+#endif
+    };
+    switch (container.type) {
+        case Type::Switch:
+            digestSwitch(container.getAs<Type::Switch>());
+            break;
+#if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
+        case Type::Blend:
+            if (container.isNotBlendAll) {
+                digestSwitch(container.getAs<Type::Blend, true>());
+            }
+            break;
+        case Type::Grid: {
+            const auto param = container.getAs<Type::Grid>();
+            digestString(sink, param->propertyName1);
+            digestString(sink, param->propertyName2);
+            digestValue(sink, param->propertyIndex1);
+            digestValue(sink, param->propertyIndex2);
+            digestValue(sink, param->isGlobal1);
+            digestValue(sink, param->isGlobal2);
+            digestValue(sink, static_cast<u32>(param->values1.size()));
+            sink.update(param->values1.data(), param->values1.size() * sizeof(u32));
+            digestValue(sink, static_cast<u32>(param->values2.size()));
+            sink.update(param->values2.data(), param->values2.size() * sizeof(u32));
+            digestValue(sink, static_cast<u32>(param->indices.size()));
+            sink.update(param->indices.data(), param->indices.size() * sizeof(s32));
+            break;
+        }
+#endif
+        default:
+            // the rest have no data of their own
+            break;
+    }
+}
+
+template <typename Sink>
+void digest(Sink& sink, const ActionSlot& slot) {
+    digestString(sink, slot.actionSlotName);
+    digestValue(sink, slot.actionStartIdx);
+    digestValue(sink, slot.actionCount);
+}
+
+template <typename Sink>
+void digest(Sink& sink, const Action& action) {
+    digestString(sink, action.actionName);
+    digestValue(sink, action.actionTriggerStartIdx);
+    digestValue(sink, action.actionTriggerCount);
+#if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
+    digestValue(sink, action.enableMatchStart);
+#endif
+}
+
+template <typename Sink>
+void digest(Sink& sink, const ActionTrigger& trigger) {
+    digestValue(sink, trigger.guid);
+#if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
+    digestValue(sink, trigger.unk);
+#endif
+    digestValue(sink, trigger.triggerOnce);
+    digestValue(sink, trigger.fade);
+    digestValue(sink, trigger.alwaysTrigger);
+    digestValue(sink, trigger.nameMatch);
+    digestValue(sink, trigger.assetCallIdx);
+    // the previous action name takes the place of the start frame
+    if (trigger.nameMatch) {
+        digestString(sink, trigger.previousActionName);
+    } else {
+        digestValue(sink, trigger.startFrame);
+    }
+    digestValue(sink, trigger.endFrame);
+    digestValue(sink, trigger.triggerOverwriteIdx);
+    digestValue(sink, trigger.overwriteHash);
+}
+
+template <typename Sink>
+void digest(Sink& sink, const Property& prop) {
+    digestString(sink, prop.propertyName);
+    digestValue(sink, prop.propTriggerStartIdx);
+    digestValue(sink, prop.propTriggerCount);
+    digestValue(sink, prop.isGlobal);
+}
+
+template <typename Sink>
+void digest(Sink& sink, const PropertyTrigger& trigger) {
+    digestValue(sink, trigger.guid);
+    digestValue(sink, trigger.flag);
+    digestValue(sink, trigger.overwriteHash);
+    digestValue(sink, trigger.assetCallTableIdx);
+    digestValue(sink, trigger.conditionIdx);
+    digestValue(sink, trigger.triggerOverwriteIdx);
+}
+
+template <typename Sink>
+void digest(Sink& sink, const AlwaysTrigger& trigger) {
+    digestValue(sink, trigger.guid);
+    digestValue(sink, trigger.flag);
+    digestValue(sink, trigger.overwriteHash);
+    digestValue(sink, trigger.assetCallIdx);
+    digestValue(sink, trigger.triggerOverwriteIdx);
+}
+
+// byte string key for hash-consing, two entries share a key iff they serialize identically
+struct DigestKey {
+    std::string bytes{};
+
+    void update(const void* data, size_t size) {
+        bytes.append(reinterpret_cast<const char*>(data), size);
+    }
+};
+
+// length prefixed so adjacent ranges can't alias each other
+template <typename Sink, typename Range>
+void digestRange(Sink& sink, const Range& range) {
+    digestValue(sink, static_cast<u32>(std::size(range)));
+    for (const auto& value : range) {
+        digest(sink, value);
+    }
+}
+
+} // namespace banana
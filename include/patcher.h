@@ -0,0 +1,48 @@
+#pragma once
+
+#include "accessor.h"
+#include "resource.h"
+
+#include <vector>
+
+namespace banana {
+
+// edits fixed size values directly in a resource buffer without going through System
+// nothing here changes the layout so the buffer stays valid after every call, functions return false if the target doesn't exist
+// everything is addressed by its index in the pool it lives in, so an edit to a shared record is visible to all of its users
+class ResourcePatcher {
+public:
+    ResourcePatcher() = default;
+
+    bool load(void* data, size_t size);
+
+    bool isLoaded() const {
+        return mAccessor.isLoaded();
+    }
+
+    bool setDirectValueU32(s32 index, u32 value);
+    bool setDirectValueS32(s32 index, s32 value);
+    bool setDirectValueF32(s32 index, f32 value);
+
+    bool setRandomCall(s32 index, f32 min, f32 max);
+
+    bool setCurvePoint(s32 curveIndex, s32 pointIndex, f32 x, f32 y);
+
+    // the value has to match the property type of the condition, enum conditions can't be patched
+    bool setSwitchConditionS32(s32 conditionIndex, s32 value);
+    bool setSwitchConditionF32(s32 conditionIndex, f32 value);
+    bool setBlendConditionRange(s32 conditionIndex, f32 min, f32 max);
+    bool setRandomConditionWeight(s32 conditionIndex, f32 weight);
+
+    // name match triggers store the previous action name where the start frame would be so they can't be patched here
+    bool setActionTriggerFrames(u32 userHash, s32 triggerIndex, s32 startFrame, s32 endFrame);
+
+private:
+    xlink2::ResUserHeader* searchUser(u32 hash) const;
+    xlink2::ResCondition* getCondition(s32 index, xlink2::ContainerType type) const;
+
+    ResourceAccessor mAccessor{};
+    std::vector<TargetPointer> mConditionOffsets{}; // conditions vary in size so they can't be indexed directly
+};
+
+} // namespace banana
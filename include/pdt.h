@@ -3,6 +3,8 @@
 #include "resource.h"
 #include "accessor.h"
 #include "util/yaml.h"
+#include "util/json.h"
+#include "util/yaml_writer.h"
 
 #include <set>
 #include <string>
@@ -58,10 +60,12 @@ public:
 
     void print() const;
 
-    void dumpYAML(LibyamlEmitterWithStorage<std::string>&) const;
+    template <typename Emitter>
+    void dumpYAML(Emitter&) const;
     void loadYAML(const ryml::ConstNodeRef&, const std::string_view&&, ParamDefineTable&);
 
     friend class Serializer;
+    friend class System;
 
 private:
     std::string_view mName;
@@ -110,9 +114,19 @@ public:
         return mTriggerParams.size();
     }
 
+    s32 getSystemUserParamCount() const {
+        return mSystemUserParamCount;
+    }
+
+    s32 getSystemAssetParamCount() const {
+        return mSystemAssetParamCount;
+    }
+
     s32 searchParamIndex(std::string_view, ParamType) const;
 
-    void dumpYAML(LibyamlEmitterWithStorage<std::string>&, bool exportStrings = false) const;
+    // also writes the json version through a JsonWriter
+    template <typename Emitter>
+    void dumpYAML(Emitter&, bool exportStrings = false) const;
     bool loadYAML(const ryml::ConstNodeRef&);
 
     std::string_view addString(const std::string s) {
@@ -120,6 +134,7 @@ public:
     }
 
     friend class Serializer;
+    friend class System;
 
 private:
     std::vector<ParamDefine> mUserParams{};
@@ -2,6 +2,7 @@
 
 #include "system.h"
 
+#include <array>
 #include <cstring>
 #include <map>
 #include <span>
@@ -14,7 +15,7 @@ namespace banana {
 // assumes little endian
 class Serializer {
 public:
-    explicit Serializer(System* sys) : mSystem(sys) {}
+    explicit Serializer(System* sys, bool incremental = false) : mSystem(sys), mIncremental(incremental) {}
 
     void write(std::span<const u8> data) {
         if (mOffset + data.size() > mData.size()) {
@@ -94,8 +95,23 @@ private:
         TargetPointer triggerTableOffset;
         s32 assetCount;
         s32 randomContainerCount;
+        bool reuseSource = false;
     };
 
+    struct Section {
+        TargetPointer begin;
+        TargetPointer end;
+
+        size_t size() const {
+            return end - begin;
+        }
+    };
+
+    using PoolSections = std::array<Section, static_cast<size_t>(System::Pool::Count)>;
+
+    static PoolSections calcPoolSections(const xlink2::ResourceHeader&, TargetPointer assetParamTablePos, TargetPointer userRegionPos);
+    bool copySourceSection(System::Pool);
+
     const xlink2::ResourceHeader calcOffsets();
     void writeParamDefine(const ParamDefine&);
     void writePDT();
@@ -103,6 +119,11 @@ private:
     void writeUser(const User&, u32);
 
     System* mSystem = nullptr;
+    bool mIncremental = false;
+    bool mLayoutStable = false;
+    PoolSections mSections{};
+    PoolSections mSourceSections{};
+    std::vector<std::string_view> mAppendedStrings{};
     size_t mOffset = 0;
     std::vector<u8> mData{};
     std::unordered_map<std::string_view, TargetPointer> mPDTStringOffsets{};
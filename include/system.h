@@ -8,7 +8,23 @@
 #include "condition.h"
 #include "arrange.h"
 
+#include "util/file.h"
+#include "util/json.h"
 #include "util/yaml.h"
+#include "util/yaml_writer.h"
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <set>
+
+namespace util {
+class FragmentCache;
+class InputStream;
+class NameDictionary;
+class NameDictionaryBuilder;
+} // namespace util
 
 // this is not xlink2::System so we're clear
 
@@ -16,11 +32,42 @@ namespace banana {
 
 class Serializer;
 
+// what dumpYAML writes, the defaults give the full document
+struct DumpOptions {
+    bool exportStrings = false;
+    bool includeUsers = true;
+    // writes each param's value in place instead of an index into DirectValues
+    bool inlineDirectValues = false;
+    // flow style for the small fixed-shape records and aliases for repeated param sets and arrange groups
+    bool compact = false;
+    // names are matched against both the top level sections and the ones inside each user, empty writes everything
+    // anything filtered this way is meant for reading, the result usually can't be imported again
+    std::set<std::string, std::less<>> sections{};
+    // users that haven't changed since the cache was written are copied out of it instead of being written again
+    // load it with getFragmentContext for the same options
+    util::FragmentCache* fragmentCache = nullptr;
+};
+
 class System {
 public:
+    // shared pools, in the order their sections appear in the file
+    enum class Pool : u32 {
+        AssetParams,
+        TriggerOverwriteParams,
+        DirectValues,
+        RandomCalls,
+        Curves,
+        ArrangeGroupParams,
+        Conditions,
+
+        Count,
+    };
+
     System() = default;
 
-    bool initialize(void* data, size_t size);
+    // only the users in onlyUsers are decoded if it isn't empty, the pools are still loaded in full
+    // keepSource holds onto a copy of the file and its layout for incremental serialization, which needs it
+    bool initialize(void* data, size_t size, const std::set<u32>& onlyUsers = {}, bool keepSource = false);
 
     const ParamDefineTable& getPDT() const {
         return mPDT;
@@ -56,6 +103,13 @@ public:
     bool searchUser(const std::string_view&) const;
     bool searchUser(u32) const;
 
+    // user names the built in tables don't know are looked up here when dumping, the dictionary has to outlive this
+    void setNameDictionary(const util::NameDictionary* names) {
+        mNames = names;
+    }
+    // adds every user, key, property and action name the model knows of to the builder
+    void collectNames(util::NameDictionaryBuilder&) const;
+
     void printUser(const std::string_view) const;
     void printParam(const Param&, ParamType) const;
 
@@ -66,34 +120,130 @@ public:
 
     s32 searchParamIndex(const std::string_view&, ParamType) const;
 
-    std::vector<u8> serialize();
+    // incremental serialization keeps the source file's string layout and copies untouched users and pools over verbatim
+    // unreferenced source strings are kept too, it falls back to a full rebuild once they're over a quarter of the table
+    std::vector<u8> serialize(bool incremental = false);
+
+    void markDirty(Pool pool) {
+        mDirtyPools |= 1u << static_cast<u32>(pool);
+        mHashedPools &= ~(1u << static_cast<u32>(pool));
+    }
+
+    bool isDirty(Pool pool) const {
+        return (mDirtyPools >> static_cast<u32>(pool) & 1) == 1;
+    }
+
+    // drops pool entries and strings that nothing reachable from a user references anymore
+    void eliminateDeadEntries();
+
+    // merges structurally identical pool entries and rewrites every reference to point at the survivor
+    void canonicalize();
 
-    std::string dumpYAML(bool exportStrings = false) const;
+    // order defined hash of the model's content (not its encoding), much cheaper than hashing serialize()'s output
+    // pool and user hashes are cached and dropped by the same edits that mark them dirty, so don't hang onto
+    // references from the non-const getters across calls to this
+    u64 getContentHash() const;
+    u64 getUserContentHash(u32) const;
+
+    // hash of everything besides the user itself that goes into a user's yaml
+    u64 getFragmentContext(const DumpOptions& options) const;
+
+    std::string dumpYAML(const DumpOptions& options = {}) const;
+    // writes through the given emitter, give it a sink to stream the document out instead of building it in memory
+    void dumpYAML(YamlWriter& emitter, const DumpOptions& options = {}) const;
+    // writes the pools to root.yaml and every user to its own file under users/, manifest.yaml lists them all
+    bool dumpYAMLSplit(const std::string& dir, const DumpOptions& options = {}) const;
+    // same schema as dumpYAML, yaml tags are kept as {"!tag": value} wrappers (see JsonWriter)
+    // compact and fragmentCache are ignored since json has no aliases and the cache holds yaml
+    std::string dumpJSON(const DumpOptions& options = {}) const;
+    void dumpJSON(JsonWriter& emitter, const DumpOptions& options = {}) const;
 
     bool loadYAML(std::string_view);
+    // parses the text in place and holds onto it, strings are borrowed from it rather than copied
+    bool loadYAML(std::vector<u8>&& text);
+    // reads the file as it goes and never builds a tree for more than one pool entry or user at a time
+    // slower than loading the whole thing, but memory stays flat regardless of how big the file is
+    bool loadYAMLStream(util::InputStream& input);
+    // reads what dumpJSON writes, strings are unescaped in place and borrowed from the text like loadYAML does
+    // it goes through the document in one pass, each pool entry or user is copied into a small ryml tree of its own
+    // so the yaml loaders can decode it, only one of those exists at a time
+    bool loadJSON(std::string_view);
+    bool loadJSON(std::vector<u8>&& text);
+    // applies a yaml on top of what's already loaded (usually a binary), every section is optional
+    // users replace the ones with the same name, pool entries are keyed by index and one past the end appends
+    // only what the overlay touches is marked dirty, so incremental serialization copies everything else over as is
+    // a malformed overlay returns false, anything applied before the error is kept
+    bool loadYAMLOverlay(std::vector<u8>&& text);
+    // binary copy of the decoded model for reloading without parsing anything, sourceHash identifies what it was made from
+    // it's tied to the build that wrote it, loading fails on anything else (or a different sourceHash) and leaves this untouched
+    bool saveSnapshot(const std::string& path, u64 sourceHash) const;
+    // strings are borrowed from the mapped file, which is kept open for as long as this system is around
+    bool loadSnapshot(const std::string& path, u64 sourceHash);
+    // loads a directory written by dumpYAMLSplit, user files are parsed in parallel
+    // calling it again only re-reads the users whose files changed since the last call, unless root.yaml did
+    bool loadYAMLSplit(const std::string& dir);
 
-    const std::string_view addString(const std::string s) {
-        return std::move(*mStrings.insert(std::move(s)).first);
+    // strings inside the yaml text we're holding onto are borrowed, anything else is copied into mStringStorage
+    const std::string_view addString(const std::string_view s) {
+        // users being loaded on worker threads intern into their own arena instead, see loadUsers
+        if (sLoadArena != nullptr) {
+            return addArenaString(s);
+        }
+        if (const auto it = mStrings.find(s); it != mStrings.end()) {
+            return *it;
+        }
+        return *mStrings.insert(isBorrowable(s) ? s : std::string_view(mStringStorage.emplace_back(s))).first;
     }
 
     friend class Serializer;
 
 private:
-    inline void dumpCurve(LibyamlEmitterWithStorage<std::string>&, const Curve&) const;
-    inline void dumpRandom(LibyamlEmitterWithStorage<std::string>&, const Random&) const;
-    inline void dumpArrangeGroupParam(LibyamlEmitterWithStorage<std::string>&, const ArrangeGroupParams&) const;
-    inline void dumpParam(LibyamlEmitterWithStorage<std::string>&, const Param&, ParamType) const;
-    inline void dumpParamSet(LibyamlEmitterWithStorage<std::string>&, const ParamSet&, ParamType) const;
-    inline void dumpCondition(LibyamlEmitterWithStorage<std::string>&, const Condition&) const;
-    inline void dumpContainer(LibyamlEmitterWithStorage<std::string>&, const Container&) const;
-    inline void dumpAssetCallTable(LibyamlEmitterWithStorage<std::string>&, const AssetCallTable&) const;
-    inline void dumpActionSlot(LibyamlEmitterWithStorage<std::string>&, const ActionSlot&) const;
-    inline void dumpAction(LibyamlEmitterWithStorage<std::string>&, const Action&) const;
-    inline void dumpActionTrigger(LibyamlEmitterWithStorage<std::string>&, const ActionTrigger&) const;
-    inline void dumpProperty(LibyamlEmitterWithStorage<std::string>&, const Property&) const;
-    inline void dumpPropertyTrigger(LibyamlEmitterWithStorage<std::string>&, const PropertyTrigger&) const;
-    inline void dumpAlwaysTrigger(LibyamlEmitterWithStorage<std::string>&, const AlwaysTrigger&) const;
-    inline void dumpUser(LibyamlEmitterWithStorage<std::string>&, const User&) const;
+    // the dump functions write through either a YamlWriter or a JsonWriter
+    template <typename Emitter>
+    void dumpCurve(Emitter&, const Curve&) const;
+    template <typename Emitter>
+    void dumpRandom(Emitter&, const Random&) const;
+    template <typename Emitter>
+    void dumpArrangeGroupParam(Emitter&, const ArrangeGroupParams&, YamlWriter::Style) const;
+    // whether an inline value would load back as the same direct value, see dumpParam
+    bool canInlineDirectValue(const Param&, ParamType) const;
+    // how much of DirectValues a dump has to write, with inlined values that's only up to the last one still used by index
+    size_t countDumpedDirectValues(const DumpOptions&) const;
+    template <typename Emitter>
+    void dumpParam(Emitter&, const Param&, ParamType, const DumpOptions&) const;
+    template <typename Emitter>
+    void dumpParamSet(Emitter&, const ParamSet&, ParamType, const DumpOptions&) const;
+    template <typename Emitter>
+    void dumpCondition(Emitter&, const Condition&) const;
+    template <typename Emitter>
+    void dumpContainer(Emitter&, const Container&) const;
+    template <typename Emitter>
+    void dumpAssetCallTable(Emitter&, const AssetCallTable&) const;
+    template <typename Emitter>
+    void dumpActionSlot(Emitter&, const ActionSlot&, YamlWriter::Style) const;
+    template <typename Emitter>
+    void dumpAction(Emitter&, const Action&, YamlWriter::Style) const;
+    template <typename Emitter>
+    void dumpActionTrigger(Emitter&, const ActionTrigger&) const;
+    template <typename Emitter>
+    void dumpProperty(Emitter&, const Property&, YamlWriter::Style) const;
+    template <typename Emitter>
+    void dumpPropertyTrigger(Emitter&, const PropertyTrigger&, YamlWriter::Style) const;
+    template <typename Emitter>
+    void dumpAlwaysTrigger(Emitter&, const AlwaysTrigger&, YamlWriter::Style) const;
+    template <typename Emitter>
+    void dumpUser(Emitter&, const User&, const DumpOptions&) const;
+    template <typename Emitter>
+    void dumpUsers(Emitter&, const DumpOptions&) const;
+    template <typename Emitter>
+    void dumpUserName(Emitter&, u32) const;
+    // everything dumpYAML and dumpJSON write, the emitter decides which one it turns into
+    template <typename Emitter>
+    void dumpDocument(Emitter&, const DumpOptions&) const;
+    std::string_view lookupUserName(u32) const; // empty if the hash isn't a known name
+    std::string dumpUserFragment(u32, const User&, u32 indent, const DumpOptions&) const;
+    u64 getUserFragmentKey(u32, const User&, u32 indent, const DumpOptions&) const;
+    std::string dumpUserFragmentJSON(u32, const User&, const DumpOptions&) const;
 
     struct DirectValue {
         union {
@@ -114,11 +264,39 @@ private:
         }
     };
 
+    // old index -> new index for each shared pool, an empty vector leaves that pool's references untouched
+    struct PoolRemap {
+        std::vector<s32> directValues{};
+        std::vector<s32> curves{};
+        std::vector<s32> randomCalls{};
+        std::vector<s32> arrangeGroupParams{};
+        std::vector<s32> assetParams{};
+        std::vector<s32> triggerOverwriteParams{};
+        std::vector<s32> conditions{};
+    };
+
+    void remapPools(const PoolRemap&);
+
+    u64 calcPoolHash(Pool) const;
+
+    // what the resource looked like when it was loaded, used by incremental serialization
+    struct SourceLayout {
+        std::vector<u8> data{};
+        std::unordered_map<std::string_view, TargetPointer> stringOffsets{}; // views into data
+        size_t nameTableSize = 0;
+        TargetPointer assetParamTablePos = 0;
+        TargetPointer userRegionPos = 0;
+        std::vector<TargetPointer> assetParamOffsets{};
+        std::vector<TargetPointer> triggerOverwriteParamOffsets{};
+        std::vector<TargetPointer> conditionOffsets{};
+        std::vector<TargetPointer> arrangeGroupParamOffsets{};
+    };
+
     inline void loadCurve(Curve&, const c4::yml::ConstNodeRef&);
     inline void loadRandom(Random&, const c4::yml::ConstNodeRef&);
     inline void loadArrangeGroupParams(ArrangeGroupParams&, const c4::yml::ConstNodeRef&);
-    inline void loadParam(Param&, const c4::yml::ConstNodeRef&, ParamType /*, std::map<DirectValue, s32>&*/);
-    inline void loadParamSet(ParamSet&, const c4::yml::ConstNodeRef&, ParamType /*, std::map<DirectValue, s32>&*/);
+    inline void loadParam(Param&, const c4::yml::ConstNodeRef&, ParamType);
+    inline void loadParamSet(ParamSet&, const c4::yml::ConstNodeRef&, ParamType);
     inline void loadCondition(Condition&, const c4::yml::ConstNodeRef&);
     inline void loadContainer(Container&, const c4::yml::ConstNodeRef&);
     inline void loadAssetCallTable(AssetCallTable&, const c4::yml::ConstNodeRef&);
@@ -128,21 +306,84 @@ private:
     inline void loadProperty(Property&, const c4::yml::ConstNodeRef&);
     inline void loadPropertyTrigger(PropertyTrigger&, const c4::yml::ConstNodeRef&);
     inline void loadAlwaysTrigger(AlwaysTrigger&, const c4::yml::ConstNodeRef&);
-    inline void loadUser(User&, const c4::yml::ConstNodeRef& /*, std::map<DirectValue, s32>&*/);
+    inline void loadDirectValue(DirectValue&, const c4::yml::ConstNodeRef&);
+    inline void loadUser(User&, const c4::yml::ConstNodeRef&);
+    void loadUsers(const c4::yml::ConstNodeRef&);
+
+    // what a user loading on a worker thread would otherwise have added to the system directly
+    struct LoadArena {
+        std::set<std::string_view> strings{}; // anything that wasn't already in mStrings
+        std::list<std::string> storage{};
+        std::vector<std::pair<Param*, DirectValue>> directValues{}; // inline values still waiting on a slot
+    };
+
+    struct LoadedUser {
+        u32 hash;
+        User user;
+        LoadArena arena;
+    };
+
+    // safe to call from several threads at once as long as nothing else is touching mStrings
+    void loadUserIsolated(LoadedUser&, const c4::yml::ConstNodeRef&);
+    void mergeLoadedUser(LoadedUser&);
+    bool loadYAMLTree(const c4::yml::ConstNodeRef&);
+    bool applyYAMLOverlay(std::vector<u8>&& text);
+    // the section by section loading loadYAMLStream and loadJSON share, Sections walks the document (see xlinkyaml.cpp)
+    template <typename Sections>
+    bool loadSections(Sections&);
+
+    // walks everything saveSnapshot writes, the archive decides whether that's reading or writing
+    template <typename Archive>
+    void transferSnapshot(Archive&);
+
+    std::string_view addArenaString(std::string_view);
+
+    bool isBorrowable(std::string_view s) const {
+        const char* begin = reinterpret_cast<const char*>(mText.data());
+        return !mText.empty() && std::less_equal<const char*>{}(begin, s.data()) && std::less_equal<const char*>{}(s.data() + s.size(), begin + mText.size());
+    }
+
+    // only set on threads that are loading a user, gets merged into the system afterwards
+    static thread_local LoadArena* sLoadArena;
+
+    // finds or adds a direct value with the same type and bits
+    s32 internDirectValue(const DirectValue&);
 
     ParamDefineTable mPDT;
-    std::set<std::string> mStrings;
+    std::set<std::string_view> mStrings;
+    std::list<std::string> mStringStorage; // backing for strings that aren't borrowed, a list so nodes can be spliced in
+    std::vector<u8> mText; // yaml text that was parsed in place
+    std::unique_ptr<util::MappedFile> mSnapshot; // snapshot the model was loaded from, strings point into it
     std::vector<std::string_view> mLocalProperties;
     std::vector<std::string_view> mLocalPropertyEnumStrings;
     std::vector<Curve> mCurves;
     std::vector<Random> mRandomCalls;
     std::vector<DirectValue> mDirectValues;
+    std::unordered_map<u64, s32> mDirectValueIndices; // (type << 32 | bits) -> index, covers the first mIndexedDirectValues entries
+    size_t mIndexedDirectValues = 0;
     std::vector<ParamSet> mTriggerOverwriteParams;
     std::vector<ParamSet> mAssetParams;
     std::map<u32, User> mUsers;
     std::vector<Condition> mConditions;
     std::vector<ArrangeGroupParams> mArrangeGroupParams;
     u32 mVersion;
+    const util::NameDictionary* mNames = nullptr;
+    SourceLayout mSource{};
+    u32 mDirtyPools = ~0u;
+    mutable std::array<u64, static_cast<size_t>(Pool::Count)> mPoolHashes{};
+    mutable u32 mHashedPools = 0;
+
+    // what each file looked like the last time loadYAMLSplit read it
+    struct SplitSource {
+        struct UserFile {
+            u64 fileHash;
+            u32 userHash;
+        };
+
+        u64 rootHash = 0;
+        std::map<std::string, UserFile> users{}; // keyed by the path listed in the manifest
+    };
+    std::optional<SplitSource> mSplitSource{};
 };
 
 } // namespace banana
\ No newline at end of file
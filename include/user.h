@@ -33,6 +33,69 @@ public:
                     const std::unordered_map<TargetPointer, s32>& conditions,
                     std::set<TargetPointer>& arrangeParams);
 
+    // dirty users are re-encoded on serialize, clean ones can be copied from the source file as is
+    bool isDirty() const {
+        return mDirty;
+    }
+
+    void markDirty() {
+        mDirty = true;
+        mHasContentHash = false;
+    }
+
+    // cached until the user is marked dirty
+    u64 getContentHash() const;
+
+    // calls func(std::string_view&) on every string the user references so they can be repointed
+    template <typename Func>
+    void forEachString(Func&& func) {
+        for (auto& prop : mLocalProperties) {
+            func(prop);
+        }
+        for (auto& param : mUserParams) {
+            if (auto* str = std::get_if<std::string_view>(&param.value)) {
+                func(*str);
+            }
+        }
+        for (auto& container : mContainers) {
+            switch (container.type) {
+                case xlink2::ContainerType::Switch:
+                    func(container.getAs<xlink2::ContainerType::Switch>()->actionSlotName);
+                    break;
+#if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
+                case xlink2::ContainerType::Blend:
+                    if (container.isNotBlendAll) {
+                        func(container.getAs<xlink2::ContainerType::Blend, true>()->actionSlotName);
+                    }
+                    break;
+                case xlink2::ContainerType::Grid: {
+                    auto* param = container.getAs<xlink2::ContainerType::Grid>();
+                    func(param->propertyName1);
+                    func(param->propertyName2);
+                    break;
+                }
+#endif
+                default:
+                    break;
+            }
+        }
+        for (auto& act : mAssetCallTables) {
+            func(act.keyName);
+        }
+        for (auto& slot : mActionSlots) {
+            func(slot.actionSlotName);
+        }
+        for (auto& action : mActions) {
+            func(action.actionName);
+        }
+        for (auto& trigger : mActionTriggers) {
+            func(trigger.previousActionName);
+        }
+        for (auto& prop : mProperties) {
+            func(prop.propertyName);
+        }
+    }
+
     friend class Serializer;
     friend class System;
 
@@ -48,7 +111,15 @@ private:
     std::vector<Property> mProperties{};
     std::vector<PropertyTrigger> mPropertyTriggers{};
     std::vector<AlwaysTrigger> mAlwaysTriggers{};
-    u16 mUnknown;
+    u16 mUnknown = 0;
+
+    // byte range this user was read from in the source file, a size of 0 means there's nothing to reuse
+    TargetPointer mSourceOffset = 0;
+    size_t mSourceSize = 0;
+    bool mDirty = true;
+
+    mutable u64 mContentHash = 0;
+    mutable bool mHasContentHash = false;
 };
 
 } // namespace banana
\ No newline at end of file
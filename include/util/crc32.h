@@ -3,13 +3,42 @@
 #include "util/types.h"
 
 #include <array>
+#include <span>
 #include <string>
+#include <string_view>
 
 namespace util {
 
-constexpr std::array<u32, 0x100> initializeCRC32Table();
+constexpr std::array<u32, 0x100> initializeCRC32Table() {
+    std::array<u32, 0x100> table{};
 
+    for (u32 i = 0; i < table.size(); ++i) {
+        u32 value = i;
+        for (u32 j = 0; j < 8; ++j) {
+            value = ((value & 1) == 0) ? (value >> 1) : (0xedb88320 ^ (value >> 1));
+        }
+        table[i] = value;
+    }
+
+    return table;
+}
+
+inline constexpr std::array<u32, 0x100> cCRC32Table = initializeCRC32Table();
+
+// slice-by-16, or carry-less multiply folding on x86-64 cpus that have it for anything long enough to benefit
 u32 calcCRC32(const char* str);
 u32 calcCRC32(const std::string_view str);
+// hashes every string in strs into the matching slot of out, which has to be at least as big
+// a few strings are stepped through at once so their table lookups overlap, much faster than one at a time for names
+void calcCRC32(std::span<const std::string_view> strs, std::span<u32> out);
+
+// same hash but usable in constant expressions (switch cases and the like)
+constexpr u32 calcCRC32Const(const std::string_view str) {
+    u32 hash = 0xffffffff;
+    for (const char c : str) {
+        hash = cCRC32Table[static_cast<u8>(c) ^ (hash & 0xff)] ^ (hash >> 8);
+    }
+    return ~hash;
+}
 
-} // namespace util
\ No newline at end of file
+} // namespace util
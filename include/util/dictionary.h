@@ -0,0 +1,104 @@
+#pragma once
+
+#include "util/file.h"
+#include "util/types.h"
+
+#include <array>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace util {
+
+// hash <-> name lookup for names that aren't compiled in, read straight out of a mapped file
+// each section has its crc32s sorted and an offset per name into a packed blob (in the same order)
+// a name is looked up by its crc32 too, so both directions are one binary search over the hashes
+// and opening it doesn't have to look at anything past the header
+class NameDictionary {
+public:
+    enum class Section : u32 {
+        User,
+        Key, // asset call table key names
+        Property,
+        Action,
+
+        Count,
+    };
+
+    NameDictionary() = default;
+
+    NameDictionary(const NameDictionary&) = delete;
+    NameDictionary& operator=(const NameDictionary&) = delete;
+
+    // fails on anything that isn't a dictionary or whose sections don't fit in the file
+    bool open(const std::string& path);
+
+    bool isOpen() const {
+        return mHeader != nullptr;
+    }
+
+    // empty if the hash isn't in the section
+    std::string_view findName(Section section, u32 hash) const;
+    std::optional<u32> findHash(Section section, std::string_view name) const;
+
+    u32 getCount(Section section) const;
+
+    // hash of everything besides the header, written by the builder
+    u64 getContentHash() const;
+
+    struct SectionHeader {
+        u32 count;
+        u32 hashesOffset;
+        u32 offsetsOffset; // count + 1 entries
+        u32 blobOffset;
+        u32 blobSize;
+    };
+
+    struct Header {
+        u32 magic;
+        u32 version;
+        u64 contentHash;
+        std::array<SectionHeader, static_cast<size_t>(Section::Count)> sections;
+    };
+
+    static constexpr u32 cMagic = 0x444e4c58; // XLND
+    static constexpr u32 cVersion = 2;
+
+private:
+    const u32* getArray(u32 offset) const {
+        return reinterpret_cast<const u32*>(mFile.data() + offset);
+    }
+
+    // index of the hash in the section's sorted hashes
+    std::optional<u32> findIndex(const SectionHeader& section, u32 hash) const;
+    // the name at index i in hash order, empty if its offsets are out of the blob
+    std::string_view getName(const SectionHeader& section, u32 index) const;
+
+    MappedFile mFile{};
+    const Header* mHeader = nullptr;
+};
+
+// collects names for a NameDictionary, the first name added for a hash is the one that's kept
+class NameDictionaryBuilder {
+public:
+    using Section = NameDictionary::Section;
+
+    void add(Section section, std::string_view name);
+
+    // one name per line under "Users:", "Keys:", "Properties:" or "Actions:" headers
+    // "ELink:" and "SLink:" count as users so UserNames.txt can be read as is, lines before any header are users too
+    void addList(std::string_view text);
+
+    std::vector<u8> build() const;
+
+    size_t getCount(Section section) const {
+        return mNames[static_cast<size_t>(section)].size();
+    }
+
+private:
+    std::array<std::map<u32, std::string>, static_cast<size_t>(Section::Count)> mNames{};
+};
+
+} // namespace util
@@ -2,14 +2,153 @@
 
 #include "util/types.h"
 
+#include <cstdio>
 #include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
 namespace util {
 
 bool loadFile(const std::string& path, std::vector<u8>& buffer);
 bool loadFileWithDecomp(const std::string& path, std::vector<u8>& buffer, const std::vector<std::vector<u8>>& dict = {});
+// reads through an InputStream, so zstd frames written without a content size (like OutputStream's) work too
+bool loadFileStreamed(const std::string& path, std::vector<u8>& buffer);
 void writeFile(const std::string& path, const std::span<const u8>& data, bool compress, const std::span<const u8>& dict = {});
 
-} // namespace util
\ No newline at end of file
+// memory maps a whole file read only
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const {
+        return mData != nullptr;
+    }
+
+    const u8* data() const {
+        return mData;
+    }
+
+    size_t size() const {
+        return mSize;
+    }
+
+    std::span<const u8> span() const {
+        return {mData, mSize};
+    }
+
+private:
+    u8* mData = nullptr;
+    size_t mSize = 0;
+#ifdef _WIN32
+    void* mFile = nullptr;
+    void* mMapping = nullptr;
+#else
+    int mFd = -1;
+#endif
+};
+
+// sequential writer for output that gets produced a piece at a time, optionally zstd compressing as it goes
+// nothing is held onto besides stdio's buffer and one compressed block so memory use doesn't depend on the output size
+class OutputStream {
+public:
+    OutputStream() = default;
+    ~OutputStream() {
+        close();
+    }
+
+    OutputStream(const OutputStream&) = delete;
+    OutputStream& operator=(const OutputStream&) = delete;
+
+    // "-" writes to stdout
+    bool open(const std::string& path, bool compress = false, s32 level = 3);
+    // the file stays owned by the caller, use fdopen to write to a raw fd
+    bool open(FILE* file, bool compress = false, s32 level = 3);
+    // finishes the zstd frame if there is one, returns false if any write along the way failed
+    bool close();
+
+    bool isOpen() const {
+        return mFile != nullptr;
+    }
+
+    void write(const void* data, size_t size);
+    void write(std::string_view data) {
+        write(data.data(), data.size());
+    }
+
+private:
+    bool initCompression(s32 level);
+    void writeCompressed(const void* data, size_t size, bool end);
+
+    FILE* mFile = nullptr;
+    bool mOwnsFile = false;
+    bool mFailed = false;
+    ZSTD_CCtx_s* mStream = nullptr;
+    std::vector<u8> mCompressBuffer{};
+};
+
+// sequential reader to go with OutputStream, input starting with the zstd magic is decompressed as it's read
+// only one block of compressed input is held at a time
+class InputStream {
+public:
+    InputStream() = default;
+    ~InputStream() {
+        close();
+    }
+
+    InputStream(const InputStream&) = delete;
+    InputStream& operator=(const InputStream&) = delete;
+
+    // "-" reads from stdin
+    bool open(const std::string& path);
+    // the file stays owned by the caller
+    bool open(FILE* file);
+    void close();
+
+    bool isOpen() const {
+        return mFile != nullptr;
+    }
+
+    bool isCompressed() const {
+        return mStream != nullptr;
+    }
+
+    bool hasFailed() const {
+        return mFailed;
+    }
+
+    // how much there is to read if that can be told up front, 0 otherwise
+    size_t getSizeHint() const {
+        return mSizeHint;
+    }
+
+    // fills as much of data as it can, returns 0 once everything has been read (or a read failed)
+    size_t read(void* data, size_t size);
+
+private:
+    bool fill();
+
+    FILE* mFile = nullptr;
+    bool mOwnsFile = false;
+    bool mFailed = false;
+    size_t mSizeHint = 0;
+    ZSTD_DCtx_s* mStream = nullptr;
+    std::vector<u8> mInputBuffer{};
+    size_t mInputPos = 0;
+    size_t mInputSize = 0;
+    bool mFrameEnded = false;
+};
+
+} // namespace util
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace util {
+
+// pieces of output keyed by a hash of whatever they were generated from, kept in one file so later runs can reuse them
+// lookups and stores are safe to make from several threads at once
+class FragmentCache {
+public:
+    FragmentCache() = default;
+
+    FragmentCache(const FragmentCache&) = delete;
+    FragmentCache& operator=(const FragmentCache&) = delete;
+
+    // context covers everything the keys don't, a file written under a different one is ignored
+    // a missing or unreadable file just means starting out empty
+    void load(const std::string& path, u64 context);
+    // only what was looked up or stored since load is written back, so entries nobody asks for anymore get dropped
+    bool save(const std::string& path) const;
+
+    // empty if there's nothing for key, the view stays valid as long as the cache does
+    std::string_view find(u64 key);
+    void store(u64 key, std::string fragment);
+
+private:
+    mutable std::mutex mMutex;
+    u64 mContext = 0;
+    std::unordered_map<u64, std::string> mPrevious{};
+    std::unordered_map<u64, std::string> mCurrent{};
+};
+
+} // namespace util
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <array>
+#include <string>
+
+namespace util {
+
+// streaming XXH64, output matches the reference implementation for the same input and seed
+class XXHash64 {
+public:
+    explicit XXHash64(u64 seed = 0) {
+        reset(seed);
+    }
+
+    void reset(u64 seed = 0);
+    void update(const void* data, size_t size);
+    u64 digest() const;
+
+private:
+    std::array<u64, 4> mAccumulators;
+    std::array<u8, 32> mBuffer;
+    size_t mBufferSize;
+    u64 mTotalSize;
+    u64 mSeed;
+};
+
+u64 calcXXHash64(const void* data, size_t size, u64 seed = 0);
+u64 calcXXHash64(const std::string_view str, u64 seed = 0);
+
+} // namespace util
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "util/types.h"
+#include "util/yaml_writer.h"
+
+#include <charconv>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace banana {
+
+// writes json with the same calls as YamlWriter so the dump functions can target either one
+// yaml tags don't have a json equivalent, so a tagged node is wrapped in an object with the tag as its only key
+// ({"!u": "0x1234"}) and a tagged key becomes "!u 0x1234", JsonReader's users are expected to undo that
+// scalars inside a wrapper are plain even when they have to be json strings, since the tag says what they are
+// layout hints (styles, widths) have nothing to do in json and anchors can't be written at all
+class JsonWriter {
+public:
+    JsonWriter() {
+        mOutput.reserve(0x10000);
+    }
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    using Sink = std::function<void(std::string_view)>;
+    void SetSink(Sink sink, size_t bufferSize = 0x40000) {
+        mSink = std::move(sink);
+        mBufferSize = bufferSize;
+    }
+
+    void Flush() {
+        if (mSink && !mOutput.empty()) {
+            mSink(mOutput);
+            mOutput.clear();
+        }
+    }
+
+    void EmitScalar(std::string_view value, bool plainImplicit, bool quotedImplicit, std::string_view tag = {});
+
+    void EmitNull() {
+        EmitScalar("null", true, false);
+    }
+
+    void EmitBool(bool v, std::string_view tag = "!!bool") {
+        EmitScalar(v ? "true" : "false", tag == "!!bool", false, tag);
+    }
+
+    void EmitFloat(float v, std::string_view tag = "!!float") {
+        char buf[32];
+        EmitScalar(FloatToChars(v, buf), tag == "!!float", false, tag);
+    }
+
+    template <typename T = int>
+    void EmitInt(T v, std::string_view tag = "!!int") {
+        char buf[24];
+        const auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        EmitScalar({buf, res.ptr}, tag == "!!int", false, tag);
+    }
+
+    void EmitHex(u32 v, std::string_view tag, u32 minDigits = 8) {
+        char buf[10];
+        EmitScalar(HexToChars(v, minDigits, buf), false, false, tag);
+    }
+
+    void EmitString(std::string_view v, std::string_view tag) {
+        EmitScalar(v, false, false, tag);
+    }
+    void EmitString(std::string_view v) {
+        EmitScalar(v, false, true);
+    }
+
+    // only here so the dump functions compile, nothing should be asking for aliases when writing json
+    void SetAnchor(std::string_view) {
+        throw std::runtime_error("Emit failed: json has no anchors");
+    }
+    void EmitAlias(std::string_view) {
+        throw std::runtime_error("Emit failed: json has no aliases");
+    }
+
+    void BeginMapping(std::string_view tag, YamlWriter::Style style);
+    void EndMapping();
+    void BeginSequence(std::string_view tag, YamlWriter::Style style);
+    void EndSequence();
+
+    struct MappingScope {
+        MappingScope(JsonWriter& writer_, std::string_view tag, YamlWriter::Style style) : writer(writer_) {
+            writer.BeginMapping(tag, style);
+        }
+        ~MappingScope() {
+            writer.EndMapping();
+        }
+
+    private:
+        JsonWriter& writer;
+    };
+
+    struct SequenceScope {
+        SequenceScope(JsonWriter& writer_, std::string_view tag, YamlWriter::Style style) : writer(writer_) {
+            writer.BeginSequence(tag, style);
+        }
+        ~SequenceScope() {
+            writer.EndSequence();
+        }
+
+    private:
+        JsonWriter& writer;
+    };
+
+    // starts the value of the key that was just emitted as an object made of preformatted members
+    // each call to WriteRaw afterwards adds one or more "key":value members, the object is closed by whatever comes next
+    void BeginRawValue();
+    void WriteRaw(std::string_view text);
+
+    // writes "key":value members with nothing around them, the output is meant to go into WriteRaw later on
+    // has to be the first thing written, EndFragment takes the place of Finish
+    void BeginFragment();
+    void EndFragment();
+
+    // ends the document, the root node has to be closed by now
+    void Finish();
+
+    std::string& GetOutput() {
+        return mOutput;
+    }
+    const std::string& GetOutput() const {
+        return mOutput;
+    }
+
+private:
+    struct Frame {
+        bool isMapping;
+        bool first;
+        bool expectValue;
+        bool isTagged; // closes the wrapper object as well
+        bool isRaw;
+        bool isFragment;
+    };
+
+    bool isKeyPosition() const {
+        return !mFrames.empty() && mFrames.back().isMapping && !mFrames.back().expectValue;
+    }
+
+    void beginNode();
+    void endNode();
+    void closeRaw();
+    void beginCollection(bool isMapping, std::string_view tag);
+    void endCollection(bool isMapping);
+    void writeEscaped(std::string_view value);
+
+    void flushIfFull() {
+        if (mSink && mOutput.size() >= mBufferSize) {
+            Flush();
+        }
+    }
+
+    std::string mOutput{};
+    Sink mSink{};
+    size_t mBufferSize = 0;
+    std::vector<Frame> mFrames{};
+};
+
+// pull parser for json, strings are unescaped in place so the text has to be writable and outlive the values
+class JsonReader {
+public:
+    enum class Event : u8 {
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Key,
+        String,
+        Literal, // numbers, true, false and null
+        End,
+    };
+
+    explicit JsonReader(std::span<char> text) : mPos(text.data()), mEnd(text.data() + text.size()) {}
+
+    JsonReader(const JsonReader&) = delete;
+    JsonReader& operator=(const JsonReader&) = delete;
+
+    Event Next();
+
+    // text of the last Key, String or Literal, only valid for as long as the buffer is
+    std::string_view Value() const {
+        return mValue;
+    }
+
+private:
+    enum class State : u8 {
+        Value,
+        FirstValue, // right after '[', so ']' is allowed
+        Key,
+        FirstKey, // right after '{', so '}' is allowed
+        AfterKey,
+        AfterValue,
+    };
+
+    [[noreturn]] void fail(std::string_view what) const;
+    void skipWhitespace();
+    Event readValue();
+    std::string_view readString();
+    std::string_view readNumber();
+    void expectWord(std::string_view word);
+
+    char* mPos;
+    char* mEnd;
+    char* mBegin = mPos;
+    std::string_view mValue{};
+    std::vector<bool> mStack{}; // true for objects
+    State mState = State::Value;
+};
+
+} // namespace banana
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+inline u32 getWorkerCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// calls func(i) for every i in [0, count) across the available cores, indices are handed out one at a time
+// the first exception thrown by any call is rethrown on the calling thread once every worker has stopped
+template <typename Func>
+void parallelFor(size_t count, Func&& func) {
+    const size_t workerCount = std::min<size_t>(getWorkerCount(), count);
+    if (workerCount <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    std::exception_ptr error = nullptr;
+    std::mutex errorMutex;
+
+    const auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                func(i);
+            } catch (...) {
+                std::lock_guard lock(errorMutex);
+                if (error == nullptr) {
+                    error = std::current_exception();
+                }
+                next = count; // no point continuing
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount - 1);
+    for (size_t i = 1; i < workerCount; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace util
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <cstdio>
 #include <optional>
 #include <span>
 #include <stdexcept>
@@ -31,32 +32,14 @@
 #include <ryml.hpp>
 #include <yaml.h>
 
+#include "util/crc32.h"
 #include "util/types.h"
 #include "util/type_utils.h"
 
 namespace banana {
 
-std::string FormatFloat(float value);
-std::string FormatDouble(double value);
-
-using Scalar = std::variant<std::nullptr_t, bool, u64, double, std::string>;
-
 bool StringNeedsQuotes(std::string_view value);
 
-enum class TagBasedType {
-  Bool,
-  Str,
-  Int,
-  Float,
-  Null,
-};
-using TagRecognizer = std::optional<TagBasedType> (*)(std::string_view tag);
-
-Scalar ParseScalar(std::string_view tag, std::string_view value, bool is_quoted,
-                   TagRecognizer recognizer);
-Scalar ParseScalar(const ryml::ConstNodeRef& node, TagRecognizer recognizer);
-Scalar ParseScalarKey(const ryml::ConstNodeRef& node, TagRecognizer recognizer);
-
 void InitRymlIfNeeded();
 
 inline std::string_view RymlSubstrToStrView(c4::csubstr str) {
@@ -78,49 +61,95 @@ inline const ryml::ConstNodeRef RymlGetMapItem(const ryml::ConstNodeRef& n, std:
   throw std::out_of_range("No such key: " + std::string(key));
 }
 
-inline std::optional<TagBasedType> RecognizeTag(const std::string_view tag) {
-    if (tag == "!u" || tag == "!bitfield")
-        return TagBasedType::Int;
-    return std::nullopt;
-}
+class ParseError final : public std::runtime_error {
+public:
+  ParseError() = delete;
+  using std::runtime_error::runtime_error;
+};
 
-inline Scalar ParseScalar(const ryml::ConstNodeRef& node) {
-    return ParseScalar(node, RecognizeTag);    
-}
+class RymlError final : public std::runtime_error {
+public:
+  RymlError() = delete;
+  using std::runtime_error::runtime_error;
+};
 
-template <typename T>
-const std::optional<T> ParseScalarAs(const ryml::ConstNodeRef& node) {
-    auto res = ParseScalar(node);
+// Typed decoders that work straight off the scalar text. These never allocate
+// (other than for the exception when the text isn't what was asked for).
+// Ints take decimal, 0x hex or 0 octal with an optional sign, negatives wrap around like strtoull.
+std::optional<u64> DecodeInt(std::string_view value);
+std::optional<f64> DecodeFloat(std::string_view value);
+std::optional<bool> DecodeBool(std::string_view value);
+
+// What an untagged plain scalar decodes to, monostate if it's just a string.
+using Number = std::variant<std::monostate, bool, u64, f64>;
+Number DecodeNumber(std::string_view value);
 
-    if (const T* val = std::get_if<T>(&res))
-      return *val;
-    return std::nullopt;
+// Quoted scalars are always strings.
+inline Number DecodeNumber(const ryml::ConstNodeRef& node) {
+  return node.is_val_quoted() ? Number{} : DecodeNumber(RymlSubstrToStrView(node.val()));
 }
 
-inline Scalar ParseScalarKey(const ryml::ConstNodeRef& node) {
-    return ParseScalarKey(node, RecognizeTag);    
+[[noreturn]] void ThrowDecodeError(std::string_view value, std::string_view type);
+
+template <typename T>
+T DecodeScalar(std::string_view value) {
+  if constexpr (std::is_same_v<T, u64>) {
+    if (const auto res = DecodeInt(value))
+      return *res;
+    ThrowDecodeError(value, "int");
+  } else if constexpr (std::is_same_v<T, f64>) {
+    if (const auto res = DecodeFloat(value))
+      return *res;
+    ThrowDecodeError(value, "float");
+  } else if constexpr (std::is_same_v<T, bool>) {
+    if (const auto res = DecodeBool(value))
+      return *res;
+    ThrowDecodeError(value, "bool");
+  } else if constexpr (std::is_same_v<T, std::string_view>) {
+    return value;
+  } else {
+    static_assert(util::AlwaysFalse<T>(), "Unsupported type!");
+  }
 }
 
 template <typename T>
-const std::optional<T> ParseScalarKeyAs(const ryml::ConstNodeRef& node) {
-    auto res = ParseScalarKey(node);
+T DecodeScalar(const ryml::ConstNodeRef& node) {
+  return DecodeScalar<T>(RymlSubstrToStrView(node.val()));
+}
 
-    if (const T* val = std::get_if<T>(&res))
-      return *val;
-    return std::nullopt;
+template <typename T>
+T DecodeScalarKey(const ryml::ConstNodeRef& node) {
+  return DecodeScalar<T>(RymlSubstrToStrView(node.key()));
 }
 
-class ParseError final : public std::runtime_error {
-public:
-  ParseError() = delete;
-  using std::runtime_error::runtime_error;
+// Every tag the exporter writes, as its crc32 so a node's tag only gets hashed once to be switched on.
+// No tag hashes to 0 since that's the crc32 of an empty string.
+enum class Tag : u32 {
+  None = 0,
+  U = util::calcCRC32Const("!u"),
+  Bitfield = util::calcCRC32Const("!bitfield"),
+  Unknown = util::calcCRC32Const("!unknown"),
+  Pdt = util::calcCRC32Const("!pdt"),
+  DirectValue = util::calcCRC32Const("!directValue"),
+  Curve = util::calcCRC32Const("!curve"),
+  Random = util::calcCRC32Const("!random"),
+  Random2 = util::calcCRC32Const("!random2"),
+  ArrangeGroupParam = util::calcCRC32Const("!arrangeGroupParam"),
+  I4 = util::calcCRC32Const("!i4"),
+  F5 = util::calcCRC32Const("!f5"),
+  Switch = util::calcCRC32Const("!switch"),
+  Blend = util::calcCRC32Const("!blend"),
+  Sequence = util::calcCRC32Const("!sequence"),
+  Grid = util::calcCRC32Const("!grid"),
+  Jump = util::calcCRC32Const("!jump"),
 };
 
-class RymlError final : public std::runtime_error {
-public:
-  RymlError() = delete;
-  using std::runtime_error::runtime_error;
-};
+inline Tag RymlGetValTagId(const ryml::ConstNodeRef& n) {
+  return static_cast<Tag>(util::calcCRC32(RymlGetValTag(n)));
+}
+inline Tag RymlGetKeyTagId(const ryml::ConstNodeRef& n) {
+  return static_cast<Tag>(util::calcCRC32(RymlGetKeyTag(n)));
+}
 
 class LibyamlParser {
 public:
@@ -128,7 +157,21 @@ public:
     yaml_parser_initialize(&m_parser);
     yaml_parser_set_input_string(&m_parser, data.data(), data.size());
   }
-  ~LibyamlParser() { yaml_parser_delete(&m_parser); }
+  // reads the file in small chunks as events are requested instead of loading it up front
+  LibyamlParser(std::FILE* file) {
+    yaml_parser_initialize(&m_parser);
+    yaml_parser_set_input_file(&m_parser, file);
+  }
+  // handler gets called with data whenever the parser wants more input
+  LibyamlParser(yaml_read_handler_t* handler, void* data) {
+    yaml_parser_initialize(&m_parser);
+    yaml_parser_set_input(&m_parser, handler, data);
+  }
+  ~LibyamlParser() {
+    if (m_has_event)
+      yaml_event_delete(&m_event);
+    yaml_parser_delete(&m_parser);
+  }
   LibyamlParser(const LibyamlParser&) = delete;
   LibyamlParser& operator=(const LibyamlParser&) = delete;
   operator yaml_parser_t*() { return &m_parser; }
@@ -148,142 +191,24 @@ public:
     }
   }
 
-private:
-  yaml_parser_t m_parser;
-};
-
-class LibyamlEmitter {
-public:
-  LibyamlEmitter();
-  ~LibyamlEmitter();
-  LibyamlEmitter(const LibyamlEmitter&) = delete;
-  LibyamlEmitter& operator=(const LibyamlEmitter&) = delete;
-  operator yaml_emitter_t*() { return &m_emitter; }
-
-  void Emit(yaml_event_t& event, bool ignore_errors = false);
-
-  void EmitScalar(std::string_view value, bool plain_implicit, bool quoted_implicit,
-                  std::string_view tag = {}) {
-    yaml_event_t event;
-    const auto style = value.empty() ? YAML_SINGLE_QUOTED_SCALAR_STYLE : YAML_ANY_SCALAR_STYLE;
-    yaml_scalar_event_initialize(&event, nullptr, tag.empty() ? nullptr : (const u8*)tag.data(),
-                                 (const u8*)value.data(), value.size(), plain_implicit,
-                                 quoted_implicit, style);
-    Emit(event);
-  }
-
-  void EmitNull() { EmitScalar("null", true, false); }
-  void EmitBool(bool v, std::string_view tag = "!!bool") {
-    EmitScalar(v ? "true" : "false", true, false, tag);
-  }
-  void EmitFloat(float v, std::string_view tag = "!!float") {
-    EmitScalar(FormatFloat(v), true, false, tag);
-  }
-  void EmitDouble(double v, std::string_view tag = "!f64") {
-    EmitScalar(FormatDouble(v), false, false, tag);
-  }
-  template <typename T = int>
-  void EmitInt(T v, std::string_view tag = "!!int") {
-    EmitScalar(std::to_string(v), tag == "!!int", false, tag);
-  }
-  void EmitString(std::string_view v, std::string_view tag) { EmitScalar(v, false, false, tag); }
-  void EmitString(std::string_view v) { EmitScalar(v, !StringNeedsQuotes(v), true); }
-
-  /// Emits an inline sequence of bools, ints or floats.
-  template <typename T>
-  void EmitSimpleSequence(std::span<const T> sequence, std::string_view sequence_tag = {}) {
-    yaml_event_t event;
-    yaml_sequence_start_event_initialize(&event, nullptr, (const u8*)sequence_tag.data(),
-                                         sequence_tag.empty(), YAML_FLOW_SEQUENCE_STYLE);
-    Emit(event);
-    for (const T& v : sequence) {
-      if constexpr (std::is_same_v<T, bool>)
-        EmitBool(v);
-      else if constexpr (std::is_same_v<T, double>)
-        EmitDouble(v);
-      else if constexpr (std::is_same_v<T, float>)
-        EmitFloat(v);
-      else if constexpr (std::is_integral_v<T>)
-        EmitInt(v);
-      else
-        static_assert(util::AlwaysFalse<T>(), "Unsupported type!");
+  // pull style alternative to Parse, the returned event is only valid until the next call
+  const yaml_event_t& Next() {
+    if (m_has_event) {
+      yaml_event_delete(&m_event);
+      m_has_event = false;
     }
-    yaml_sequence_end_event_initialize(&event);
-    Emit(event);
+    if (!yaml_parser_parse(&m_parser, &m_event))
+      throw ParseError("yaml_parser_parse failed");
+    m_has_event = true;
+    return m_event;
   }
 
-  template <typename T>
-  void EmitSimpleSequence(std::initializer_list<T> l, std::string_view tag = {}) {
-    EmitSimpleSequence(std::span<const T>(l.begin(), l.end()), tag);
-  }
-
-  template <typename... Ts>
-  void EmitSimpleSequence(const std::tuple<Ts...>& tuple, std::string_view tag = {}) {
-    std::apply([&](auto&&... args) { EmitSimpleSequence({args...}, tag); }, tuple);
-  }
-
-  struct MappingScope {
-    MappingScope(LibyamlEmitter& emitter_, std::string_view tag, yaml_mapping_style_t style)
-        : emitter{emitter_} {
-      yaml_event_t event;
-      yaml_mapping_start_event_initialize(&event, nullptr, (const u8*)tag.data(),
-                                          tag.empty() ? 1 : 0, style);
-      emitter.Emit(event);
-    }
-
-    ~MappingScope() {
-      yaml_event_t event;
-      yaml_mapping_end_event_initialize(&event);
-      // Ignore errors here because this shouldn't throw...
-      emitter.Emit(event, true);
-    }
-
-  private:
-    LibyamlEmitter& emitter;
-  };
-
-  struct SequenceScope {
-    SequenceScope(LibyamlEmitter& emitter_, std::string_view tag, yaml_sequence_style_t style)
-      : emitter{emitter_} {
-        yaml_event_t event;
-        yaml_sequence_start_event_initialize(&event, nullptr, (const u8*)tag.data(),
-                                             tag.empty() ? 1 : 0, style);
-        emitter.Emit(event);
-      }
-
-    ~SequenceScope() {
-      yaml_event_t event;
-      yaml_sequence_end_event_initialize(&event);
-      emitter.Emit(event, true);
-    }
-    
-  private:
-    LibyamlEmitter& emitter;
-  };
-
-protected:
-  yaml_emitter_t m_emitter;
-};
-
-template <typename Container>
-class LibyamlEmitterWithStorage : public LibyamlEmitter {
-public:
-  LibyamlEmitterWithStorage() : LibyamlEmitter{} {
-    const auto write_handler = [](void* userdata, u8* buffer, size_t size) {
-      auto* self = static_cast<LibyamlEmitterWithStorage*>(userdata);
-      self->m_output.insert(self->m_output.end(), (char*)buffer, (char*)buffer + size);
-      return 1;
-    };
-    yaml_emitter_set_output(&m_emitter, write_handler, this);
-  }
-
-  ~LibyamlEmitterWithStorage() = default;
-
-  Container& GetOutput() { return m_output; }
-  const Container& GetOutput() const { return m_output; }
+  const yaml_event_t& Current() const { return m_event; }
 
 private:
-  Container m_output;
+  yaml_parser_t m_parser;
+  yaml_event_t m_event;
+  bool m_has_event = false;
 };
 
 }  // namespace banana
\ No newline at end of file
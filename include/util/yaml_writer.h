@@ -0,0 +1,211 @@
+#pragma once
+
+#include "util/types.h"
+
+#include <charconv>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace banana {
+
+// the text EmitFloat and EmitHex write, the result points into buf
+std::string_view FloatToChars(float v, char (&buf)[32]);
+// 0x prefixed lowercase hex zero padded to minDigits, same as {:#0Nx}
+std::string_view HexToChars(u32 v, u32 minDigits, char (&buf)[10]);
+
+// writes yaml text directly instead of going through libyaml's event queue
+// the output matches what libyaml's emitter produces for the same calls (same quoting, indentation and line folding)
+// block scalars and non-scalar keys aren't supported since the exporter never uses them
+class YamlWriter {
+public:
+    enum Style {
+        Block,
+        Flow,
+    };
+
+    YamlWriter() {
+        mOutput.reserve(0x10000);
+    }
+
+    YamlWriter(const YamlWriter&) = delete;
+    YamlWriter& operator=(const YamlWriter&) = delete;
+
+    // folding column for long scalars and flow collections
+    void SetWidth(s32 width) {
+        mWidth = width;
+    }
+
+    // hands the output off to sink whenever more than bufferSize bytes have built up instead of keeping the whole document
+    // whatever's left over gets passed along by Finish (or Flush)
+    using Sink = std::function<void(std::string_view)>;
+    void SetSink(Sink sink, size_t bufferSize = 0x40000) {
+        mSink = std::move(sink);
+        mBufferSize = bufferSize;
+    }
+
+    void Flush() {
+        if (mSink && !mOutput.empty()) {
+            mSink(mOutput);
+            mOutput.clear();
+        }
+    }
+
+    void EmitScalar(std::string_view value, bool plainImplicit, bool quotedImplicit, std::string_view tag = {});
+
+    void EmitNull() {
+        EmitScalar("null", true, false);
+    }
+
+    // the default tags are implicit, anything else is written out
+    void EmitBool(bool v, std::string_view tag = "!!bool") {
+        EmitScalar(v ? "true" : "false", tag == "!!bool", false, tag);
+    }
+
+    void EmitFloat(float v, std::string_view tag = "!!float");
+
+    template <typename T = int>
+    void EmitInt(T v, std::string_view tag = "!!int") {
+        char buf[24];
+        const auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        EmitScalar({buf, res.ptr}, tag == "!!int", false, tag);
+    }
+
+    // 0x prefixed lowercase hex zero padded to minDigits, same as {:#0Nx}
+    void EmitHex(u32 v, std::string_view tag, u32 minDigits = 8);
+
+    void EmitString(std::string_view v, std::string_view tag) {
+        EmitScalar(v, false, false, tag);
+    }
+    void EmitString(std::string_view v);
+
+    // the next node written gets this anchor, the name has to stick to letters, digits, '_' and '-'
+    void SetAnchor(std::string_view name) {
+        mAnchor = name;
+    }
+    void EmitAlias(std::string_view name);
+
+    void BeginMapping(std::string_view tag, Style style);
+    void EndMapping();
+    void BeginSequence(std::string_view tag, Style style);
+    void EndSequence();
+
+    struct MappingScope {
+        MappingScope(YamlWriter& writer_, std::string_view tag, Style style) : writer(writer_) {
+            writer.BeginMapping(tag, style);
+        }
+        ~MappingScope() {
+            writer.EndMapping();
+        }
+
+    private:
+        YamlWriter& writer;
+    };
+
+    struct SequenceScope {
+        SequenceScope(YamlWriter& writer_, std::string_view tag, Style style) : writer(writer_) {
+            writer.BeginSequence(tag, style);
+        }
+        ~SequenceScope() {
+            writer.EndSequence();
+        }
+
+    private:
+        YamlWriter& writer;
+    };
+
+    // starts the value of the key that was just emitted in a block mapping as preformatted text
+    // everything passed to WriteRaw afterwards has to be already indented for that level and end in a newline
+    void BeginRawValue();
+    void WriteRaw(std::string_view text);
+
+    // ends the document, the root node has to be closed by now
+    void Finish();
+
+    std::string& GetOutput() {
+        return mOutput;
+    }
+    const std::string& GetOutput() const {
+        return mOutput;
+    }
+
+private:
+    enum class Kind : u8 {
+        BlockMapping,
+        BlockSequence,
+        FlowMapping,
+        FlowSequence,
+    };
+
+    struct Frame {
+        Kind kind;
+        bool isMapping;
+        bool isOpen; // collections aren't opened until the first item shows up so empty ones can be written as {} or []
+        bool isFlow;
+        bool first;
+        bool expectValue;
+        bool simpleKey;
+        bool mappingContext; // context the collection itself was written in
+    };
+
+    struct ScalarAnalysis {
+        bool multiline;
+        bool flowPlainAllowed;
+        bool blockPlainAllowed;
+        bool singleQuotedAllowed;
+    };
+
+    static ScalarAnalysis analyzeScalar(std::string_view value);
+
+    void beginNode(bool isScalar, size_t keyLength, bool multiline);
+    void endNode();
+    void openPending();
+    void beginCollection(bool isMapping, std::string_view tag, Style style);
+    void endCollection(bool isMapping);
+
+    void increaseIndent(bool flow, bool indentless);
+    void writeIndent();
+    void writeIndicator(std::string_view indicator, bool needWhitespace, bool isWhitespace, bool isIndention);
+    void writeTag(std::string_view tag);
+    void writeAnchor();
+    void writePlain(std::string_view value, bool allowBreaks);
+    void writeSingleQuoted(std::string_view value, bool allowBreaks);
+    void writeDoubleQuoted(std::string_view value, bool allowBreaks);
+    void writeChar(std::string_view& value);
+    void writeBreak(std::string_view& value);
+
+    void flushIfFull() {
+        if (mSink && mOutput.size() >= mBufferSize) {
+            Flush();
+        }
+    }
+
+    void put(char c) {
+        mOutput.push_back(c);
+        ++mColumn;
+    }
+
+    void putBreak() {
+        mOutput.push_back('\n');
+        mColumn = 0;
+    }
+
+    std::string mOutput{};
+    Sink mSink{};
+    std::string mAnchor{};
+    size_t mBufferSize = 0;
+    std::vector<Frame> mFrames{};
+    std::vector<s32> mIndents{};
+    s32 mIndent = -1;
+    s32 mColumn = 0;
+    s32 mWidth = 120;
+    s32 mFlowLevel = 0;
+    bool mWhitespace = true;
+    bool mIndention = true;
+    // context of the node currently being written
+    bool mMappingContext = false;
+    bool mSimpleKeyContext = false;
+};
+
+} // namespace banana
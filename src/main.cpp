@@ -1,9 +1,21 @@
+#include "util/crc32.h"
+#include "util/dictionary.h"
 #include "util/file.h"
+#include "util/fragment_cache.h"
+#include "util/hash.h"
 #include "util/sarc.h"
+#include "patcher.h"
 #include "system.h"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
 #include <cstring>
+#include <filesystem>
+#include <format>
 #include <iostream>
+#include <optional>
+#include <set>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -11,24 +23,330 @@
 
 #define MAX_FILEPATH 0x1000
 
-static std::string parseInput(int argc, char** argv, s32 index) {
+static std::vector<std::string> sArguments{};
+static std::set<std::string, std::less<>> sFlags{};
+
+// anything after the option starting with -- is a flag, everything else is positional
+static void parseArguments(int argc, char** argv) {
+    for (s32 i = 1; i < argc; ++i) {
+        size_t size = strnlen(argv[i], MAX_FILEPATH);
+        std::string value{argv[i], argv[i] + size};
+        if (i > 1 && value.starts_with("--")) {
+            sFlags.emplace(std::move(value));
+        } else {
+            sArguments.emplace_back(std::move(value));
+        }
+    }
+}
+
+static std::string parseInput(s32 index) {
     static std::string null_string;
 
-    if (argc < 2 + index) {
+    if (sArguments.size() < 1 + static_cast<size_t>(index)) {
         return null_string;
     }
 
-    size_t size = strnlen(argv[1 + index], MAX_FILEPATH);
-    std::string value{argv[1 + index], argv[1 + index] + size};
+    return sArguments[index];
+}
+
+static bool hasFlag(const std::string_view flag) {
+    return sFlags.contains(flag);
+}
+
+// values of every --flag=a,b,c given, split on commas
+static std::vector<std::string> getFlagValues(const std::string_view flag) {
+    std::vector<std::string> values{};
+    for (const auto& entry : sFlags) {
+        if (!entry.starts_with(flag) || entry.size() <= flag.size() || entry[flag.size()] != '=') {
+            continue;
+        }
+        std::string_view list = std::string_view(entry).substr(flag.size() + 1);
+        while (!list.empty()) {
+            const size_t end = std::min(list.find(','), list.size());
+            if (end != 0) {
+                values.emplace_back(list.substr(0, end));
+            }
+            list.remove_prefix(std::min(end + 1, list.size()));
+        }
+    }
+    return values;
+}
+
+// the hex digits after 0x, nothing if there's anything else in there or it doesn't fit in 32 bits
+static std::optional<u32> parseHash(const std::string_view text) {
+    const std::string_view digits = text.substr(2);
+    u32 value = 0;
+    const auto res = std::from_chars(digits.data(), digits.data() + digits.size(), value, 16);
+    if (digits.empty() || res.ec != std::errc() || res.ptr != digits.data() + digits.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// users given by name or as a 0x prefixed hash, nothing if one of the hashes is malformed
+static std::optional<std::set<u32>> getUserFilter() {
+    std::set<u32> users{};
+    for (const auto& user : getFlagValues("--user")) {
+        if (user.starts_with("0x") || user.starts_with("0X")) {
+            const auto hash = parseHash(user);
+            if (!hash) {
+                std::cerr << "Invalid user hash " << user << "\n";
+                return std::nullopt;
+            }
+            users.insert(*hash);
+        } else {
+            users.insert(util::calcCRC32(user));
+        }
+    }
+    return users;
+}
+
+// a whole number or float with nothing left over
+template <typename T>
+static std::optional<T> parseNumber(const std::string_view text) {
+    T value{};
+    const auto res = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || res.ec != std::errc() || res.ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
     return value;
 }
 
+// comma separated numbers, nothing unless there's exactly N of them
+template <typename T, size_t N>
+static std::optional<std::array<T, N>> parseNumbers(std::string_view text) {
+    std::array<T, N> values{};
+    for (size_t i = 0; i < N; ++i) {
+        const size_t end = i + 1 == N ? text.size() : text.find(',');
+        if (end == std::string_view::npos) {
+            return std::nullopt;
+        }
+        const auto value = parseNumber<T>(text.substr(0, end));
+        if (!value) {
+            return std::nullopt;
+        }
+        values[i] = *value;
+        text.remove_prefix(std::min(end + 1, text.size()));
+    }
+    return values;
+}
+
+// one --patch edit, target:index=values (see the help text for the targets)
+static bool applyPatch(banana::ResourcePatcher& patcher, const std::string_view edit) {
+    const size_t colon = edit.find(':');
+    const size_t equals = edit.find('=');
+    if (colon == std::string_view::npos || equals == std::string_view::npos || equals < colon) {
+        return false;
+    }
+    const std::string_view target = edit.substr(0, colon);
+    const std::string_view index = edit.substr(colon + 1, equals - colon - 1);
+    const std::string_view value = edit.substr(equals + 1);
+
+    // curves and triggers have a second index after a dot
+    if (target == "curve") {
+        const size_t dot = index.find('.');
+        const auto curve = parseNumber<s32>(index.substr(0, dot));
+        const auto point = dot == std::string_view::npos ? std::nullopt : parseNumber<s32>(index.substr(dot + 1));
+        const auto v = parseNumbers<f32, 2>(value);
+        return curve && point && v && patcher.setCurvePoint(*curve, *point, (*v)[0], (*v)[1]);
+    }
+    if (target == "frames") {
+        const size_t dot = index.rfind('.');
+        const std::string_view user = index.substr(0, dot);
+        const auto hash = user.starts_with("0x") || user.starts_with("0X") ? parseHash(user) : util::calcCRC32(user);
+        const auto trigger = dot == std::string_view::npos ? std::nullopt : parseNumber<s32>(index.substr(dot + 1));
+        const auto v = parseNumbers<s32, 2>(value);
+        return hash && trigger && v && patcher.setActionTriggerFrames(*hash, *trigger, (*v)[0], (*v)[1]);
+    }
+
+    const auto i = parseNumber<s32>(index);
+    if (!i) {
+        return false;
+    }
+    if (target == "s32" || target == "switch.s32") {
+        const auto v = parseNumber<s32>(value);
+        return v && (target == "s32" ? patcher.setDirectValueS32(*i, *v) : patcher.setSwitchConditionS32(*i, *v));
+    }
+    if (target == "u32") {
+        const auto v = parseNumber<u32>(value);
+        return v && patcher.setDirectValueU32(*i, *v);
+    }
+    if (target == "f32" || target == "switch.f32" || target == "weight") {
+        const auto v = parseNumber<f32>(value);
+        if (!v) {
+            return false;
+        }
+        if (target == "f32") {
+            return patcher.setDirectValueF32(*i, *v);
+        }
+        return target == "weight" ? patcher.setRandomConditionWeight(*i, *v) : patcher.setSwitchConditionF32(*i, *v);
+    }
+    if (target == "random" || target == "blend") {
+        const auto v = parseNumbers<f32, 2>(value);
+        if (!v) {
+            return false;
+        }
+        return target == "random" ? patcher.setRandomCall(*i, (*v)[0], (*v)[1]) : patcher.setBlendConditionRange(*i, (*v)[0], (*v)[1]);
+    }
+    return false;
+}
+
+static banana::DumpOptions getDumpOptions() {
+    banana::DumpOptions options{};
+    options.inlineDirectValues = hasFlag("--inline-values");
+    options.compact = hasFlag("--compact");
+    for (auto& section : getFlagValues("--section")) {
+        options.sections.emplace(std::move(section));
+    }
+    return options;
+}
+
+// --names=path maps a dictionary written by --build-names, it stays open until the program exits
+static bool openNameDictionary(banana::System& sys) {
+    static util::NameDictionary names;
+    const auto paths = getFlagValues("--names");
+    if (paths.empty()) {
+        return true;
+    }
+    if (!names.isOpen() && !names.open(paths.front())) {
+        return false;
+    }
+    sys.setNameDictionary(&names);
+    return true;
+}
+
+// with --user only those users are decoded, and the pools get cut down to what they use and renumbered
+static bool initializeForExport(banana::System& sys, std::vector<u8>& buffer, const std::set<u32>& users) {
+    if (!sys.initialize(buffer.data(), buffer.size(), users) || !openNameDictionary(sys)) {
+        return false;
+    }
+    if (!users.empty()) {
+        sys.eliminateDeadEntries();
+    }
+    return true;
+}
+
+// json instead of yaml with --json or a .json (.json.zst) path
+static bool wantsJSON(const std::string& path) {
+    return hasFlag("--json") || path.ends_with(".json") || path.ends_with(".json.zst");
+}
+
+// streams the yaml straight to the output file so the whole document never has to be in memory at once
+static bool exportYAML(const banana::System& sys, const std::string& path) {
+    auto options = getDumpOptions();
+
+    // users that haven't changed since the last export with --cache are copied out of <output>.cache
+    util::FragmentCache cache;
+    const std::string cachePath = path + ".cache";
+    const bool useCache = hasFlag("--cache") && path != "-";
+    if (useCache) {
+        cache.load(cachePath, sys.getFragmentContext(options));
+        options.fragmentCache = &cache;
+    }
+    const auto saveCache = [&]() {
+        if (useCache && !cache.save(cachePath)) {
+            std::cerr << "Failed to write fragment cache!\n";
+        }
+    };
+
+    const bool json = wantsJSON(path);
+    if (hasFlag("--split")) {
+        if (json) {
+            std::cerr << "Split exports are yaml only!\n";
+            return false;
+        }
+        const bool result = sys.dumpYAMLSplit(path, options);
+        if (result) {
+            saveCache();
+        }
+        return result;
+    }
+
+    util::OutputStream output;
+    if (!output.open(path, hasFlag("--compress") || path.ends_with(".zst"))) {
+        std::cerr << "Failed to open output file!\n";
+        return false;
+    }
+
+    const auto sink = [&output](std::string_view text) { output.write(text); };
+    if (json) {
+        banana::JsonWriter writer;
+        writer.SetSink(sink);
+        sys.dumpJSON(writer, options);
+    } else {
+        banana::YamlWriter writer;
+        writer.SetSink(sink);
+        sys.dumpYAML(writer, options);
+    }
+
+    if (!output.close()) {
+        std::cerr << "Failed to write output file!\n";
+        return false;
+    }
+    saveCache();
+    return true;
+}
+
+static bool loadYAMLFile(banana::System& sys, const std::string& path) {
+    // zstd compressed yaml is picked up by its magic, not the extension
+    const bool json = wantsJSON(path);
+    if (json || !hasFlag("--stream")) {
+        std::vector<u8> buffer{};
+        if (!util::loadFileStreamed(path, buffer)) {
+            std::cerr << "Failed to read input file!\n";
+            return false;
+        }
+        return json ? sys.loadJSON(std::move(buffer)) : sys.loadYAML(std::move(buffer));
+    }
+
+    util::InputStream input;
+    if (!input.open(path)) {
+        std::cerr << "Failed to open input file!\n";
+        return false;
+    }
+    return sys.loadYAMLStream(input);
+}
+
+static bool importYAML(banana::System& sys, const std::string& path) {
+    // directories are whatever --export --split wrote out
+    if (std::filesystem::is_directory(path)) {
+        return sys.loadYAMLSplit(path);
+    }
+    if (!hasFlag("--snapshot")) {
+        return loadYAMLFile(sys, path);
+    }
+
+    // the decoded model is kept next to the yaml and reused for as long as the yaml stays the same
+    // hashing the raw file is a lot cheaper than parsing it and isn't fooled by timestamps
+    util::MappedFile source;
+    if (!source.open(path)) {
+        std::cerr << "Failed to open input file!\n";
+        return false;
+    }
+    const u64 sourceHash = util::calcXXHash64(source.data(), source.size());
+    source.close();
+
+    const std::string snapshotPath = path + ".xlmc";
+    if (sys.loadSnapshot(snapshotPath, sourceHash)) {
+        return true;
+    }
+    if (!loadYAMLFile(sys, path)) {
+        return false;
+    }
+    if (!sys.saveSnapshot(snapshotPath, sourceHash)) {
+        std::cerr << "Failed to write snapshot!\n";
+    }
+    return true;
+}
+
 int main(int argc, char** argv) {
 #ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
 #endif
 
-    const std::string opt = parseInput(argc, argv, 0);
+    parseArguments(argc, argv);
+
+    const std::string opt = parseInput(0);
 
     if (opt.empty() || opt == "-h" || opt == "--help") {
         constexpr std::string_view helpMessage = \
@@ -38,24 +356,57 @@ int main(int argc, char** argv) {
         "Converting XLNK to YAML (final option is optional, include if decompression is desired)\n"
         "  r--export [path_to_xlink_file] [output_yaml_path] [path_to_zsdic_pack]\n"
         "Converting YAML to XLNK (final option is optional, include if compression is desired)\n"
-        "  --import [path_to_yaml] [output_xlink_path] [path_to_zsdic_pack]";
+        "  --import [path_to_yaml] [output_xlink_path] [path_to_zsdic_pack]\n"
+        "Applying a YAML containing only modified users and pool entries on top of an XLNK\n"
+        "  --overlay [path_to_xlink_file] [path_to_overlay_yaml] [output_xlink_path] [path_to_zsdic_pack]\n"
+        "Editing values in an uncompressed XLNK in place, the edits are target:index=values with these targets\n"
+        "  s32, u32, f32 (DirectValues), random (RandomCalls, min,max), curve (Curves, curve.point=x,y),\n"
+        "  switch.s32, switch.f32, blend (min,max), weight (Conditions), frames (user.trigger=start,end)\n"
+        "  --patch [path_to_xlink_file] [output_xlink_path] [edits...]\n"
+        "Flags (--export)\n"
+        "  --compress       zstd compress the yaml as it's written (implied by a .zst output path), - writes to stdout\n"
+        "  --split          output path is a directory, each user gets its own file next to a manifest\n"
+        "  --inline-values  write direct values where they're used instead of as indices into DirectValues\n"
+        "  --user=a,b       only export these users (names or 0x hashes) and the pool entries they use\n"
+        "  --section=a,b    only export these sections, e.g. Curves or AssetCallTables (for reading, can't be imported)\n"
+        "  --cache          keep each user's yaml in [output].cache and reuse it for users unchanged on the next export\n"
+        "  --compact        flow style for small records and aliases for repeated param sets and arrange groups\n"
+        "  --json           write json with the same layout as the yaml (implied by a .json output path)\n"
+        "  --names=path     also look up user names in a dictionary written by --build-names\n"
+        "Flags (--import, pass the directory itself to import a --split export, zstd compressed yaml is read as is)\n"
+        "  --json           the input is json written by --export --json (implied by a .json input path)\n"
+        "  --stream         read the yaml a piece at a time to keep memory use down on very large files (not for json)\n"
+        "  --snapshot       keep the decoded yaml in [path_to_yaml].xlmc and load that instead while the yaml is unchanged\n"
+        "Flags (--import and --roundtrip)\n"
+        "  --optimize       strip unreferenced data and merge duplicate pool entries before serializing\n"
+        "  --incremental    (--roundtrip only) reuse the original bytes of anything that wasn't modified\n"
+        "Building a name dictionary from name lists (.txt, names under Users:/Keys:/Properties:/Actions: lines)\n"
+        "and the names found in uncompressed XLNK files\n"
+        "  --build-names [output_path] [inputs...]\n"
+        "Looking up names or 0x hashes in a dictionary, the section is users, keys, properties or actions\n"
+        "  --lookup [path_to_dictionary] [section] [names_or_hashes...]";
         std::cout << helpMessage;
     } else if (opt == "--export" || opt == "-e") {
-        const std::string filepath = parseInput(argc, argv, 1);
-        const std::string outputPath = parseInput(argc, argv, 2);
-        const std::string dictPath = parseInput(argc, argv, 3);
+        const std::string filepath = parseInput(1);
+        const std::string outputPath = parseInput(2);
+        const std::string dictPath = parseInput(3);
+        const auto users = getUserFilter();
+        if (!users) {
+            return 1;
+        }
 
         if (dictPath.empty()) {
             std::vector<u8> buffer{};
             util::loadFile(filepath, buffer);
 
             banana::System sys;
-            if (!sys.initialize(buffer.data(), buffer.size())) {
+            if (!initializeForExport(sys, buffer, *users)) {
                 std::cerr << "Failed to parse file!\n";
                 return 1;
             }
-            const std::string text = sys.dumpYAML();
-            util::writeFile(outputPath, {reinterpret_cast<const u8*>(text.data()), text.size()}, false);
+            if (!exportYAML(sys, outputPath)) {
+                return 1;
+            }
         } else {
             util::Archive archive;
             if (!archive.loadArchive(dictPath)) {
@@ -77,29 +428,32 @@ int main(int argc, char** argv) {
             }
 
             banana::System sys;
-            if (!sys.initialize(buffer.data(), buffer.size())) {
+            if (!initializeForExport(sys, buffer, *users)) {
                 std::cerr << "Failed to parse file!\n";
                 return 1;
             }
 
-            auto text = sys.dumpYAML();
-            util::writeFile(outputPath, {reinterpret_cast<const u8*>(text.data()), text.size()}, false);
+            if (!exportYAML(sys, outputPath)) {
+                return 1;
+            }
         }
     } else if (opt == "--import" || opt == "-i") {
-        const std::string filepath = parseInput(argc, argv, 1);
-        const std::string outputPath = parseInput(argc, argv, 2);
-        const std::string dictPath = parseInput(argc, argv, 3);
+        const std::string filepath = parseInput(1);
+        const std::string outputPath = parseInput(2);
+        const std::string dictPath = parseInput(3);
 
         if (dictPath.empty()) {
-            std::vector<u8> buffer{};
-            util::loadFile(filepath, buffer);
-
             banana::System sys;
-            if (!sys.loadYAML({reinterpret_cast<char*>(buffer.data()), buffer.size()})) {
+            if (!importYAML(sys, filepath)) {
                 std::cerr << "Failed to parse file!\n";
                 return 1;
             }
 
+            if (hasFlag("--optimize")) {
+                sys.eliminateDeadEntries();
+                sys.canonicalize();
+            }
+
             const auto data = sys.serialize();
             util::writeFile(outputPath, {data.data(), data.size()}, false);
         } else {
@@ -111,23 +465,76 @@ int main(int argc, char** argv) {
 
             const auto dictData = archive.getFile("zs.zsdic");
 
-            std::vector<u8> buffer{};
-            util::loadFile(filepath, buffer);
-
             banana::System sys;
-            if (!sys.loadYAML({reinterpret_cast<char*>(buffer.data()), buffer.size()})) {
+            if (!importYAML(sys, filepath)) {
                 std::cerr << "Failed to parse file!\n";
                 return 1;
             }
 
+            if (hasFlag("--optimize")) {
+                sys.eliminateDeadEntries();
+                sys.canonicalize();
+            }
+
             const auto data = sys.serialize();
             const std::span<const u8> dict = {dictData.data(), dictData.size()};
             util::writeFile(outputPath, {data.data(), data.size()}, true, dict);
         }
+    } else if (opt == "--overlay") {
+        const std::string filepath = parseInput(1);
+        const std::string overlayPath = parseInput(2);
+        const std::string outputPath = parseInput(3);
+        const std::string dictPath = parseInput(4);
+
+        std::vector<u8> buffer{};
+        std::vector<u8> dictData{};
+        if (dictPath.empty()) {
+            util::loadFile(filepath, buffer);
+        } else {
+            util::Archive archive;
+            if (!archive.loadArchive(dictPath)) {
+                std::cerr << "failed to load dictionaries!\n";
+                return 1;
+            }
+
+            auto filenames = archive.getFilenames();
+            std::vector<std::vector<u8>> dicts(filenames.size());
+            for (u32 i = 0; const auto& filename : filenames) {
+                dicts[i] = archive.getFile(filename);
+                ++i;
+            }
+            dictData = archive.getFile("zs.zsdic");
+
+            if (!util::loadFileWithDecomp(filepath, buffer, dicts)) {
+                std::cerr << "failed to load file!\n";
+                return 1;
+            }
+        }
+
+        banana::System sys;
+        if (!sys.initialize(buffer.data(), buffer.size(), {}, true)) {
+            std::cerr << "Failed to parse file!\n";
+            return 1;
+        }
+
+        std::vector<u8> overlay{};
+        if (!util::loadFileStreamed(overlayPath, overlay)) {
+            std::cerr << "Failed to open overlay!\n";
+            return 1;
+        }
+        if (!sys.loadYAMLOverlay(std::move(overlay))) {
+            std::cerr << "Failed to parse overlay!\n";
+            return 1;
+        }
+
+        // everything the overlay didn't touch is copied straight from the original
+        const auto data = sys.serialize(true);
+        const std::span<const u8> dict = {dictData.data(), dictData.size()};
+        util::writeFile(outputPath, {data.data(), data.size()}, !dictPath.empty(), dict);
     } else if (opt == "--roundtrip") {
-        const std::string filepath = parseInput(argc, argv, 1);
-        const std::string outputPath = parseInput(argc, argv, 2);
-        const std::string dictPath = parseInput(argc, argv, 3);
+        const std::string filepath = parseInput(1);
+        const std::string outputPath = parseInput(2);
+        const std::string dictPath = parseInput(3);
 
 
         if (dictPath.empty()) {
@@ -135,11 +542,17 @@ int main(int argc, char** argv) {
             util::loadFile(filepath, buffer);
 
             banana::System sys;
-            if (!sys.initialize(buffer.data(), buffer.size())) {
+            if (!sys.initialize(buffer.data(), buffer.size(), {}, hasFlag("--incremental"))) {
                 std::cerr << "Failed to parse file!\n";
                 return 1;
             }
-            const auto data = sys.serialize();
+
+            if (hasFlag("--optimize")) {
+                sys.eliminateDeadEntries();
+                sys.canonicalize();
+            }
+
+            const auto data = sys.serialize(hasFlag("--incremental"));
             util::writeFile(outputPath, {reinterpret_cast<const u8*>(data.data()), data.size()}, false);
         } else {
             util::Archive archive;
@@ -162,14 +575,123 @@ int main(int argc, char** argv) {
             }
 
             banana::System sys;
-            if (!sys.initialize(buffer.data(), buffer.size())) {
+            if (!sys.initialize(buffer.data(), buffer.size(), {}, hasFlag("--incremental"))) {
                 std::cerr << "Failed to parse file!\n";
                 return 1;
             }
 
-            const auto data = sys.serialize();
+            if (hasFlag("--optimize")) {
+                sys.eliminateDeadEntries();
+                sys.canonicalize();
+            }
+
+            const auto data = sys.serialize(hasFlag("--incremental"));
             util::writeFile(outputPath, {reinterpret_cast<const u8*>(data.data()), data.size()}, false);
         }
+    } else if (opt == "--patch") {
+        const std::string filepath = parseInput(1);
+        const std::string outputPath = parseInput(2);
+
+        std::vector<u8> buffer{};
+        if (!util::loadFile(filepath, buffer)) {
+            std::cerr << "failed to load file!\n";
+            return 1;
+        }
+
+        banana::ResourcePatcher patcher;
+        if (!patcher.load(buffer.data(), buffer.size())) {
+            std::cerr << "Failed to parse file!\n";
+            return 1;
+        }
+        for (size_t i = 3; i < sArguments.size(); ++i) {
+            if (!applyPatch(patcher, sArguments[i])) {
+                std::cerr << "Failed to apply " << sArguments[i] << "\n";
+                return 1;
+            }
+        }
+
+        // the patched file has to decode and serialize back to the exact same bytes, otherwise an edit broke something
+        std::vector<u8> check = buffer;
+        banana::System sys;
+        if (!sys.initialize(check.data(), check.size())) {
+            std::cerr << "Failed to parse patched file!\n";
+            return 1;
+        }
+        const auto data = sys.serialize();
+        if (!std::ranges::equal(data, buffer)) {
+            std::cerr << "Patched file doesn't round trip, not writing it!\n";
+            return 1;
+        }
+
+        util::writeFile(outputPath, {buffer.data(), buffer.size()}, false);
+    } else if (opt == "--build-names") {
+        const std::string outputPath = parseInput(1);
+        if (outputPath.empty() || sArguments.size() < 3) {
+            std::cerr << "No inputs given!\n";
+            return 1;
+        }
+
+        util::NameDictionaryBuilder builder;
+        for (size_t i = 2; i < sArguments.size(); ++i) {
+            const std::string& path = sArguments[i];
+            std::vector<u8> buffer{};
+            if (!util::loadFile(path, buffer)) {
+                std::cerr << "Failed to open " << path << "\n";
+                return 1;
+            }
+            if (path.ends_with(".txt")) {
+                builder.addList({reinterpret_cast<const char*>(buffer.data()), buffer.size()});
+                continue;
+            }
+            banana::System sys;
+            if (!sys.initialize(buffer.data(), buffer.size())) {
+                std::cerr << "Failed to parse " << path << "\n";
+                return 1;
+            }
+            sys.collectNames(builder);
+        }
+
+        using Section = util::NameDictionary::Section;
+        std::cout << std::format("{} users, {} keys, {} properties, {} actions\n",
+                                 builder.getCount(Section::User), builder.getCount(Section::Key),
+                                 builder.getCount(Section::Property), builder.getCount(Section::Action));
+        const auto data = builder.build();
+        util::writeFile(outputPath, {data.data(), data.size()}, false);
+    } else if (opt == "--lookup") {
+        static constexpr std::pair<std::string_view, util::NameDictionary::Section> cSections[] = {
+            { "users", util::NameDictionary::Section::User },
+            { "keys", util::NameDictionary::Section::Key },
+            { "properties", util::NameDictionary::Section::Property },
+            { "actions", util::NameDictionary::Section::Action },
+        };
+
+        util::NameDictionary names;
+        if (!names.open(parseInput(1))) {
+            return 1;
+        }
+        const std::string sectionName = parseInput(2);
+        const auto section = std::ranges::find(cSections, sectionName, &std::pair<std::string_view, util::NameDictionary::Section>::first);
+        if (section == std::end(cSections)) {
+            std::cerr << "Unknown section " << sectionName << "\n";
+            return 1;
+        }
+
+        // hashes print their name and names their hash, anything not in the dictionary prints as ?
+        for (size_t i = 3; i < sArguments.size(); ++i) {
+            const std::string& query = sArguments[i];
+            if (query.starts_with("0x") || query.starts_with("0X")) {
+                const auto hash = parseHash(query);
+                if (!hash) {
+                    std::cerr << "Invalid hash " << query << "\n";
+                    continue;
+                }
+                const auto name = names.findName(section->second, *hash);
+                std::cout << query << ": " << (name.empty() ? "?" : name) << "\n";
+            } else {
+                const auto hash = names.findHash(section->second, query);
+                std::cout << query << ": " << (hash ? std::format("{:#010x}", *hash) : "?") << "\n";
+            }
+        }
     } else {
         std::cout << "Unknown option! Please use --help for usage";
     }
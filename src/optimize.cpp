@@ -0,0 +1,363 @@
+#include "system.h"
+#include "digest.h"
+
+#include <algorithm>
+#include <ranges>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace banana {
+
+namespace {
+
+// collapses the pool down to its unique entries (first occurrence wins) and returns the old -> new index map
+template <typename T, typename Digest>
+std::vector<s32> hashCons(std::vector<T>& pool, Digest&& digestFunc) {
+    std::unordered_map<std::string, s32> seen{};
+    seen.reserve(pool.size());
+    std::vector<s32> remap(pool.size());
+    std::vector<T> unique{};
+    unique.reserve(pool.size());
+
+    for (size_t i = 0; i < pool.size(); ++i) {
+        DigestKey key{};
+        digestFunc(key, pool[i]);
+        const auto [it, inserted] = seen.try_emplace(std::move(key.bytes), static_cast<s32>(unique.size()));
+        if (inserted) {
+            unique.emplace_back(std::move(pool[i]));
+        }
+        remap[i] = it->second;
+    }
+
+    // nothing merged, leave the pool alone and signal identity
+    if (unique.size() == pool.size()) {
+        return {};
+    }
+
+    pool = std::move(unique);
+    return remap;
+}
+
+enum class ParamPool {
+    None,
+    DirectValue,
+    Curve,
+    Random,
+    ArrangeGroup,
+};
+
+// which shared pool a param's value indexes into (if any)
+inline ParamPool getParamPool(const xlink2::ValueReferenceType type) {
+    switch (type) {
+        case xlink2::ValueReferenceType::Direct:
+            return ParamPool::DirectValue;
+        case xlink2::ValueReferenceType::Curve:
+            return ParamPool::Curve;
+        case xlink2::ValueReferenceType::ArrangeParam:
+            return ParamPool::ArrangeGroup;
+        case xlink2::ValueReferenceType::String:
+        case xlink2::ValueReferenceType::Bitfield:
+            return ParamPool::None;
+        default:
+            // Random and all of the RandomPow variants index the random table
+            return ParamPool::Random;
+    }
+}
+
+// drops every entry not marked live and returns the old -> new index map (-1 for removed entries)
+template <typename T>
+std::vector<s32> compact(std::vector<T>& pool, const std::vector<bool>& live) {
+    if (std::ranges::all_of(live, [](bool b) { return b; })) {
+        return {};
+    }
+
+    std::vector<s32> remap(pool.size(), -1);
+    size_t count = 0;
+    for (size_t i = 0; i < pool.size(); ++i) {
+        if (!live[i]) {
+            continue;
+        }
+        if (count != i) {
+            pool[count] = std::move(pool[i]);
+        }
+        remap[i] = static_cast<s32>(count++);
+    }
+    pool.erase(pool.begin() + static_cast<ptrdiff_t>(count), pool.end());
+    return remap;
+}
+
+inline void remapIndex(s32& index, const std::vector<s32>& remap) {
+    if (!remap.empty() && index >= 0) {
+        index = remap[static_cast<u32>(index)];
+    }
+}
+
+inline void remapParam(Param& param, const std::vector<s32>& remap) {
+    if (remap.empty()) {
+        return;
+    }
+    auto& value = std::get<u32>(param.value);
+    value = static_cast<u32>(remap[value]);
+}
+
+} // namespace
+
+void System::remapPools(const PoolRemap& remap) {
+    const bool leavesChanged = !remap.directValues.empty() || !remap.curves.empty() || !remap.randomCalls.empty() || !remap.arrangeGroupParams.empty();
+    const bool setsChanged = !remap.assetParams.empty() || !remap.triggerOverwriteParams.empty() || !remap.conditions.empty();
+    if (!leavesChanged && !setsChanged) {
+        return;
+    }
+
+    // anything that was moved or holds a reference to something that was is no longer byte identical to the source
+    const auto markRemapped = [this](const std::vector<s32>& indices, Pool pool) {
+        if (!indices.empty()) {
+            markDirty(pool);
+        }
+    };
+    markRemapped(remap.directValues, Pool::DirectValues);
+    markRemapped(remap.curves, Pool::Curves);
+    markRemapped(remap.randomCalls, Pool::RandomCalls);
+    markRemapped(remap.arrangeGroupParams, Pool::ArrangeGroupParams);
+    markRemapped(remap.assetParams, Pool::AssetParams);
+    markRemapped(remap.triggerOverwriteParams, Pool::TriggerOverwriteParams);
+    markRemapped(remap.conditions, Pool::Conditions);
+    if (leavesChanged) {
+        markDirty(Pool::AssetParams);
+        markDirty(Pool::TriggerOverwriteParams);
+    }
+
+    const auto updateParam = [&remap](Param& param) {
+        switch (getParamPool(param.type)) {
+            case ParamPool::DirectValue:
+                remapParam(param, remap.directValues);
+                break;
+            case ParamPool::Curve:
+                remapParam(param, remap.curves);
+                break;
+            case ParamPool::Random:
+                remapParam(param, remap.randomCalls);
+                break;
+            case ParamPool::ArrangeGroup:
+                remapParam(param, remap.arrangeGroupParams);
+                break;
+            default:
+                break;
+        }
+    };
+
+    for (auto& set : mAssetParams) {
+        std::ranges::for_each(set.params, updateParam);
+    }
+    for (auto& set : mTriggerOverwriteParams) {
+        std::ranges::for_each(set.params, updateParam);
+    }
+
+    for (auto& user : mUsers | std::views::values) {
+        user.markDirty();
+        std::ranges::for_each(user.mUserParams, updateParam);
+        for (auto& act : user.mAssetCallTables) {
+            if (!act.isContainer()) {
+                remapIndex(act.assetParamIdx, remap.assetParams);
+            }
+            remapIndex(act.conditionIdx, remap.conditions);
+        }
+        for (auto& trigger : user.mActionTriggers) {
+            remapIndex(trigger.triggerOverwriteIdx, remap.triggerOverwriteParams);
+        }
+        for (auto& trigger : user.mPropertyTriggers) {
+            remapIndex(trigger.conditionIdx, remap.conditions);
+            remapIndex(trigger.triggerOverwriteIdx, remap.triggerOverwriteParams);
+        }
+        for (auto& trigger : user.mAlwaysTriggers) {
+            remapIndex(trigger.triggerOverwriteIdx, remap.triggerOverwriteParams);
+        }
+    }
+}
+
+void System::eliminateDeadEntries() {
+    // users are the only roots, everything else is live only if something reachable from a user points at it
+    std::vector<bool> liveAssetParams(mAssetParams.size());
+    std::vector<bool> liveTriggerParams(mTriggerOverwriteParams.size());
+    std::vector<bool> liveConditions(mConditions.size());
+    std::vector<bool> liveDirectValues(mDirectValues.size());
+    std::vector<bool> liveCurves(mCurves.size());
+    std::vector<bool> liveRandomCalls(mRandomCalls.size());
+    std::vector<bool> liveArrangeGroupParams(mArrangeGroupParams.size());
+
+    const auto mark = [](std::vector<bool>& live, s32 index) {
+        if (index >= 0) {
+            live[static_cast<u32>(index)] = true;
+        }
+    };
+    const auto markParam = [&](const Param& param) {
+        switch (getParamPool(param.type)) {
+            case ParamPool::DirectValue:
+                liveDirectValues[std::get<u32>(param.value)] = true;
+                break;
+            case ParamPool::Curve:
+                liveCurves[std::get<u32>(param.value)] = true;
+                break;
+            case ParamPool::Random:
+                liveRandomCalls[std::get<u32>(param.value)] = true;
+                break;
+            case ParamPool::ArrangeGroup:
+                liveArrangeGroupParams[std::get<u32>(param.value)] = true;
+                break;
+            default:
+                break;
+        }
+    };
+
+    for (const auto& user : mUsers | std::views::values) {
+        std::ranges::for_each(user.mUserParams, markParam);
+        for (const auto& act : user.mAssetCallTables) {
+            if (!act.isContainer()) {
+                mark(liveAssetParams, act.assetParamIdx);
+            }
+            mark(liveConditions, act.conditionIdx);
+        }
+        for (const auto& trigger : user.mActionTriggers) {
+            mark(liveTriggerParams, trigger.triggerOverwriteIdx);
+        }
+        for (const auto& trigger : user.mPropertyTriggers) {
+            mark(liveConditions, trigger.conditionIdx);
+            mark(liveTriggerParams, trigger.triggerOverwriteIdx);
+        }
+        for (const auto& trigger : user.mAlwaysTriggers) {
+            mark(liveTriggerParams, trigger.triggerOverwriteIdx);
+        }
+    }
+    for (size_t i = 0; i < mAssetParams.size(); ++i) {
+        if (liveAssetParams[i]) {
+            std::ranges::for_each(mAssetParams[i].params, markParam);
+        }
+    }
+    for (size_t i = 0; i < mTriggerOverwriteParams.size(); ++i) {
+        if (liveTriggerParams[i]) {
+            std::ranges::for_each(mTriggerOverwriteParams[i].params, markParam);
+        }
+    }
+
+    PoolRemap remap{};
+    remap.assetParams = compact(mAssetParams, liveAssetParams);
+    remap.triggerOverwriteParams = compact(mTriggerOverwriteParams, liveTriggerParams);
+    remap.conditions = compact(mConditions, liveConditions);
+    remap.directValues = compact(mDirectValues, liveDirectValues);
+    remap.curves = compact(mCurves, liveCurves);
+    remap.randomCalls = compact(mRandomCalls, liveRandomCalls);
+    remap.arrangeGroupParams = compact(mArrangeGroupParams, liveArrangeGroupParams);
+    remapPools(remap);
+
+    // strings go last since the dead entries above may have been the only thing referencing some of them
+    std::unordered_set<std::string_view> liveStrings{};
+    const auto markString = [&liveStrings](const std::string_view str) {
+        liveStrings.emplace(str);
+    };
+    const auto markParamString = [&liveStrings](const Param& param) {
+        if (param.type == xlink2::ValueReferenceType::String) {
+            liveStrings.emplace(std::get<std::string_view>(param.value));
+        }
+    };
+
+    std::ranges::for_each(mLocalProperties, markString);
+    std::ranges::for_each(mLocalPropertyEnumStrings, markString);
+    for (const auto& curve : mCurves) {
+        markString(curve.propertyName);
+    }
+    for (const auto& params : mArrangeGroupParams) {
+        for (const auto& group : params.groups) {
+            markString(group.groupName);
+        }
+    }
+    for (const auto& condition : mConditions) {
+        if (condition.parentContainerType == xlink2::ContainerType::Switch) {
+            const auto cond = condition.getAs<xlink2::ContainerType::Switch>();
+            if (cond->propType == xlink2::PropertyType::Enum) {
+                markString(cond->enumName);
+            }
+        }
+    }
+    for (const auto& set : mAssetParams) {
+        std::ranges::for_each(set.params, markParamString);
+    }
+    for (const auto& set : mTriggerOverwriteParams) {
+        std::ranges::for_each(set.params, markParamString);
+    }
+
+    for (const auto& user : mUsers | std::views::values) {
+        std::ranges::for_each(user.mLocalProperties, markString);
+        std::ranges::for_each(user.mUserParams, markParamString);
+        for (const auto& act : user.mAssetCallTables) {
+            markString(act.keyName);
+        }
+        for (const auto& container : user.mContainers) {
+            switch (container.type) {
+                case xlink2::ContainerType::Switch:
+                    markString(container.getAs<xlink2::ContainerType::Switch>()->actionSlotName);
+                    break;
+#if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
+                case xlink2::ContainerType::Blend:
+                    if (container.isNotBlendAll) {
+                        markString(container.getAs<xlink2::ContainerType::Blend, true>()->actionSlotName);
+                    }
+                    break;
+                case xlink2::ContainerType::Grid: {
+                    const auto param = container.getAs<xlink2::ContainerType::Grid>();
+                    markString(param->propertyName1);
+                    markString(param->propertyName2);
+                    break;
+                }
+#endif
+                default:
+                    break;
+            }
+        }
+        for (const auto& slot : user.mActionSlots) {
+            markString(slot.actionSlotName);
+        }
+        for (const auto& action : user.mActions) {
+            markString(action.actionName);
+        }
+        for (const auto& trigger : user.mActionTriggers) {
+            if (trigger.nameMatch) {
+                markString(trigger.previousActionName);
+            }
+        }
+        for (const auto& prop : user.mProperties) {
+            markString(prop.propertyName);
+        }
+    }
+
+    // the backing storage is left alone, it's only freed along with the system
+    std::erase_if(mStrings, [&liveStrings](const std::string_view str) { return !liveStrings.contains(str); });
+}
+
+void System::canonicalize() {
+    // leaves first so param sets referencing equal leaves end up with equal indices
+    PoolRemap leaves{};
+    leaves.directValues = hashCons(mDirectValues, [](DigestKey& key, const DirectValue& value) {
+        digestValue(key, value.type.u);
+        digestValue(key, value.value.u);
+    });
+    leaves.curves = hashCons(mCurves, [](DigestKey& key, const Curve& curve) { digest(key, curve); });
+    leaves.randomCalls = hashCons(mRandomCalls, [](DigestKey& key, const Random& random) { digest(key, random); });
+    leaves.arrangeGroupParams = hashCons(mArrangeGroupParams, [](DigestKey& key, const ArrangeGroupParams& params) { digest(key, params); });
+    remapPools(leaves);
+
+    // param order within a set isn't meaningful (the serializer sorts by index anyways)
+    const auto sortParams = [](ParamSet& set) {
+        std::ranges::sort(set.params, [](const Param& lhs, const Param& rhs) { return lhs.index < rhs.index; });
+    };
+    std::ranges::for_each(mAssetParams, sortParams);
+    std::ranges::for_each(mTriggerOverwriteParams, sortParams);
+
+    PoolRemap sets{};
+    sets.assetParams = hashCons(mAssetParams, [](DigestKey& key, const ParamSet& set) { digest(key, set); });
+    sets.triggerOverwriteParams = hashCons(mTriggerOverwriteParams, [](DigestKey& key, const ParamSet& set) { digest(key, set); });
+    sets.conditions = hashCons(mConditions, [](DigestKey& key, const Condition& condition) { digest(key, condition); });
+    remapPools(sets);
+}
+
+} // namespace banana
@@ -0,0 +1,210 @@
+#include "patcher.h"
+#include "util/type_utils.h"
+
+#include <bit>
+
+namespace banana {
+
+// how far the condition table moves on past a condition, 0 for anything unrecognized
+static size_t CalcConditionSize(const xlink2::ResCondition* condition) {
+    switch (condition->getType()) {
+        case xlink2::ContainerType::Switch:
+#if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
+            // enumNameOffset is left off for anything but enums
+            if (static_cast<const xlink2::ResSwitchCondition*>(condition)->getPropType() != xlink2::PropertyType::Enum) {
+                return sizeof(xlink2::ResSwitchCondition) - sizeof(TargetPointer);
+            }
+#endif
+            return sizeof(xlink2::ResSwitchCondition);
+        case xlink2::ContainerType::Random:
+        case xlink2::ContainerType::Random2:
+            return sizeof(xlink2::ResRandomCondition);
+        case xlink2::ContainerType::Blend:
+            return sizeof(xlink2::ResBlendCondition);
+        case xlink2::ContainerType::Sequence:
+            return sizeof(xlink2::ResSequenceCondition);
+#if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
+        case xlink2::ContainerType::Grid:
+            return sizeof(xlink2::ResGridCondition);
+        case xlink2::ContainerType::Jump:
+            return sizeof(xlink2::ResJumpCondition);
+#endif
+        default:
+            return 0;
+    }
+}
+
+bool ResourcePatcher::load(void* data, size_t size) {
+    const auto header = reinterpret_cast<const xlink2::ResourceHeader*>(data);
+    if (header == nullptr || size < sizeof(xlink2::ResourceHeader) || size != header->fileSize) {
+        return false;
+    }
+    if (!mAccessor.load(data)) {
+        return false;
+    }
+
+    // same walk System::initialize does, the condition table runs up to the name table
+    mConditionOffsets.clear();
+    const auto condBase = reinterpret_cast<uintptr_t>(mAccessor.getCondition(0));
+    const auto condEnd = reinterpret_cast<uintptr_t>(mAccessor.getString(0));
+    TargetPointer condOffset = 0;
+    while (condBase + condOffset < condEnd) {
+        const size_t condSize = CalcConditionSize(mAccessor.getCondition(condOffset));
+        if (condSize == 0) {
+            return false;
+        }
+        mConditionOffsets.emplace_back(condOffset);
+        condOffset += static_cast<TargetPointer>(condSize);
+    }
+    return true;
+}
+
+bool ResourcePatcher::setDirectValueU32(s32 index, u32 value) {
+    if (!isLoaded() || index < 0 || index >= mAccessor.getResourceHeader()->numDirectValues) {
+        return false;
+    }
+    auto table = reinterpret_cast<u32*>(util::AsMutable(mAccessor.getDirectValueTable()));
+    table[index] = value;
+    return true;
+}
+
+bool ResourcePatcher::setDirectValueS32(s32 index, s32 value) {
+    return setDirectValueU32(index, std::bit_cast<u32>(value));
+}
+
+bool ResourcePatcher::setDirectValueF32(s32 index, f32 value) {
+    return setDirectValueU32(index, std::bit_cast<u32>(value));
+}
+
+bool ResourcePatcher::setRandomCall(s32 index, f32 min, f32 max) {
+    if (!isLoaded() || index < 0) {
+        return false;
+    }
+    auto random = util::AsMutable(mAccessor.getRandomCall(static_cast<size_t>(index)));
+    if (random == nullptr) {
+        return false;
+    }
+    random->minVal = min;
+    random->maxVal = max;
+    return true;
+}
+
+bool ResourcePatcher::setCurvePoint(s32 curveIndex, s32 pointIndex, f32 x, f32 y) {
+    if (!isLoaded() || curveIndex < 0 || pointIndex < 0) {
+        return false;
+    }
+    const auto curve = mAccessor.getCurve(static_cast<size_t>(curveIndex));
+    if (curve == nullptr || pointIndex >= curve->numCurvePoint) {
+        return false;
+    }
+    auto point = util::AsMutable(mAccessor.getCurvePoint(curve->curvePointBaseIdx + static_cast<size_t>(pointIndex)));
+    if (point == nullptr) {
+        return false;
+    }
+    point->x = x;
+    point->y = y;
+    return true;
+}
+
+bool ResourcePatcher::setSwitchConditionS32(s32 conditionIndex, s32 value) {
+    auto condition = static_cast<xlink2::ResSwitchCondition*>(getCondition(conditionIndex, xlink2::ContainerType::Switch));
+    if (condition == nullptr) {
+        return false;
+    }
+    switch (condition->getPropType()) {
+        case xlink2::PropertyType::S32:
+        case xlink2::PropertyType::_04:
+            condition->value.i = value;
+            return true;
+        case xlink2::PropertyType::Bool:
+            condition->value.u = value != 0 ? 1 : 0;
+            return true;
+        default:
+            // on blitz the value field holds the enum name for enum properties, either way it's not a plain number
+            return false;
+    }
+}
+
+bool ResourcePatcher::setSwitchConditionF32(s32 conditionIndex, f32 value) {
+    auto condition = static_cast<xlink2::ResSwitchCondition*>(getCondition(conditionIndex, xlink2::ContainerType::Switch));
+    if (condition == nullptr) {
+        return false;
+    }
+    if (condition->getPropType() != xlink2::PropertyType::F32 && condition->getPropType() != xlink2::PropertyType::_05) {
+        return false;
+    }
+    condition->value.f = value;
+    return true;
+}
+
+bool ResourcePatcher::setBlendConditionRange(s32 conditionIndex, f32 min, f32 max) {
+    auto condition = static_cast<xlink2::ResBlendCondition*>(getCondition(conditionIndex, xlink2::ContainerType::Blend));
+    if (condition == nullptr) {
+        return false;
+    }
+    condition->min = min;
+    condition->max = max;
+    return true;
+}
+
+bool ResourcePatcher::setRandomConditionWeight(s32 conditionIndex, f32 weight) {
+    auto condition = static_cast<xlink2::ResRandomCondition*>(getCondition(conditionIndex, xlink2::ContainerType::Random));
+    if (condition == nullptr) {
+        return false;
+    }
+    condition->weight = weight;
+    return true;
+}
+
+bool ResourcePatcher::setActionTriggerFrames(u32 userHash, s32 triggerIndex, s32 startFrame, s32 endFrame) {
+    const auto user = searchUser(userHash);
+    if (user == nullptr || triggerIndex < 0 || triggerIndex >= user->actionTriggerCount) {
+        return false;
+    }
+
+    // action slots -> actions -> action triggers
+    const auto actionSlots = reinterpret_cast<const xlink2::ResActionSlot*>(reinterpret_cast<uintptr_t>(user) + user->triggerTableOffset);
+    const auto actions = reinterpret_cast<const xlink2::ResAction*>(actionSlots + user->actionSlotCount);
+    auto trigger = util::AsMutable(reinterpret_cast<const xlink2::ResActionTrigger*>(actions + user->actionCount) + triggerIndex);
+    if (trigger->isFlagSet(xlink2::ResActionTrigger::Flag::NameMatch)) {
+        return false;
+    }
+    trigger->startFrame = startFrame;
+    trigger->endFrame = endFrame;
+    return true;
+}
+
+xlink2::ResUserHeader* ResourcePatcher::searchUser(u32 hash) const {
+    if (!isLoaded()) {
+        return nullptr;
+    }
+
+    // the hash array is sorted
+    size_t lo = 0;
+    size_t hi = static_cast<size_t>(mAccessor.getResourceHeader()->numUsers);
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const u32 midHash = mAccessor.getUserHash(mid);
+        if (midHash == hash) {
+            return util::AsMutable(mAccessor.getResUserHeader(mid));
+        }
+        if (midHash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return nullptr;
+}
+
+xlink2::ResCondition* ResourcePatcher::getCondition(s32 index, xlink2::ContainerType type) const {
+    if (!isLoaded() || index < 0 || static_cast<size_t>(index) >= mConditionOffsets.size()) {
+        return nullptr;
+    }
+    auto condition = util::AsMutable(mAccessor.getCondition(mConditionOffsets[static_cast<size_t>(index)]));
+    // the two random types share a layout
+    const auto condType = condition->getType() == xlink2::ContainerType::Random2 ? xlink2::ContainerType::Random : condition->getType();
+    return condType == type ? condition : nullptr;
+}
+
+} // namespace banana
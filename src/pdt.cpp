@@ -206,7 +206,8 @@ s32 ParamDefineTable::searchParamIndex(const std::string_view name, ParamType ty
     }
 }
 
-void ParamDefine::dumpYAML(LibyamlEmitterWithStorage<std::string>& emitter) const {
+template <typename Emitter>
+void ParamDefine::dumpYAML(Emitter& emitter) const {
     emitter.EmitString(mName);
 
     switch (mType) {
@@ -220,75 +221,80 @@ void ParamDefine::dumpYAML(LibyamlEmitterWithStorage<std::string>& emitter) cons
             emitter.EmitBool(std::get<bool>(mDefaultValue));
             break;
         case xlink2::ParamType::Enum:
-            emitter.EmitScalar(std::format("{:#010x}", std::get<u32>(mDefaultValue)), false, false, "!u");
+            emitter.EmitHex(std::get<u32>(mDefaultValue), "!u");
             break;
         case xlink2::ParamType::String:
             emitter.EmitString(std::get<std::string_view>(mDefaultValue));
             break;
         case xlink2::ParamType::Bitfield:
-            emitter.EmitScalar(std::format("{:#x}", std::get<u32>(mDefaultValue)), false, false, "!bitfield");
+            emitter.EmitHex(std::get<u32>(mDefaultValue), "!bitfield", 1);
             break;
         default:
             throw InvalidDataError("Invalid param define type");
     }
 }
 
-void ParamDefineTable::dumpYAML(LibyamlEmitterWithStorage<std::string>& emitter, bool exportStrings) const {
+template <typename Emitter>
+void ParamDefineTable::dumpYAML(Emitter& emitter, bool exportStrings) const {
     emitter.EmitString("ParamDefineTable");
 
-    LibyamlEmitter::MappingScope scope{emitter, "!pdt", YAML_BLOCK_MAPPING_STYLE};
+    typename Emitter::MappingScope scope{emitter, "!pdt", YamlWriter::Block};
     emitter.EmitString("SystemUserParamCount");
     emitter.EmitInt(mSystemUserParamCount);
     emitter.EmitString("SystemAssetParamCount");
     emitter.EmitInt(mSystemAssetParamCount);
     {
         emitter.EmitString("UserParamDefines");
-        LibyamlEmitter::MappingScope paramScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+        typename Emitter::MappingScope paramScope{emitter, {}, YamlWriter::Block};
         for (const auto& define : mUserParams) {
             define.dumpYAML(emitter);
         }
     }
     {
         emitter.EmitString("AssetParamDefines");
-        LibyamlEmitter::MappingScope paramScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+        typename Emitter::MappingScope paramScope{emitter, {}, YamlWriter::Block};
         for (const auto& define : mAssetParams) {
             define.dumpYAML(emitter);
         }
     }
     {
         emitter.EmitString("TriggerParamDefines");
-        LibyamlEmitter::MappingScope paramScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+        typename Emitter::MappingScope paramScope{emitter, {}, YamlWriter::Block};
         for (const auto& define : mTriggerParams) {
             define.dumpYAML(emitter);
         }
     }
     if (exportStrings) {
         emitter.EmitString("Strings");
-        LibyamlEmitter::SequenceScope paramScope{emitter, {}, YAML_BLOCK_SEQUENCE_STYLE};
+        typename Emitter::SequenceScope paramScope{emitter, {}, YamlWriter::Block};
         for (const auto& str : mStrings) {
             emitter.EmitString(str);
         }
     }
 }
 
+template void ParamDefineTable::dumpYAML(YamlWriter&, bool) const;
+template void ParamDefineTable::dumpYAML(JsonWriter&, bool) const;
+
 void ParamDefine::loadYAML(const ryml::ConstNodeRef& node, const std::string_view&& name, ParamDefineTable& pdt) {
     mName = std::move(name);
 
     if (node.has_val_tag()) {
-        if (node.val_tag() == "!u") {
+        const Tag tag = RymlGetValTagId(node);
+        if (tag == Tag::U) {
             mType = xlink2::ParamType::Enum;
-            mDefaultValue = static_cast<u32>(*ParseScalarAs<u64>(node));
+            mDefaultValue = static_cast<u32>(DecodeScalar<u64>(node));
             return;
-        } else if (node.val_tag() == "!bitfield") {
+        } else if (tag == Tag::Bitfield) {
             mType = xlink2::ParamType::Bitfield;
-            mDefaultValue = static_cast<u32>(*ParseScalarAs<u64>(node));
+            mDefaultValue = static_cast<u32>(DecodeScalar<u64>(node));
             return;
         } else {
             throw ResourceError("Unknown node tag!");
         }
     }
 
-    const auto value = ParseScalar(node);
+    const auto value = DecodeNumber(node);
     if (const u64* asInt = std::get_if<u64>(&value)) {
         mType = xlink2::ParamType::Int;
         mDefaultValue = static_cast<s32>(*asInt);
@@ -306,12 +312,12 @@ void ParamDefine::loadYAML(const ryml::ConstNodeRef& node, const std::string_vie
     }
 
     mType = xlink2::ParamType::String;
-    mDefaultValue = pdt.addString(std::get<std::string>(value));
+    mDefaultValue = pdt.addString(std::string(RymlSubstrToStrView(node.val())));
 }
 
 bool ParamDefineTable::loadYAML(const ryml::ConstNodeRef& node) {
-    mSystemUserParamCount = static_cast<s32>(*ParseScalarAs<u64>(RymlGetMapItem(node, "SystemUserParamCount")));
-    mSystemAssetParamCount = static_cast<s32>(*ParseScalarAs<u64>(RymlGetMapItem(node, "SystemAssetParamCount")));
+    mSystemUserParamCount = static_cast<s32>(DecodeScalar<u64>(RymlGetMapItem(node, "SystemUserParamCount")));
+    mSystemAssetParamCount = static_cast<s32>(DecodeScalar<u64>(RymlGetMapItem(node, "SystemAssetParamCount")));
 
     const auto strings = node.find_child("Strings");
     if (!strings.invalid() && strings.is_seq()) {
@@ -48,12 +48,61 @@ File Section Order:
 */
 const TargetPointer negativeOne = static_cast<u32>(-1);
 
+Serializer::PoolSections Serializer::calcPoolSections(const xlink2::ResourceHeader& header, TargetPointer assetParamTablePos, TargetPointer userRegionPos) {
+    // same derivation ResourceAccessor uses for the tables that don't have their own position in the header
+    const TargetPointer directValuePos = header.localPropertyNameRefTablePos + sizeof(TargetPointer) * (header.numLocalPropertyNameRefs + header.numLocalPropertyEnumNameRefs);
+    const TargetPointer randomPos = directValuePos + sizeof(u32) * header.numDirectValues;
+    const TargetPointer curvePos = randomPos + sizeof(xlink2::ResRandomCallTable) * header.numRandom;
+
+    PoolSections sections{};
+    sections[static_cast<size_t>(System::Pool::AssetParams)] = { assetParamTablePos, header.triggerOverwriteTablePos };
+    sections[static_cast<size_t>(System::Pool::TriggerOverwriteParams)] = { header.triggerOverwriteTablePos, header.localPropertyNameRefTablePos };
+    sections[static_cast<size_t>(System::Pool::DirectValues)] = { directValuePos, randomPos };
+    sections[static_cast<size_t>(System::Pool::RandomCalls)] = { randomPos, curvePos };
+    sections[static_cast<size_t>(System::Pool::Curves)] = { curvePos, header.exRegionPos }; // includes the curve points
+    sections[static_cast<size_t>(System::Pool::ArrangeGroupParams)] = { header.exRegionPos, userRegionPos };
+    sections[static_cast<size_t>(System::Pool::Conditions)] = { header.conditionTablePos, header.nameTablePos };
+    return sections;
+}
+
+bool Serializer::copySourceSection(System::Pool pool) {
+    if (!mIncremental || mSystem->isDirty(pool)) {
+        return false;
+    }
+
+    const auto& section = mSections[static_cast<size_t>(pool)];
+    const auto& sourceSection = mSourceSections[static_cast<size_t>(pool)];
+    if (section.size() != sourceSection.size()) {
+        return false;
+    }
+
+    // param sets embed arrange group offsets so they're only valid if those didn't move
+    if ((pool == System::Pool::AssetParams || pool == System::Pool::TriggerOverwriteParams) && !mLayoutStable) {
+        return false;
+    }
+
+    write({mSystem->mSource.data.data() + sourceSection.begin, sourceSection.size()});
+    return true;
+}
+
 const xlink2::ResourceHeader Serializer::calcOffsets() {
     // they seem to not care about alignment of u64s to 8 bytes much
     size_t nameTableSize = 0;
-    for (const auto& string : mSystem->mStrings) {
-        mStringOffsets.emplace(string, nameTableSize);
-        nameTableSize += string.size() + 1;
+    if (mIncremental) {
+        // source strings keep their offsets so any bytes we reuse stay valid, new strings go on the end
+        mStringOffsets = mSystem->mSource.stringOffsets;
+        nameTableSize = mSystem->mSource.nameTableSize;
+        for (const auto& string : mSystem->mStrings) {
+            if (mStringOffsets.emplace(string, nameTableSize).second) {
+                mAppendedStrings.emplace_back(string);
+                nameTableSize += string.size() + 1;
+            }
+        }
+    } else {
+        for (const auto& string : mSystem->mStrings) {
+            mStringOffsets.emplace(string, nameTableSize);
+            nameTableSize += string.size() + 1;
+        }
     }
     mPDTNameTableSize = 0;
     for (const auto& string : mSystem->mPDT.mStrings) {
@@ -217,9 +266,33 @@ const xlink2::ResourceHeader Serializer::calcOffsets() {
         conditionTableOffset += sizeof(xlink2::ArrangeGroupParams) + (sizeof(xlink2::ArrangeGroupParam) * params.groups.size());
     }
 
+    // a clean user only points at strings (which don't move in incremental mode) and pool entries by relative offset,
+    // so its old bytes are still correct as long as every pool entry from the source is still where it used to be
+    const auto isStable = [](const std::vector<TargetPointer>& source, const std::vector<TargetPointer>& current) {
+        return source.size() <= current.size() && std::equal(source.begin(), source.end(), current.begin());
+    };
+    mLayoutStable = mIncremental
+                    && isStable(mSystem->mSource.assetParamOffsets, mAssetParamOffsets)
+                    && isStable(mSystem->mSource.triggerOverwriteParamOffsets, mTriggerParamOffsets)
+                    && isStable(mSystem->mSource.conditionOffsets, mConditionOffsets)
+                    && isStable(mSystem->mSource.arrangeGroupParamOffsets, mArrangeGroupParamOffsets);
+
+    const TargetPointer userRegionOffset = conditionTableOffset;
+
     u32 userParamCount = 0;
     for (const auto& [hash, user] : mSystem->mUsers) {
         mUserOffsets.emplace(hash, conditionTableOffset);
+        if (mLayoutStable && !user.mDirty && user.mSourceSize != 0) {
+            const auto res = reinterpret_cast<const xlink2::ResUserHeader*>(mSystem->mSource.data.data() + user.mSourceOffset);
+            UserInfo info{};
+            info.totalSize = user.mSourceSize;
+            info.assetCount = res->assetCount;
+            info.reuseSource = true;
+            mUserInfo.emplace(hash, std::move(info));
+            conditionTableOffset += user.mSourceSize;
+            userParamCount += user.mUserParams.size() + res->assetCount;
+            continue;
+        }
         auto res = mUserInfo.emplace(hash, calcSize(user));
         conditionTableOffset += res.first->second.totalSize;
         userParamCount += user.mUserParams.size() + res.first->second.assetCount;
@@ -248,6 +321,12 @@ const xlink2::ResourceHeader Serializer::calcOffsets() {
         .nameTablePos = nameTableOffset,
     };
 
+    if (mIncremental) {
+        mSections = calcPoolSections(header, pdtStringTableStart + util::align(mPDTNameTableSize, sizeof(TargetPointer)), userRegionOffset);
+        const auto sourceHeader = reinterpret_cast<const xlink2::ResourceHeader*>(mSystem->mSource.data.data());
+        mSourceSections = calcPoolSections(*sourceHeader, mSystem->mSource.assetParamTablePos, mSystem->mSource.userRegionPos);
+    }
+
     return header;
 }
 
@@ -367,8 +446,16 @@ void Serializer::writeUser(const User& user, const u32 hash) {
 
     align(0x4);
     
+    // key names are hashed up front so several can be worked on at once
+    std::vector<std::string_view> keyNames(user.mAssetCallTables.size());
+    std::vector<u32> keyNameHashes(user.mAssetCallTables.size());
+    for (u32 i = 0; const auto& act : user.mAssetCallTables) {
+        keyNames[i++] = act.keyName;
+    }
+    util::calcCRC32(keyNames, keyNameHashes);
+
     s32 assetIndex = 0;
-    for (const auto& act : user.mAssetCallTables) {
+    for (u32 i = 0; const auto& act : user.mAssetCallTables) {
         xlink2::ResAssetCallTable res = {};
         res.keyNameOffset = mStringOffsets.at(act.keyName);
         res.assetIndex = static_cast<s16>(act.isContainer() ? negativeOne : assetIndex++);
@@ -376,7 +463,7 @@ void Serializer::writeUser(const User& user, const u32 hash) {
         res.duration = act.duration;
         res.parentIndex = act.parentIndex;
         res.guid = act.guid;
-        res.keyNameHash = util::calcCRC32(act.keyName);
+        res.keyNameHash = keyNameHashes[i++];
         res.paramOffset = (act.isContainer() ? info.containerOffsets[static_cast<u32>(act.containerParamIdx)] : mAssetParamOffsets[static_cast<u32>(act.assetParamIdx)]);
         res.conditionOffset = (act.conditionIdx == -1 ? negativeOne : mConditionOffsets[static_cast<u32>(act.conditionIdx)]);
         write(res);
@@ -639,28 +726,32 @@ void Serializer::serialize() {
 
     align(sizeof(TargetPointer));
 
-    for (auto& assetParam : mSystem->mAssetParams) {
-        size_t pos = tell();
-        write<u64>(0);
-        u64 values = 0;
-        std::ranges::sort(assetParam.params, [](const Param& lhs, const Param& rhs) { return lhs.index < rhs.index; });
-        for (const auto& param : assetParam.params) {
-            values |= 1ull << param.index;
-            writeParam(param);
+    if (!copySourceSection(System::Pool::AssetParams)) {
+        for (auto& assetParam : mSystem->mAssetParams) {
+            size_t pos = tell();
+            write<u64>(0);
+            u64 values = 0;
+            std::ranges::sort(assetParam.params, [](const Param& lhs, const Param& rhs) { return lhs.index < rhs.index; });
+            for (const auto& param : assetParam.params) {
+                values |= 1ull << param.index;
+                writeParam(param);
+            }
+            writeAt(values, pos);
         }
-        writeAt(values, pos);
     }
 
-    for (auto& triggerParam : mSystem->mTriggerOverwriteParams) {
-        size_t pos = tell();
-        write<u32>(0);
-        u32 values = 0;
-        std::ranges::sort(triggerParam.params, [](const Param& lhs, const Param& rhs) { return lhs.index < rhs.index; });
-        for (const auto& param : triggerParam.params) {
-            values |= 1u << param.index;
-            writeParam(param);
+    if (!copySourceSection(System::Pool::TriggerOverwriteParams)) {
+        for (auto& triggerParam : mSystem->mTriggerOverwriteParams) {
+            size_t pos = tell();
+            write<u32>(0);
+            u32 values = 0;
+            std::ranges::sort(triggerParam.params, [](const Param& lhs, const Param& rhs) { return lhs.index < rhs.index; });
+            for (const auto& param : triggerParam.params) {
+                values |= 1u << param.index;
+                writeParam(param);
+            }
+            writeAt(values, pos);
         }
-        writeAt(values, pos);
     }
 
     for (const auto& prop : mSystem->mLocalProperties) {
@@ -671,153 +762,175 @@ void Serializer::serialize() {
         write<TargetPointer>(mStringOffsets.at(value));
     }
 
-    for (const auto& value : mSystem->mDirectValues) {
-        write(value.value.u);
-    }
-
-    for (const auto& random : mSystem->mRandomCalls) {
-        const xlink2::ResRandomCallTable res = {
-            .minVal = random.min,
-            .maxVal = random.max,
-        };
-        write(res);
+    if (!copySourceSection(System::Pool::DirectValues)) {
+        for (const auto& value : mSystem->mDirectValues) {
+            write(value.value.u);
+        }
     }
 
-    std::vector<std::reference_wrapper<const CurvePoint>> curvePoints;
-    u32 points = 0;
-    for (const auto& curve : mSystem->mCurves) {
-        for (const auto& point : curve.points) {
-            curvePoints.emplace_back(point);
+    if (!copySourceSection(System::Pool::RandomCalls)) {
+        for (const auto& random : mSystem->mRandomCalls) {
+            const xlink2::ResRandomCallTable res = {
+                .minVal = random.min,
+                .maxVal = random.max,
+            };
+            write(res);
         }
-        const xlink2::ResCurveCallTable res = {
-            .curvePointBaseIdx = static_cast<u16>(points),
-            .numCurvePoint = static_cast<u16>(curve.points.size()),
-            .curveType = curve.type,
-            .isGlobal = static_cast<u16>(curve.isGlobal ? 1 : 0),
-            .propNameOffset = mStringOffsets.at(curve.propertyName),
-            .unk = curve.unk,
-            .propertyIndex = curve.propertyIndex,
-            .unk2 = curve.unk2,
-        };
-        write(res);
-        points += res.numCurvePoint;
     }
 
-    for (const auto& point : curvePoints) {
-        const xlink2::ResCurvePoint res = {
-            .x = point.get().x,
-            .y = point.get().y,
-        };
-        write(res);
-    }
+    if (!copySourceSection(System::Pool::Curves)) {
+        std::vector<std::reference_wrapper<const CurvePoint>> curvePoints;
+        u32 points = 0;
+        for (const auto& curve : mSystem->mCurves) {
+            for (const auto& point : curve.points) {
+                curvePoints.emplace_back(point);
+            }
+            const xlink2::ResCurveCallTable res = {
+                .curvePointBaseIdx = static_cast<u16>(points),
+                .numCurvePoint = static_cast<u16>(curve.points.size()),
+                .curveType = curve.type,
+                .isGlobal = static_cast<u16>(curve.isGlobal ? 1 : 0),
+                .propNameOffset = mStringOffsets.at(curve.propertyName),
+                .unk = curve.unk,
+                .propertyIndex = curve.propertyIndex,
+                .unk2 = curve.unk2,
+            };
+            write(res);
+            points += res.numCurvePoint;
+        }
 
-    for (const auto& arrangeGroup : mSystem->mArrangeGroupParams) {
-        write<u32>(arrangeGroup.groups.size());
-        for (const auto& param : arrangeGroup.groups) {
-            const xlink2::ArrangeGroupParam res = {
-                .groupNameOffset = mStringOffsets.at(param.groupName),
-                .limitType = param.limitType,
-                .limitThreshold = param.limitThreshold,
-                .unk = param.unk
+        for (const auto& point : curvePoints) {
+            const xlink2::ResCurvePoint res = {
+                .x = point.get().x,
+                .y = point.get().y,
             };
             write(res);
         }
     }
 
+    if (!copySourceSection(System::Pool::ArrangeGroupParams)) {
+        for (const auto& arrangeGroup : mSystem->mArrangeGroupParams) {
+            write<u32>(arrangeGroup.groups.size());
+            for (const auto& param : arrangeGroup.groups) {
+                const xlink2::ArrangeGroupParam res = {
+                    .groupNameOffset = mStringOffsets.at(param.groupName),
+                    .limitType = param.limitType,
+                    .limitThreshold = param.limitThreshold,
+                    .unk = param.unk
+                };
+                write(res);
+            }
+        }
+    }
+
     for (const auto& [hash, user] : mSystem->mUsers) {
-        writeUser(user, hash);
+        if (mUserInfo.at(hash).reuseSource) {
+            write({mSystem->mSource.data.data() + user.mSourceOffset, user.mSourceSize});
+        } else {
+            writeUser(user, hash);
+        }
     }
 
-    for (const auto& condition : mSystem->mConditions) {
-        switch (condition.parentContainerType) {
-            case xlink2::ContainerType::Switch: {
-                const auto param = condition.getAs<xlink2::ContainerType::Switch>();
-                xlink2::ResSwitchCondition res = {};
-                res.type = static_cast<u32>(condition.parentContainerType);
-                res.propertyType = static_cast<xlink2::PropertyTypePrimitive>(param->propType);
-                res.compareType = static_cast<xlink2::CompareTypePrimitive>(param->compareType);
-                res.solved = false;
-                res.isGlobal = param->isGlobal;
-                /* TODO: something aint right here */
-                res.actionHash = param->actionHash;
-                res.value.i = param->conditionValue.i;
-                if (param->propType == xlink2::PropertyType::Enum) {
+    if (!copySourceSection(System::Pool::Conditions)) {
+        for (const auto& condition : mSystem->mConditions) {
+            switch (condition.parentContainerType) {
+                case xlink2::ContainerType::Switch: {
+                    const auto param = condition.getAs<xlink2::ContainerType::Switch>();
+                    xlink2::ResSwitchCondition res = {};
+                    res.type = static_cast<u32>(condition.parentContainerType);
+                    res.propertyType = static_cast<xlink2::PropertyTypePrimitive>(param->propType);
+                    res.compareType = static_cast<xlink2::CompareTypePrimitive>(param->compareType);
+                    res.solved = false;
+                    res.isGlobal = param->isGlobal;
+                    /* TODO: something aint right here */
+                    res.actionHash = param->actionHash;
+                    res.value.i = param->conditionValue.i;
+                    if (param->propType == xlink2::PropertyType::Enum) {
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
-                    res.enumNameOffset = mStringOffsets.at(param->enumName);
+                        res.enumNameOffset = mStringOffsets.at(param->enumName);
 #else
-                    res.value.u = mStringOffsets.at(param->enumName);
-                    write(res);
+                        res.value.u = mStringOffsets.at(param->enumName);
+                        write(res);
 #endif
-                } else {
+                    } else {
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
-                    // omit enumNameOffset
-                    write({reinterpret_cast<const u8*>(&res), sizeof(xlink2::ResSwitchCondition) - sizeof(TargetPointer)});
+                        // omit enumNameOffset
+                        write({reinterpret_cast<const u8*>(&res), sizeof(xlink2::ResSwitchCondition) - sizeof(TargetPointer)});
 #else
-                    write(res);
+                        write(res);
 #endif
+                    }
+                    break;
+                }
+                case xlink2::ContainerType::Random: {
+                    const auto param = condition.getAs<xlink2::ContainerType::Random>();
+                    xlink2::ResRandomCondition res = {};
+                    res.type = static_cast<u32>(condition.parentContainerType);
+                    res.weight = param->weight;
+                    write(res);
+                    break;
+                }
+                case xlink2::ContainerType::Random2: {
+                    const auto param = condition.getAs<xlink2::ContainerType::Random2>();
+                    xlink2::ResRandomCondition2 res = {};
+                    res.type = static_cast<u32>(condition.parentContainerType);
+                    res.weight = param->weight;
+                    write(res);
+                    break;
+                }
+                case xlink2::ContainerType::Blend: {
+                    const auto param = condition.getAs<xlink2::ContainerType::Blend>();
+                    xlink2::ResBlendCondition res = {};
+                    res.type = static_cast<u32>(condition.parentContainerType);
+                    res.min = param->min;
+                    res.max = param->max;
+                    res.blendTypeToMax = static_cast<u8>(param->blendTypeToMax);
+                    res.blendTypeToMin = static_cast<u8>(param->blendTypeToMin);
+                    write(res);
+                    break;
+                }
+                case xlink2::ContainerType::Sequence: {
+                    const auto param = condition.getAs<xlink2::ContainerType::Sequence>();
+                    xlink2::ResSequenceCondition res = {};
+                    res.type = static_cast<u32>(condition.parentContainerType);
+                    res.isContinueOnFade = param->continueOnFade;
+                    write(res);
+                    break;
                 }
-                break;
-            }
-            case xlink2::ContainerType::Random: {
-                const auto param = condition.getAs<xlink2::ContainerType::Random>();
-                xlink2::ResRandomCondition res = {};
-                res.type = static_cast<u32>(condition.parentContainerType);
-                res.weight = param->weight;
-                write(res);
-                break;
-            }
-            case xlink2::ContainerType::Random2: {
-                const auto param = condition.getAs<xlink2::ContainerType::Random2>();
-                xlink2::ResRandomCondition2 res = {};
-                res.type = static_cast<u32>(condition.parentContainerType);
-                res.weight = param->weight;
-                write(res);
-                break;
-            }
-            case xlink2::ContainerType::Blend: {
-                const auto param = condition.getAs<xlink2::ContainerType::Blend>();
-                xlink2::ResBlendCondition res = {};
-                res.type = static_cast<u32>(condition.parentContainerType);
-                res.min = param->min;
-                res.max = param->max;
-                res.blendTypeToMax = static_cast<u8>(param->blendTypeToMax);
-                res.blendTypeToMin = static_cast<u8>(param->blendTypeToMin);
-                write(res);
-                break;
-            }
-            case xlink2::ContainerType::Sequence: {
-                const auto param = condition.getAs<xlink2::ContainerType::Sequence>();
-                xlink2::ResSequenceCondition res = {};
-                res.type = static_cast<u32>(condition.parentContainerType);
-                res.isContinueOnFade = param->continueOnFade;
-                write(res);
-                break;
-            }
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
-            case xlink2::ContainerType::Grid: {
-                // const auto param = condition.getAs<xlink2::ContainerType::Grid>();
-                const xlink2::ResGridCondition res = {};
-                res.type = static_cast<u32>(condition.parentContainerType);
-                write(res);
-                break;
-            }
+                case xlink2::ContainerType::Grid: {
+                    // const auto param = condition.getAs<xlink2::ContainerType::Grid>();
+                    const xlink2::ResGridCondition res = {};
+                    res.type = static_cast<u32>(condition.parentContainerType);
+                    write(res);
+                    break;
+                }
 #endif
 #if XLINK_TARGET_IS_TOTK
-            case xlink2::ContainerType::Jump: {
-                // const auto param = condition.getAs<xlink2::ContainerType::Jump>();
-                const xlink2::ResJumpCondition res = {};
-                res.type = static_cast<u32>(condition.parentContainerType);
-                write(res);
-                break;
-            }
+                case xlink2::ContainerType::Jump: {
+                    // const auto param = condition.getAs<xlink2::ContainerType::Jump>();
+                    const xlink2::ResJumpCondition res = {};
+                    res.type = static_cast<u32>(condition.parentContainerType);
+                    write(res);
+                    break;
+                }
 #endif
-            default:
-                throw InvalidDataError("Invalid condition type");
+                default:
+                    throw InvalidDataError("Invalid condition type");
+            }
         }
     }
 
-    for (const auto& str : mSystem->mStrings) {
-        writeString(str);
+    if (mIncremental) {
+        const auto sourceHeader = reinterpret_cast<const xlink2::ResourceHeader*>(mSystem->mSource.data.data());
+        write({mSystem->mSource.data.data() + sourceHeader->nameTablePos, mSystem->mSource.nameTableSize});
+        for (const auto& str : mAppendedStrings) {
+            writeString(str);
+        }
+    } else {
+        for (const auto& str : mSystem->mStrings) {
+            writeString(str);
+        }
     }
 }
 
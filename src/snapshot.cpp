@@ -0,0 +1,460 @@
+#include "system.h"
+#include "util/error.h"
+#include "util/file.h"
+#include "util/hash.h"
+
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <version>
+
+namespace banana {
+
+// the snapshot is a straight copy of the model's memory, so it's only readable by a build with the same layout
+// the layout hash only sees sizes, alignments and the toolchain, so bump the version whenever a member of
+// anything copied raw (the types in CalcLayoutHash) is added, removed or reordered
+static constexpr u32 cSnapshotMagic = 0x434d4c58; // XLMC
+static constexpr u32 cSnapshotVersion = 2;
+
+struct SnapshotHeader {
+    u32 magic;
+    u32 version;
+    u64 layoutHash;
+    u64 sourceHash;
+    u64 dataOffset;
+    u64 dataSize;
+    u64 stringsOffset;
+    u64 stringsSize;
+};
+
+// where a string lives in the snapshot's string blob
+struct SnapshotString {
+    u32 offset;
+    u32 size;
+};
+
+template <typename T>
+static void DigestLayout(util::XXHash64& hasher) {
+    const u64 layout[] = { sizeof(T), alignof(T) };
+    hasher.update(layout, sizeof(layout));
+}
+
+// System::DirectValue is private, so the members hand its layout in
+static u64 CalcLayoutHash(size_t directValueSize, size_t directValueAlign) {
+    util::XXHash64 hasher;
+    const auto add = [&](u64 value) { hasher.update(&value, sizeof(value)); };
+    add(XLINK_TARGET);
+    add(sizeof(void*));
+
+    // anything not spelled out in the types (variant storage, padding, bitfields) is up to the compiler and standard library
+#if defined(_MSC_VER) && !defined(__clang__)
+    add(1);
+    add(_MSC_FULL_VER);
+#elif defined(__clang__)
+    add(2);
+    add(__clang_major__ * 10000 + __clang_minor__ * 100 + __clang_patchlevel__);
+#elif defined(__GNUC__)
+    add(3);
+    add(__GNUC__ * 10000 + __GNUC_MINOR__ * 100 + __GNUC_PATCHLEVEL__);
+#endif
+#if defined(_LIBCPP_VERSION)
+    add(_LIBCPP_VERSION);
+#elif defined(__GLIBCXX__)
+    add(__GLIBCXX__);
+#elif defined(_MSVC_STL_UPDATE)
+    add(_MSVC_STL_UPDATE);
+#endif
+
+    add(directValueSize);
+    add(directValueAlign);
+    DigestLayout<Param>(hasher);
+    DigestLayout<ParamDefine>(hasher);
+    DigestLayout<CurvePoint>(hasher);
+    DigestLayout<Random>(hasher);
+    DigestLayout<ArrangeGroupParam>(hasher);
+    DigestLayout<Condition>(hasher);
+    DigestLayout<Container>(hasher);
+    DigestLayout<AssetCallTable>(hasher);
+    DigestLayout<ActionSlot>(hasher);
+    DigestLayout<Action>(hasher);
+    DigestLayout<ActionTrigger>(hasher);
+    DigestLayout<Property>(hasher);
+    DigestLayout<PropertyTrigger>(hasher);
+    DigestLayout<AlwaysTrigger>(hasher);
+    return hasher.digest();
+}
+
+// both archives go through the same transfer functions so the read order can't drift from the write order
+// arrays are copied as raw memory, anything in them that points somewhere (strings, grid vectors) is fixed up after
+class SnapshotWriter {
+public:
+    static constexpr bool cIsLoading = false;
+
+    template <typename T>
+    void value(T& v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        append(&v, sizeof(T));
+    }
+
+    template <typename T>
+    void count(std::vector<T>& v) {
+        u64 size = v.size();
+        value(size);
+    }
+
+    template <typename T>
+    void array(std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        count(v);
+        align();
+        append(v.data(), v.size() * sizeof(T));
+    }
+
+    void string(std::string_view& s) {
+        const auto [it, inserted] = mStringOffsets.try_emplace(s, static_cast<u32>(mStrings.size()));
+        if (inserted) {
+            if (mStrings.size() + s.size() > std::numeric_limits<u32>::max())
+                throw InvalidDataError("Too many strings for a snapshot");
+            mStrings.append(s);
+        }
+        SnapshotString ref{ it->second, static_cast<u32>(s.size()) };
+        value(ref);
+    }
+
+    void string(std::string& s) {
+        std::string_view view = s;
+        string(view);
+    }
+
+    const std::vector<u8>& getData() const {
+        return mData;
+    }
+
+    const std::string& getStrings() const {
+        return mStrings;
+    }
+
+private:
+    void append(const void* data, size_t size) {
+        mData.insert(mData.end(), static_cast<const u8*>(data), static_cast<const u8*>(data) + size);
+    }
+
+    void align() {
+        mData.resize((mData.size() + 7) & ~size_t(7));
+    }
+
+    std::vector<u8> mData{};
+    std::string mStrings{};
+    std::unordered_map<std::string_view, u32> mStringOffsets{};
+};
+
+class SnapshotReader {
+public:
+    static constexpr bool cIsLoading = true;
+
+    SnapshotReader(std::span<const u8> data, std::string_view strings) : mData(data), mStrings(strings) {}
+
+    template <typename T>
+    void value(T& v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        std::memcpy(&v, take(sizeof(T)), sizeof(T));
+    }
+
+    template <typename T>
+    void count(std::vector<T>& v) {
+        u64 size = 0;
+        value(size);
+        if (size > mData.size())
+            throw InvalidDataError("Snapshot is corrupted");
+        v.resize(size);
+    }
+
+    template <typename T>
+    void array(std::vector<T>& v) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        u64 size = 0;
+        value(size);
+        align();
+        if (size > mData.size() / sizeof(T))
+            throw InvalidDataError("Snapshot is corrupted");
+        v.resize(size);
+        std::memcpy(v.data(), take(size * sizeof(T)), size * sizeof(T));
+    }
+
+    // borrowed straight out of the mapping
+    void string(std::string_view& s) {
+        SnapshotString ref;
+        value(ref);
+        if (ref.offset > mStrings.size() || ref.size > mStrings.size() - ref.offset)
+            throw InvalidDataError("Snapshot string is out of bounds");
+        s = mStrings.substr(ref.offset, ref.size);
+    }
+
+    void string(std::string& s) {
+        std::string_view view;
+        string(view);
+        s = view;
+    }
+
+    bool atEnd() const {
+        return mPos == mData.size();
+    }
+
+private:
+    const u8* take(size_t size) {
+        if (size > mData.size() - mPos)
+            throw InvalidDataError("Snapshot is truncated");
+        const u8* data = mData.data() + mPos;
+        mPos += size;
+        return data;
+    }
+
+    void align() {
+        mPos = std::min((mPos + 7) & ~size_t(7), mData.size());
+    }
+
+    std::span<const u8> mData;
+    std::string_view mStrings;
+    size_t mPos = 0;
+};
+
+template <typename Archive>
+static void TransferParamStrings(Archive& ar, std::vector<Param>& params) {
+    for (auto& param : params) {
+        if (auto* str = std::get_if<std::string_view>(&param.value)) {
+            ar.string(*str);
+        }
+    }
+}
+
+// containers are copied raw, but grids hold vectors whose pointers mean nothing outside this process
+// they're written as zeroes and constructed again on load, their contents follow as arrays of their own
+template <typename Archive>
+static void TransferContainers(Archive& ar, std::vector<Container>& containers) {
+#if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
+    if constexpr (Archive::cIsLoading) {
+        ar.array(containers);
+    } else {
+        std::vector<Container> scrubbed = containers;
+        for (auto& container : scrubbed) {
+            if (container.type != xlink2::ContainerType::Grid)
+                continue;
+            auto* grid = container.getAs<xlink2::ContainerType::Grid>();
+            std::memset(static_cast<void*>(&grid->values1), 0, sizeof(grid->values1));
+            std::memset(static_cast<void*>(&grid->values2), 0, sizeof(grid->values2));
+            std::memset(static_cast<void*>(&grid->indices), 0, sizeof(grid->indices));
+        }
+        ar.array(scrubbed);
+    }
+    for (auto& container : containers) {
+        if (container.type != xlink2::ContainerType::Grid)
+            continue;
+        auto* grid = container.getAs<xlink2::ContainerType::Grid>();
+        if constexpr (Archive::cIsLoading) {
+            std::construct_at(&grid->values1);
+            std::construct_at(&grid->values2);
+            std::construct_at(&grid->indices);
+        }
+        ar.array(grid->values1);
+        ar.array(grid->values2);
+        ar.array(grid->indices);
+    }
+#else
+    ar.array(containers);
+#endif
+}
+
+template <typename Archive>
+void System::transferSnapshot(Archive& ar) {
+    ar.value(mVersion);
+
+    // the string pool goes first and in order, so loading rebuilds the set without any searching
+    u64 stringCount = mStrings.size();
+    ar.value(stringCount);
+    if constexpr (Archive::cIsLoading) {
+        for (u64 i = 0; i < stringCount; ++i) {
+            std::string_view str;
+            ar.string(str);
+            mStrings.emplace_hint(mStrings.end(), str);
+        }
+    } else {
+        for (std::string_view str : mStrings) {
+            ar.string(str);
+        }
+    }
+
+    u64 pdtStringCount = mPDT.mStrings.size();
+    ar.value(pdtStringCount);
+    if constexpr (Archive::cIsLoading) {
+        for (u64 i = 0; i < pdtStringCount; ++i) {
+            std::string str;
+            ar.string(str);
+            mPDT.mStrings.emplace_hint(mPDT.mStrings.end(), std::move(str));
+        }
+    } else {
+        for (const auto& str : mPDT.mStrings) {
+            std::string_view view = str;
+            ar.string(view);
+        }
+    }
+    for (auto* defines : {&mPDT.mUserParams, &mPDT.mAssetParams, &mPDT.mTriggerParams}) {
+        ar.array(*defines);
+        for (auto& define : *defines) {
+            ar.string(define.mName);
+            if (auto* str = std::get_if<std::string_view>(&define.mDefaultValue)) {
+                ar.string(*str);
+            }
+        }
+    }
+    ar.value(mPDT.mSystemUserParamCount);
+    ar.value(mPDT.mSystemAssetParamCount);
+    ar.value(mPDT.mInitialized);
+
+    ar.count(mLocalProperties);
+    for (auto& prop : mLocalProperties) {
+        ar.string(prop);
+    }
+    ar.count(mLocalPropertyEnumStrings);
+    for (auto& prop : mLocalPropertyEnumStrings) {
+        ar.string(prop);
+    }
+
+    ar.count(mCurves);
+    for (auto& curve : mCurves) {
+        ar.array(curve.points);
+        ar.string(curve.propertyName);
+        ar.value(curve.propertyIndex);
+        ar.value(curve.type);
+        ar.value(curve.unk);
+        ar.value(curve.unk2);
+        ar.value(curve.isGlobal);
+    }
+    ar.array(mRandomCalls);
+    ar.count(mArrangeGroupParams);
+    for (auto& params : mArrangeGroupParams) {
+        ar.array(params.groups);
+        for (auto& group : params.groups) {
+            ar.string(group.groupName);
+        }
+    }
+    ar.array(mDirectValues);
+    for (auto* pool : {&mAssetParams, &mTriggerOverwriteParams}) {
+        ar.count(*pool);
+        for (auto& set : *pool) {
+            ar.array(set.params);
+            TransferParamStrings(ar, set.params);
+        }
+    }
+    ar.array(mConditions);
+    for (auto& condition : mConditions) {
+        if (condition.parentContainerType == xlink2::ContainerType::Switch) {
+            ar.string(condition.getAs<xlink2::ContainerType::Switch>()->enumName);
+        }
+    }
+
+    u64 userCount = mUsers.size();
+    ar.value(userCount);
+    auto transferUser = [&](User& user) {
+        ar.array(user.mLocalProperties);
+        ar.array(user.mSortedAssetIds);
+        ar.array(user.mUserParams);
+        TransferContainers(ar, user.mContainers);
+        ar.array(user.mAssetCallTables);
+        ar.array(user.mActionSlots);
+        ar.array(user.mActions);
+        ar.array(user.mActionTriggers);
+        ar.array(user.mProperties);
+        ar.array(user.mPropertyTriggers);
+        ar.array(user.mAlwaysTriggers);
+        ar.value(user.mUnknown);
+        user.forEachString([&](std::string_view& str) { ar.string(str); });
+    };
+    if constexpr (Archive::cIsLoading) {
+        for (u64 i = 0; i < userCount; ++i) {
+            u32 hash = 0;
+            ar.value(hash);
+            transferUser(mUsers.emplace_hint(mUsers.end(), hash, User{})->second);
+        }
+    } else {
+        for (auto& [hash, user] : mUsers) {
+            u32 key = hash;
+            ar.value(key);
+            transferUser(user);
+        }
+    }
+}
+
+bool System::saveSnapshot(const std::string& path, u64 sourceHash) const {
+    SnapshotWriter writer;
+    // the transfer functions are shared with loading so they take everything by reference, nothing gets modified here
+    const_cast<System*>(this)->transferSnapshot(writer);
+
+    const auto& data = writer.getData();
+    const auto& strings = writer.getStrings();
+    const SnapshotHeader header{
+        .magic = cSnapshotMagic,
+        .version = cSnapshotVersion,
+        .layoutHash = CalcLayoutHash(sizeof(DirectValue), alignof(DirectValue)),
+        .sourceHash = sourceHash,
+        .dataOffset = sizeof(SnapshotHeader),
+        .dataSize = data.size(),
+        .stringsOffset = sizeof(SnapshotHeader) + data.size(),
+        .stringsSize = strings.size(),
+    };
+
+    util::OutputStream output;
+    if (!output.open(path)) {
+        return false;
+    }
+    output.write(&header, sizeof(header));
+    output.write(data.data(), data.size());
+    output.write(strings);
+    return output.close();
+}
+
+bool System::loadSnapshot(const std::string& path, u64 sourceHash) {
+    auto file = std::make_unique<util::MappedFile>();
+    if (!file->open(path) || file->size() < sizeof(SnapshotHeader)) {
+        return false;
+    }
+
+    SnapshotHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (header.magic != cSnapshotMagic || header.version != cSnapshotVersion || header.layoutHash != CalcLayoutHash(sizeof(DirectValue), alignof(DirectValue))
+        || header.sourceHash != sourceHash) {
+        return false;
+    }
+    if (header.dataOffset > file->size() || header.dataSize > file->size() - header.dataOffset
+        || header.stringsOffset > file->size() || header.stringsSize > file->size() - header.stringsOffset) {
+        std::cerr << "Snapshot is corrupted!\n";
+        return false;
+    }
+
+    // loaded off to the side so a bad snapshot leaves whatever was already here alone
+    System loaded{};
+    try {
+        SnapshotReader reader{
+            {file->data() + header.dataOffset, header.dataSize},
+            {reinterpret_cast<const char*>(file->data() + header.stringsOffset), header.stringsSize},
+        };
+        loaded.transferSnapshot(reader);
+        if (!reader.atEnd())
+            throw InvalidDataError("Snapshot has trailing data");
+    } catch (const std::exception& e) {
+        std::cerr << std::format("Failed to load snapshot: {}\n", e.what());
+        return false;
+    }
+
+    // every string in the model points into the mapping from here on
+    loaded.mSnapshot = std::move(file);
+    loaded.mNames = mNames;
+    *this = std::move(loaded);
+    return true;
+}
+
+} // namespace banana
@@ -1,18 +1,23 @@
 #include "system.h"
+#include "digest.h"
 #include "serializer.h"
 #include "util/error.h"
 #include "util/crc32.h"
+#include "util/dictionary.h"
+#include "util/hash.h"
 
 #include "usernames.inc"
 
+#include <algorithm>
 #include <bit>
 #include <iostream>
 #include <format>
+#include <ranges>
 #include <variant>
 
 namespace banana {
 
-bool System::initialize(void* data, size_t size) {
+bool System::initialize(void* data, size_t size, const std::set<u32>& onlyUsers, bool keepSource) {
     xlink2::ResourceHeader* header = reinterpret_cast<xlink2::ResourceHeader*>(data);
     if (header == nullptr || size != header->fileSize) {
         throw ResourceError("Invalid input resource");
@@ -29,6 +34,12 @@ bool System::initialize(void* data, size_t size) {
 
     mVersion = accessor.getResourceHeader()->version;
 
+    // keep a copy of the original bytes around so incremental serialization can reuse untouched ranges
+    mSource = {};
+    if (keepSource) {
+        mSource.data.assign(reinterpret_cast<const u8*>(data), reinterpret_cast<const u8*>(data) + size);
+    }
+
     // each define will just store a string_view of the string while the PDT will store a set of all strings
     const char* nameTable = accessor.getString(0);
     const char* pos = nameTable;
@@ -37,15 +48,23 @@ bool System::initialize(void* data, size_t size) {
     InitInfo info{};
 
     do {
-        auto res = mStrings.insert(std::string(pos));
+        const std::string_view str = addString(pos);
 #ifdef _MSC_VER
-        info.strings.emplace(pos - nameTable, std::string_view(*res.first)); // msvc appears to treat pos - nameTable as an s64?
+        info.strings.emplace(pos - nameTable, str); // msvc appears to treat pos - nameTable as an s64?
 #else
-        info.strings.emplace(reinterpret_cast<ptrdiff_t>(pos - nameTable), std::string_view(*res.first));
+        info.strings.emplace(reinterpret_cast<ptrdiff_t>(pos - nameTable), str);
 #endif
-        pos += (*res.first).size() + 1;
+        pos += str.size() + 1;
     } while (pos < end && *pos);
 
+    if (keepSource) {
+        const char* sourceNameTable = reinterpret_cast<const char*>(mSource.data.data()) + header->nameTablePos;
+        for (const auto& [strOffset, str] : info.strings) {
+            mSource.stringOffsets.emplace(std::string_view(sourceNameTable + strOffset, str.size()), strOffset);
+            mSource.nameTableSize = std::max(mSource.nameTableSize, static_cast<size_t>(strOffset) + str.size() + 1);
+        }
+    }
+
     mCurves.resize(header->numCurves);
     mRandomCalls.resize(header->numRandom);
     mDirectValues.resize(header->numDirectValues);
@@ -91,6 +110,7 @@ bool System::initialize(void* data, size_t size) {
 
     uintptr_t assets = reinterpret_cast<uintptr_t>(accessor.getAssetParamTable());
     uintptr_t start = assets;
+    mSource.assetParamTablePos = static_cast<TargetPointer>(assets - reinterpret_cast<uintptr_t>(data));
     uintptr_t assetsEnd = reinterpret_cast<uintptr_t>(accessor.getTriggerOverwriteParam(0));
     for (u32 i = 0; assets < assetsEnd; ++i) {
         auto param = reinterpret_cast<const xlink2::ResAssetParam*>(assets);
@@ -117,6 +137,7 @@ bool System::initialize(void* data, size_t size) {
             }
         }
         info.assetParams.emplace(assets - start, i);
+        mSource.assetParamOffsets.emplace_back(static_cast<TargetPointer>(assets - start));
         assets += sizeof(xlink2::ResAssetParam) + sizeof(xlink2::ResParam) * assetParamModel.params.size();
     }
 
@@ -149,6 +170,7 @@ bool System::initialize(void* data, size_t size) {
             }
         }
         info.triggerParams.emplace(offset, i);
+        mSource.triggerOverwriteParamOffsets.emplace_back(offset);
         offset += sizeof(xlink2::ResTriggerOverwriteParam) + sizeof(xlink2::ResParam) * triggerParamModel.params.size();
     }
 
@@ -160,6 +182,7 @@ bool System::initialize(void* data, size_t size) {
     u32 condI = 0;
     while (condBase + condOffset < condEnd) {
         condIdxMap.emplace(condOffset, condI);
+        mSource.conditionOffsets.emplace_back(condOffset);
         Condition cond{};
         auto conditionBase = reinterpret_cast<const xlink2::ResCondition*>(accessor.getCondition(condOffset));
         cond.parentContainerType = conditionBase->getType();
@@ -236,9 +259,31 @@ bool System::initialize(void* data, size_t size) {
         ++condI;
     }
 
+    // users are laid out back to back, each one runs up until the next one (or the condition table for the last)
+    std::vector<TargetPointer> userStarts{};
     for (size_t i = 0; i < static_cast<size_t>(header->numUsers); ++i) {
+        userStarts.emplace_back(static_cast<TargetPointer>(reinterpret_cast<uintptr_t>(accessor.getResUserHeader(i)) - reinterpret_cast<uintptr_t>(data)));
+    }
+    std::vector<TargetPointer> sortedUserStarts = userStarts;
+    std::ranges::sort(sortedUserStarts);
+    mSource.userRegionPos = sortedUserStarts.empty() ? header->conditionTablePos : sortedUserStarts.front();
+
+    for (size_t i = 0; i < static_cast<size_t>(header->numUsers); ++i) {
+        // skipped users never touch the pools, so whatever only they used just goes unreferenced
+        if (!onlyUsers.empty() && !onlyUsers.contains(accessor.getUserHash(i))) {
+            continue;
+        }
         auto res = mUsers.emplace(accessor.getUserHash(i), User());
-        (*res.first).second.initialize(this, accessor.getResUserHeader(i), info, condIdxMap, arrangeParams);
+        auto& user = (*res.first).second;
+        user.initialize(this, accessor.getResUserHeader(i), info, condIdxMap, arrangeParams);
+
+        const auto next = std::ranges::upper_bound(sortedUserStarts, userStarts[i]);
+        const TargetPointer userEnd = next == sortedUserStarts.end() ? header->conditionTablePos : *next;
+        if (keepSource) {
+            user.mSourceOffset = userStarts[i];
+            user.mSourceSize = userEnd - userStarts[i];
+        }
+        user.mDirty = false;
     }
 
     mArrangeGroupParams.resize(arrangeParams.size());
@@ -257,6 +302,7 @@ bool System::initialize(void* data, size_t size) {
             ++params;
         }
         paramIdxMap.emplace(paramOffset, i);
+        mSource.arrangeGroupParamOffsets.emplace_back(paramOffset);
         ++i;
     }
 
@@ -322,6 +368,12 @@ bool System::initialize(void* data, size_t size) {
         }
     }
 
+    mDirtyPools = 0;
+    // the offsets recorded along the way are useless without the bytes they point into
+    if (!keepSource) {
+        mSource = {};
+    }
+
     return true;
 }
 
@@ -329,6 +381,7 @@ const Curve& System::getCurve(s32 index) const {
     return mCurves[index];
 }
 Curve& System::getCurve(s32 index) {
+    markDirty(Pool::Curves);
     return mCurves[index];
 }
 
@@ -336,6 +389,7 @@ const Random& System::getRandomCall(s32 index) const {
     return mRandomCalls[index];
 }
 Random& System::getRandomCall(s32 index) {
+    markDirty(Pool::RandomCalls);
     return mRandomCalls[index];
 }
 
@@ -343,6 +397,7 @@ const ArrangeGroupParams& System::getArrangeGroupParams(s32 index) const {
     return mArrangeGroupParams[index];
 }
 ArrangeGroupParams& System::getArrangeGroupParams(s32 index) {
+    markDirty(Pool::ArrangeGroupParams);
     return mArrangeGroupParams[index];
 }
 
@@ -350,6 +405,7 @@ const ParamSet& System::getTriggerOverwriteParam(s32 index) const {
     return mTriggerOverwriteParams[index];
 }
 ParamSet& System::getTriggerOverwriteParam(s32 index) {
+    markDirty(Pool::TriggerOverwriteParams);
     return mTriggerOverwriteParams[index];
 }
 
@@ -357,6 +413,7 @@ const ParamSet& System::getAssetParam(s32 index) const {
     return mAssetParams[index];
 }
 ParamSet& System::getAssetParam(s32 index) {
+    markDirty(Pool::AssetParams);
     return mAssetParams[index];
 }
 
@@ -364,19 +421,24 @@ const User& System::getUser(u32 hash) const {
     return mUsers.at(hash);
 }
 User& System::getUser(u32 hash) {
-    return mUsers.at(hash);
+    auto& user = mUsers.at(hash);
+    user.markDirty();
+    return user;
 }
 const User& System::getUser(const std::string_view& key) const {
     return mUsers.at(util::calcCRC32(key));
 }
 User& System::getUser(const std::string_view& key) {
-    return mUsers.at(util::calcCRC32(key));
+    auto& user = mUsers.at(util::calcCRC32(key));
+    user.markDirty();
+    return user;
 }
 
 const Condition& System::getCondition(s32 index) const {
     return mConditions[index];
 }
 Condition& System::getCondition(s32 index) {
+    markDirty(Pool::Conditions);
     return mConditions[index];
 }
 
@@ -397,6 +459,28 @@ bool System::searchUser(u32 hash) const {
     return mUsers.find(hash) != mUsers.end();
 }
 
+void System::collectNames(util::NameDictionaryBuilder& builder) const {
+    using Section = util::NameDictionary::Section;
+    for (const auto& [hash, user] : mUsers) {
+        builder.add(Section::User, lookupUserName(hash));
+        for (const auto& act : user.mAssetCallTables) {
+            builder.add(Section::Key, act.keyName);
+        }
+        for (const auto& prop : user.mLocalProperties) {
+            builder.add(Section::Property, prop);
+        }
+        for (const auto& prop : user.mProperties) {
+            builder.add(Section::Property, prop.propertyName);
+        }
+        for (const auto& action : user.mActions) {
+            builder.add(Section::Action, action.actionName);
+        }
+    }
+    for (const auto& prop : mLocalProperties) {
+        builder.add(Section::Property, prop);
+    }
+}
+
 void System::printUser(const std::string_view username) const {
     if (!searchUser(username))
         return;
@@ -432,12 +516,96 @@ void System::printParam(const Param& param, ParamType type) const {
     }
 }
 
-std::vector<u8> System::serialize() {
-    Serializer writer(this);
+std::vector<u8> System::serialize(bool incremental) {
+    // nothing to reuse if this didn't come from a binary resource
+    incremental = incremental && !mSource.data.empty();
+    if (incremental) {
+        // the source name table is kept whole so strings nothing references anymore still take up space in it,
+        // once enough of it is dead a full rebuild (which only writes live strings) is worth losing the reuse for
+        size_t deadSize = 0;
+        for (const auto& str : mSource.stringOffsets | std::views::keys) {
+            if (!mStrings.contains(str)) {
+                deadSize += str.size() + 1;
+            }
+        }
+        incremental = deadSize * 4 <= mSource.nameTableSize;
+    }
+    Serializer writer(this, incremental);
     writer.serialize();
     return writer.flush();
 }
 
+u64 System::calcPoolHash(Pool pool) const {
+    util::XXHash64 hasher;
+    switch (pool) {
+        case Pool::AssetParams:
+            digestRange(hasher, mAssetParams);
+            break;
+        case Pool::TriggerOverwriteParams:
+            digestRange(hasher, mTriggerOverwriteParams);
+            break;
+        case Pool::DirectValues:
+            digestValue(hasher, static_cast<u32>(mDirectValues.size()));
+            for (const auto& value : mDirectValues) {
+                digestValue(hasher, value.type.u);
+                digestValue(hasher, value.value.u);
+            }
+            break;
+        case Pool::RandomCalls:
+            digestRange(hasher, mRandomCalls);
+            break;
+        case Pool::Curves:
+            digestRange(hasher, mCurves);
+            break;
+        case Pool::ArrangeGroupParams:
+            digestRange(hasher, mArrangeGroupParams);
+            break;
+        case Pool::Conditions:
+            digestRange(hasher, mConditions);
+            break;
+        default:
+            break;
+    }
+    return hasher.digest();
+}
+
+u64 System::getContentHash() const {
+    util::XXHash64 hasher;
+    digestValue(hasher, mVersion);
+
+    // the pdt and local property lists are small enough to just rehash every time
+    digest(hasher, mPDT);
+    digestValue(hasher, static_cast<u32>(mLocalProperties.size()));
+    for (const auto& name : mLocalProperties) {
+        digestString(hasher, name);
+    }
+    digestValue(hasher, static_cast<u32>(mLocalPropertyEnumStrings.size()));
+    for (const auto& name : mLocalPropertyEnumStrings) {
+        digestString(hasher, name);
+    }
+
+    for (u32 i = 0; i < static_cast<u32>(Pool::Count); ++i) {
+        if ((mHashedPools >> i & 1) == 0) {
+            mPoolHashes[i] = calcPoolHash(static_cast<Pool>(i));
+            mHashedPools |= 1u << i;
+        }
+        digestValue(hasher, mPoolHashes[i]);
+    }
+
+    // the string table isn't hashed on its own, everything that's actually referenced is hashed by value already
+    digestValue(hasher, static_cast<u32>(mUsers.size()));
+    for (const auto& [hash, user] : mUsers) {
+        digestValue(hasher, hash);
+        digestValue(hasher, user.getContentHash());
+    }
+
+    return hasher.digest();
+}
+
+u64 System::getUserContentHash(u32 hash) const {
+    return mUsers.at(hash).getContentHash();
+}
+
 bool System::addAssetCall(User& user, const AssetCallTable& act) {
     if (act.isContainer()) {
         if (act.containerParamIdx < 0 || static_cast<u32>(act.containerParamIdx) >= user.mContainers.size()) {
@@ -452,10 +620,10 @@ bool System::addAssetCall(User& user, const AssetCallTable& act) {
         return false;
     }
 
-    auto res = mStrings.insert(std::string(act.keyName));
-    const_cast<AssetCallTable*>(&act)->keyName = *res.first;
+    const_cast<AssetCallTable*>(&act)->keyName = addString(act.keyName);
 
     user.mAssetCallTables.emplace_back(act);
+    user.markDirty();
 
     return true;
 }
@@ -475,21 +643,22 @@ bool System::addAssetCall(User& user, const std::string_view& key, bool isContai
         return false;
     }
 
-    auto res = mStrings.insert(std::string(key));
+    const std::string_view keyName = addString(key);
 
     user.mAssetCallTables.emplace_back(
         AssetCallTable{
-            .keyName = *res.first,
+            .keyName = keyName,
             .assetIndex = 0, // doesn't matter, it'll be determined when serializing
             .flag = static_cast<u16>(isContainer ? 1 : 0),
             .duration = 1,
             .parentIndex = -1,
             .guid = 0x69420,
-            .keyNameHash = util::calcCRC32(*res.first),
+            .keyNameHash = util::calcCRC32(keyName),
             .assetParamIdx = paramIdx,
             .conditionIdx = conditionIdx,
         }
     );
+    user.markDirty();
 
     return true;
 }
@@ -499,23 +668,25 @@ bool System::addAssetCall(User& user, const std::string_view& key, const ParamSe
         return false;
     }
 
-    auto res = mStrings.insert(std::string(key));
+    const std::string_view keyName = addString(key);
 
     mAssetParams.emplace_back(assetParam);
+    markDirty(Pool::AssetParams);
 
     user.mAssetCallTables.emplace_back(
         AssetCallTable{
-            .keyName = *res.first,
+            .keyName = keyName,
             .assetIndex = 0, // doesn't matter, it'll be determined when serializing
             .flag = 0,
             .duration = 1,
             .parentIndex = -1,
             .guid = 0x69420,
-            .keyNameHash = util::calcCRC32(*res.first),
+            .keyNameHash = util::calcCRC32(keyName),
             .assetParamIdx = static_cast<s32>(mAssetParams.size() - 1),
             .conditionIdx = conditionIdx,
         }
     );
+    user.markDirty();
 
     return true;
 }
@@ -525,23 +696,24 @@ bool System::addAssetCall(User& user, const std::string_view& key, const Contain
         return false;
     }
 
-    auto res = mStrings.insert(std::string(key));
+    const std::string_view keyName = addString(key);
 
     user.mContainers.emplace_back(container);
 
     user.mAssetCallTables.emplace_back(
         AssetCallTable{
-            .keyName = *res.first,
+            .keyName = keyName,
             .assetIndex = 0, // doesn't matter, it'll be determined when serializing
             .flag = 1,
             .duration = 1,
             .parentIndex = -1,
             .guid = 0x69420,
-            .keyNameHash = util::calcCRC32(*res.first),
+            .keyNameHash = util::calcCRC32(keyName),
             .assetParamIdx = static_cast<s32>(user.mContainers.size() - 1),
             .conditionIdx = conditionIdx,
         }
     );
+    user.markDirty();
 
     return true;
 }
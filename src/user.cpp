@@ -1,5 +1,7 @@
 #include "user.h"
 #include "system.h"
+#include "digest.h"
+#include "util/hash.h"
 #include "util/error.h"
 
 #include <cstring> // memcpy
@@ -272,4 +274,31 @@ bool User::initialize(System* sys, const xlink2::ResUserHeader* res,
     return true;
 }
 
+u64 User::getContentHash() const {
+    if (mHasContentHash) {
+        return mContentHash;
+    }
+
+    util::XXHash64 hasher;
+    digestValue(hasher, static_cast<u32>(mLocalProperties.size()));
+    for (const auto& name : mLocalProperties) {
+        digestString(hasher, name);
+    }
+    // mSortedAssetIds is left out, only the binary loader fills it in and the serializer rebuilds the order anyway
+    digestRange(hasher, mUserParams);
+    digestRange(hasher, mContainers);
+    digestRange(hasher, mAssetCallTables);
+    digestRange(hasher, mActionSlots);
+    digestRange(hasher, mActions);
+    digestRange(hasher, mActionTriggers);
+    digestRange(hasher, mProperties);
+    digestRange(hasher, mPropertyTriggers);
+    digestRange(hasher, mAlwaysTriggers);
+    digestValue(hasher, mUnknown);
+
+    mContentHash = hasher.digest();
+    mHasContentHash = true;
+    return mContentHash;
+}
+
 } // namespace banana
\ No newline at end of file
@@ -1,42 +1,214 @@
 #include "util/crc32.h"
 
-namespace util {
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32_HAS_CLMUL 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC32_TARGET_CLMUL
+#else
+#include <cpuid.h>
+#define CRC32_TARGET_CLMUL __attribute__((target("pclmul,sse4.1")))
+#endif
+#endif
 
-constexpr std::array<u32, 0x100> initializeCRC32Table() {
-    std::array<u32, 0x100> table{};
+namespace util {
 
-    for (u32 i = 0; i < table.size(); ++i) {
-        u32 value = i;
-        for (u32 j = 0; j < 8; ++j) {
-            value = ((value & 1) == 0) ? (value >> 1) : (0xedb88320 ^ (value >> 1));
+// cSliceTables[n][b] is the crc of byte b followed by n zero bytes, so 16 bytes can be folded in with one lookup each
+static constexpr auto cSliceTables = [] {
+    std::array<std::array<u32, 0x100>, 16> tables{};
+    tables[0] = cCRC32Table;
+    for (u32 n = 1; n < tables.size(); ++n) {
+        for (u32 i = 0; i < 0x100; ++i) {
+            tables[n][i] = (tables[n - 1][i] >> 8) ^ cCRC32Table[tables[n - 1][i] & 0xff];
         }
-        table[i] = value;
     }
+    return tables;
+}();
+
+static u32 load32(const u8* ptr) {
+    u32 value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static u32 updateBytes(u32 hash, const u8* ptr, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash = cCRC32Table[ptr[i] ^ (hash & 0xff)] ^ (hash >> 8);
+    }
+    return hash;
+}
 
-    return table;
+// folds 8 bytes into the hash
+static u32 step8(u32 hash, const u8* ptr) {
+    const auto& t = cSliceTables;
+    const u32 a = load32(ptr) ^ hash;
+    const u32 b = load32(ptr + 4);
+    return t[7][a & 0xff] ^ t[6][a >> 8 & 0xff] ^ t[5][a >> 16 & 0xff] ^ t[4][a >> 24]
+         ^ t[3][b & 0xff] ^ t[2][b >> 8 & 0xff] ^ t[1][b >> 16 & 0xff] ^ t[0][b >> 24];
 }
 
-static constexpr std::array<u32, 0x100> sCRC32Table = initializeCRC32Table();
+static u32 updateSlice16(u32 hash, const u8* ptr, size_t size) {
+    // the tables assume the words are read little endian
+    if constexpr (std::endian::native != std::endian::little) {
+        return updateBytes(hash, ptr, size);
+    }
 
-u32 calcCRC32(const char* str) {
-    u32 hash = 0xffffffff;
+    const auto& t = cSliceTables;
+    for (; size >= 16; ptr += 16, size -= 16) {
+        const u32 a = load32(ptr) ^ hash;
+        const u32 b = load32(ptr + 4);
+        const u32 c = load32(ptr + 8);
+        const u32 d = load32(ptr + 12);
+        hash = t[15][a & 0xff] ^ t[14][a >> 8 & 0xff] ^ t[13][a >> 16 & 0xff] ^ t[12][a >> 24]
+             ^ t[11][b & 0xff] ^ t[10][b >> 8 & 0xff] ^ t[9][b >> 16 & 0xff] ^ t[8][b >> 24]
+             ^ t[7][c & 0xff] ^ t[6][c >> 8 & 0xff] ^ t[5][c >> 16 & 0xff] ^ t[4][c >> 24]
+             ^ t[3][d & 0xff] ^ t[2][d >> 8 & 0xff] ^ t[1][d >> 16 & 0xff] ^ t[0][d >> 24];
+    }
+    if (size >= 8) {
+        hash = step8(hash, ptr);
+        ptr += 8;
+        size -= 8;
+    }
+    return updateBytes(hash, ptr, size);
+}
 
-    const u8* ptr = reinterpret_cast<const u8*>(str);
-    while (*ptr)
-        hash = sCRC32Table[*ptr++ ^ (hash & 0xff)] ^ (hash >> 8);
-    
-    return ~hash;
+#ifdef CRC32_HAS_CLMUL
+
+static bool hasCLMUL() {
+    static const bool supported = [] {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        const u32 ecx = static_cast<u32>(info[2]);
+#else
+        u32 eax, ebx, ecx, edx;
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+            return false;
+#endif
+        // pclmulqdq and sse4.1 (for the final extract)
+        return (ecx >> 1 & 1) != 0 && (ecx >> 19 & 1) != 0;
+    }();
+    return supported;
 }
 
-u32 calcCRC32(const std::string_view str) {
-    u32 hash = 0xffffffff;
+// x times k folded onto the next block
+CRC32_TARGET_CLMUL static __m128i fold(__m128i x, __m128i k, __m128i next) {
+    return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), _mm_clmulepi64_si128(x, k, 0x00)), next);
+}
+
+// folds 64 bytes at a time with carry-less multiplies and barrett reduces what's left at the end
+// (intel's "fast crc computation for generic polynomials using pclmulqdq", constants are for the reflected 0x04c11db7)
+// size has to be at least 64, only whole 16 byte blocks are consumed and the number of bytes used is returned
+CRC32_TARGET_CLMUL static size_t updateCLMUL(u32& hash, const u8* ptr, size_t size) {
+    alignas(16) static constexpr u64 cK1K2[] = { 0x0154442bd4, 0x01c6e41596 };
+    alignas(16) static constexpr u64 cK3K4[] = { 0x01751997d0, 0x00ccaa009e };
+    alignas(16) static constexpr u64 cK5K0[] = { 0x0163cd6124, 0x0000000000 };
+    alignas(16) static constexpr u64 cPoly[] = { 0x01db710641, 0x01f7011641 };
+
+    const u8* const start = ptr;
+    const auto load = [](const u8* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
 
-    const u8* ptr = reinterpret_cast<const u8*>(str.data());
-    for (size_t i = 0; i < str.size(); ++i) {
-        hash = sCRC32Table[*ptr++ ^ (hash & 0xff)] ^ (hash >> 8);
+    __m128i x1 = _mm_xor_si128(load(ptr), _mm_cvtsi32_si128(static_cast<s32>(hash)));
+    __m128i x2 = load(ptr + 0x10);
+    __m128i x3 = load(ptr + 0x20);
+    __m128i x4 = load(ptr + 0x30);
+    ptr += 64;
+    size -= 64;
+
+    __m128i k = _mm_load_si128(reinterpret_cast<const __m128i*>(cK1K2));
+    for (; size >= 64; ptr += 64, size -= 64) {
+        x1 = fold(x1, k, load(ptr));
+        x2 = fold(x2, k, load(ptr + 0x10));
+        x3 = fold(x3, k, load(ptr + 0x20));
+        x4 = fold(x4, k, load(ptr + 0x30));
     }
 
-    return ~hash;
+    // down to a single 128-bit lane, then any whole blocks left over
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(cK3K4));
+    x1 = fold(x1, k, x2);
+    x1 = fold(x1, k, x3);
+    x1 = fold(x1, k, x4);
+    for (; size >= 16; ptr += 16, size -= 16) {
+        x1 = fold(x1, k, load(ptr));
+    }
+
+    // 128 -> 64 bits
+    const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(cK5K0));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00), x2);
+
+    // barrett reduction to 32 bits
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(cPoly));
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    hash = static_cast<u32>(_mm_extract_epi32(x1, 1));
+    return static_cast<size_t>(ptr - start);
+}
+
+#endif
+
+static u32 update(u32 hash, const u8* ptr, size_t size) {
+#ifdef CRC32_HAS_CLMUL
+    // folding has a fixed cost at the end, names are almost always too short for it to pay off
+    if (size >= 128 && hasCLMUL()) {
+        const size_t used = updateCLMUL(hash, ptr, size);
+        ptr += used;
+        size -= used;
+    }
+#endif
+    return updateSlice16(hash, ptr, size);
+}
+
+u32 calcCRC32(const char* str) {
+    return calcCRC32(std::string_view(str));
+}
+
+u32 calcCRC32(const std::string_view str) {
+    return ~update(0xffffffff, reinterpret_cast<const u8*>(str.data()), str.size());
+}
+
+void calcCRC32(std::span<const std::string_view> strs, std::span<u32> out) {
+    constexpr size_t cLanes = 4;
+
+    size_t i = 0;
+    if constexpr (std::endian::native == std::endian::little) {
+        for (; i + cLanes <= strs.size(); i += cLanes) {
+            u32 hashes[cLanes];
+            const u8* ptrs[cLanes];
+            size_t common = SIZE_MAX;
+            for (size_t lane = 0; lane < cLanes; ++lane) {
+                hashes[lane] = 0xffffffff;
+                ptrs[lane] = reinterpret_cast<const u8*>(strs[i + lane].data());
+                common = std::min(common, strs[i + lane].size());
+            }
+            // every lane steps together while they all have a full 8 bytes left, the lookups for one lane don't
+            // depend on the others so they overlap instead of waiting on each other like a single string does
+            for (size_t n = 0; n < common / 8; ++n) {
+                for (size_t lane = 0; lane < cLanes; ++lane) {
+                    hashes[lane] = step8(hashes[lane], ptrs[lane]);
+                    ptrs[lane] += 8;
+                }
+            }
+            for (size_t lane = 0; lane < cLanes; ++lane) {
+                const size_t done = common / 8 * 8;
+                out[i + lane] = ~update(hashes[lane], ptrs[lane], strs[i + lane].size() - done);
+            }
+        }
+    }
+    for (; i < strs.size(); ++i) {
+        out[i] = calcCRC32(strs[i]);
+    }
 }
 
-} // namespace util
\ No newline at end of file
+} // namespace util
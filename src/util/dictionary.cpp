@@ -0,0 +1,191 @@
+#include "util/dictionary.h"
+#include "util/crc32.h"
+#include "util/hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace util {
+
+static_assert(sizeof(NameDictionary::Header) == 0x60);
+
+// the arrays are read in place, so they have to be aligned and inside the file
+// (the file is written in native byte order, a dictionary from a big endian machine just fails the magic check)
+static bool checkArray(size_t fileSize, u32 offset, u64 count) {
+    return offset % alignof(u32) == 0 && offset + count * sizeof(u32) <= fileSize;
+}
+
+bool NameDictionary::open(const std::string& path) {
+    mHeader = nullptr;
+    if (!mFile.open(path)) {
+        std::cerr << "Failed to open dictionary " << path << "\n";
+        return false;
+    }
+
+    const auto* header = reinterpret_cast<const Header*>(mFile.data());
+    if (mFile.size() < sizeof(Header) || header->magic != cMagic || header->version != cVersion) {
+        std::cerr << path << " is not a name dictionary\n";
+        mFile.close();
+        return false;
+    }
+    for (const auto& section : header->sections) {
+        const bool valid = checkArray(mFile.size(), section.hashesOffset, section.count)
+                        && checkArray(mFile.size(), section.offsetsOffset, static_cast<u64>(section.count) + 1)
+                        && static_cast<u64>(section.blobOffset) + section.blobSize <= mFile.size();
+        if (!valid) {
+            std::cerr << path << " is truncated or corrupt\n";
+            mFile.close();
+            return false;
+        }
+    }
+
+    mHeader = header;
+    return true;
+}
+
+std::string_view NameDictionary::getName(const SectionHeader& section, u32 index) const {
+    const u32* offsets = getArray(section.offsetsOffset);
+    const u32 begin = offsets[index];
+    const u32 end = offsets[index + 1];
+    if (begin > end || end > section.blobSize) {
+        return {};
+    }
+    return {reinterpret_cast<const char*>(mFile.data()) + section.blobOffset + begin, end - begin};
+}
+
+std::optional<u32> NameDictionary::findIndex(const SectionHeader& section, u32 hash) const {
+    if (section.count == 0) {
+        return std::nullopt;
+    }
+
+    // branchless lower bound, same as the compiled in user name tables
+    const u32* hashes = getArray(section.hashesOffset);
+    const u32* base = hashes;
+    u32 size = section.count;
+    while (size > 1) {
+        const u32 half = size / 2;
+        base = base[half] < hash ? base + half : base;
+        size -= half;
+    }
+    const u32 index = static_cast<u32>(base - hashes) + (*base < hash ? 1 : 0);
+    if (index == section.count || hashes[index] != hash) {
+        return std::nullopt;
+    }
+    return index;
+}
+
+std::string_view NameDictionary::findName(Section section, u32 hash) const {
+    if (mHeader == nullptr) {
+        return {};
+    }
+    const auto& info = mHeader->sections[static_cast<size_t>(section)];
+    const auto index = findIndex(info, hash);
+    return index ? getName(info, *index) : std::string_view{};
+}
+
+std::optional<u32> NameDictionary::findHash(Section section, std::string_view name) const {
+    if (mHeader == nullptr) {
+        return std::nullopt;
+    }
+    // only the first name added for a hash is stored, so a colliding name has to be told apart from it
+    const u32 hash = calcCRC32(name);
+    const auto& info = mHeader->sections[static_cast<size_t>(section)];
+    const auto index = findIndex(info, hash);
+    if (!index || getName(info, *index) != name) {
+        return std::nullopt;
+    }
+    return hash;
+}
+
+u32 NameDictionary::getCount(Section section) const {
+    return mHeader == nullptr ? 0 : mHeader->sections[static_cast<size_t>(section)].count;
+}
+
+u64 NameDictionary::getContentHash() const {
+    return mHeader == nullptr ? 0 : mHeader->contentHash;
+}
+
+void NameDictionaryBuilder::add(Section section, std::string_view name) {
+    if (!name.empty()) {
+        mNames[static_cast<size_t>(section)].try_emplace(calcCRC32(name), name);
+    }
+}
+
+void NameDictionaryBuilder::addList(std::string_view text) {
+    static constexpr std::pair<std::string_view, Section> cHeaders[] = {
+        { "Users:", Section::User },
+        { "ELink:", Section::User },
+        { "SLink:", Section::User },
+        { "Keys:", Section::Key },
+        { "Properties:", Section::Property },
+        { "Actions:", Section::Action },
+    };
+
+    Section current = Section::User;
+    while (!text.empty()) {
+        const size_t end = std::min(text.find('\n'), text.size());
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(std::min(end + 1, text.size()));
+
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos) {
+            continue;
+        }
+        line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+
+        const auto header = std::ranges::find(cHeaders, line, &std::pair<std::string_view, Section>::first);
+        if (header != std::end(cHeaders)) {
+            current = header->second;
+        } else {
+            add(current, line);
+        }
+    }
+}
+
+std::vector<u8> NameDictionaryBuilder::build() const {
+    std::vector<u8> data(sizeof(NameDictionary::Header));
+    const auto append = [&data](const void* src, size_t size) {
+        const size_t offset = data.size();
+        data.resize(offset + size);
+        if (size != 0) {
+            std::memcpy(data.data() + offset, src, size);
+        }
+        return static_cast<u32>(offset);
+    };
+
+    NameDictionary::Header header{};
+    header.magic = NameDictionary::cMagic;
+    header.version = NameDictionary::cVersion;
+    for (size_t i = 0; i < mNames.size(); ++i) {
+        const auto& names = mNames[i];
+        auto& section = header.sections[i];
+
+        // the map is already in hash order
+        std::vector<u32> hashes;
+        std::vector<u32> offsets;
+        std::string blob;
+        hashes.reserve(names.size());
+        offsets.reserve(names.size() + 1);
+        for (const auto& [hash, name] : names) {
+            hashes.push_back(hash);
+            offsets.push_back(static_cast<u32>(blob.size()));
+            blob += name;
+        }
+        offsets.push_back(static_cast<u32>(blob.size()));
+
+        section.count = static_cast<u32>(names.size());
+        section.hashesOffset = append(hashes.data(), hashes.size() * sizeof(u32));
+        section.offsetsOffset = append(offsets.data(), offsets.size() * sizeof(u32));
+        section.blobOffset = append(blob.data(), blob.size());
+        section.blobSize = static_cast<u32>(blob.size());
+        // keeps the next section's arrays aligned
+        data.resize((data.size() + alignof(u32) - 1) & ~(alignof(u32) - 1));
+    }
+
+    header.contentHash = calcXXHash64(data.data() + sizeof(header), data.size() - sizeof(header));
+    std::memcpy(data.data(), &header, sizeof(header));
+    return data;
+}
+
+} // namespace util
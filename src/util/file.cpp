@@ -2,10 +2,20 @@
 
 #include <zstd.h>
 
+#include <algorithm>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace util {
 
 bool loadFile(const std::string& path, std::vector<u8>& buffer) {
@@ -85,6 +95,33 @@ bool loadFileWithDecomp(const std::string& path, std::vector<u8>& buffer, const
     }
 }
 
+bool loadFileStreamed(const std::string& path, std::vector<u8>& buffer) {
+    InputStream input;
+    if (!input.open(path)) {
+        return false;
+    }
+
+    // one past the hint so reading the end doesn't have to grow the buffer
+    size_t size = 0;
+    buffer.resize(std::max<size_t>(input.getSizeHint() + 1, 0x10000));
+    while (true) {
+        if (size == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+        const size_t count = input.read(buffer.data() + size, buffer.size() - size);
+        if (count == 0) {
+            break;
+        }
+        size += count;
+    }
+    buffer.resize(size);
+    // compressed input without a content size grew by doubling, don't keep the slack around
+    if (buffer.capacity() - size > size / 4) {
+        buffer.shrink_to_fit();
+    }
+    return !input.hasFailed();
+}
+
 void writeFile(const std::string& path, const std::span<const u8>& data, bool compress, const std::span<const u8>& dict) {
     std::vector<u8> fileData{};
     if (compress && !dict.empty()) {
@@ -107,4 +144,303 @@ void writeFile(const std::string& path, const std::span<const u8>& data, bool co
     file.close();
 }
 
+bool OutputStream::open(const std::string& path, bool compress, s32 level) {
+    close();
+
+    if (path == "-") {
+        return open(stdout, compress, level);
+    }
+
+    mFile = std::fopen(path.c_str(), "wb");
+    if (mFile == nullptr) {
+        return false;
+    }
+    mOwnsFile = true;
+    mFailed = false;
+    return !compress || initCompression(level);
+}
+
+bool OutputStream::open(FILE* file, bool compress, s32 level) {
+    close();
+
+    if (file == nullptr) {
+        return false;
+    }
+    mFile = file;
+    mOwnsFile = false;
+    mFailed = false;
+    return !compress || initCompression(level);
+}
+
+bool OutputStream::initCompression(s32 level) {
+    mStream = ZSTD_createCStream();
+    if (mStream == nullptr || ZSTD_isError(ZSTD_CCtx_setParameter(mStream, ZSTD_c_compressionLevel, level))) {
+        ZSTD_freeCStream(mStream);
+        mStream = nullptr;
+        close();
+        return false;
+    }
+    mCompressBuffer.resize(ZSTD_CStreamOutSize());
+    return true;
+}
+
+void OutputStream::write(const void* data, size_t size) {
+    if (mFile == nullptr || mFailed || size == 0) {
+        return;
+    }
+
+    if (mStream != nullptr) {
+        writeCompressed(data, size, false);
+    } else if (std::fwrite(data, 1, size, mFile) != size) {
+        mFailed = true;
+    }
+}
+
+void OutputStream::writeCompressed(const void* data, size_t size, bool end) {
+    ZSTD_inBuffer input{data, size, 0};
+    // keep going until all the input is consumed (and when ending, until the frame is fully flushed)
+    while (true) {
+        ZSTD_outBuffer output{mCompressBuffer.data(), mCompressBuffer.size(), 0};
+        const size_t remaining = ZSTD_compressStream2(mStream, &output, &input, end ? ZSTD_e_end : ZSTD_e_continue);
+        if (ZSTD_isError(remaining) || std::fwrite(mCompressBuffer.data(), 1, output.pos, mFile) != output.pos) {
+            mFailed = true;
+            return;
+        }
+        if (end ? remaining == 0 : input.pos == input.size) {
+            return;
+        }
+    }
+}
+
+bool OutputStream::close() {
+    if (mFile == nullptr) {
+        return false;
+    }
+
+    if (mStream != nullptr) {
+        if (!mFailed) {
+            writeCompressed(nullptr, 0, true);
+        }
+        ZSTD_freeCStream(mStream);
+        mStream = nullptr;
+    }
+    mCompressBuffer = {};
+
+    if (std::fflush(mFile) != 0) {
+        mFailed = true;
+    }
+    if (mOwnsFile && std::fclose(mFile) != 0) {
+        mFailed = true;
+    }
+    mFile = nullptr;
+    mOwnsFile = false;
+    return !mFailed;
+}
+
+bool InputStream::open(const std::string& path) {
+    close();
+
+    if (path == "-") {
+        return open(stdin);
+    }
+
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    if (!open(file)) {
+        std::fclose(file);
+        return false;
+    }
+    mOwnsFile = true;
+    return true;
+}
+
+bool InputStream::open(FILE* file) {
+    close();
+
+    if (file == nullptr) {
+        return false;
+    }
+    mFile = file;
+    mOwnsFile = false;
+    mFailed = false;
+
+    // pipes can't seek, they just don't get a hint
+    const long start = std::ftell(mFile);
+    if (start >= 0 && std::fseek(mFile, 0, SEEK_END) == 0) {
+        const long end = std::ftell(mFile);
+        std::fseek(mFile, start, SEEK_SET);
+        mSizeHint = end > start ? static_cast<size_t>(end - start) : 0;
+    }
+
+    // the first block decides whether this is compressed, it's handed out by read either way
+    mInputBuffer.resize(ZSTD_DStreamInSize());
+    fill();
+    if (mInputSize >= sizeof(u32) && *reinterpret_cast<const u32*>(mInputBuffer.data()) == ZSTD_MAGICNUMBER) {
+        mStream = ZSTD_createDStream();
+        if (mStream == nullptr) {
+            close();
+            return false;
+        }
+        const u64 contentSize = ZSTD_getFrameContentSize(mInputBuffer.data(), mInputSize);
+        mSizeHint = contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize == ZSTD_CONTENTSIZE_ERROR ? 0 : contentSize;
+    }
+    return !mFailed;
+}
+
+void InputStream::close() {
+    if (mStream != nullptr) {
+        ZSTD_freeDStream(mStream);
+        mStream = nullptr;
+    }
+    mInputBuffer = {};
+    mInputPos = 0;
+    mInputSize = 0;
+    mSizeHint = 0;
+    mFrameEnded = false;
+
+    if (mOwnsFile && mFile != nullptr) {
+        std::fclose(mFile);
+    }
+    mFile = nullptr;
+    mOwnsFile = false;
+}
+
+bool InputStream::fill() {
+    mInputPos = 0;
+    mInputSize = std::fread(mInputBuffer.data(), 1, mInputBuffer.size(), mFile);
+    if (mInputSize == 0 && std::ferror(mFile)) {
+        mFailed = true;
+    }
+    return mInputSize != 0;
+}
+
+size_t InputStream::read(void* data, size_t size) {
+    if (mFile == nullptr || mFailed || size == 0) {
+        return 0;
+    }
+
+    if (mStream == nullptr) {
+        // whatever was read to check for the magic goes out first
+        size_t count = std::min(size, mInputSize - mInputPos);
+        std::memcpy(data, mInputBuffer.data() + mInputPos, count);
+        mInputPos += count;
+        if (count < size) {
+            count += std::fread(static_cast<u8*>(data) + count, 1, size - count, mFile);
+            if (std::ferror(mFile)) {
+                mFailed = true;
+            }
+        }
+        return count;
+    }
+
+    ZSTD_outBuffer output{data, size, 0};
+    while (output.pos < output.size) {
+        // nothing is left buffered in the decoder between frames, so running out of input there is just the end
+        if (mInputPos == mInputSize && mFrameEnded && !fill()) {
+            break;
+        }
+        ZSTD_inBuffer input{mInputBuffer.data(), mInputSize, mInputPos};
+        const size_t remaining = ZSTD_decompressStream(mStream, &output, &input);
+        mInputPos = input.pos;
+        if (ZSTD_isError(remaining)) {
+            mFailed = true;
+            return 0;
+        }
+        mFrameEnded = remaining == 0;
+        if (output.pos == output.size) {
+            break;
+        }
+        // the decoder flushed everything it could out of what it had, so it needs more input
+        if (mInputPos == mInputSize && !fill()) {
+            // running out in the middle of a frame means the file was cut short
+            if (!mFrameEnded) {
+                mFailed = true;
+            }
+            break;
+        }
+    }
+    return output.pos;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    mFile = file;
+    mMapping = mapping;
+    mData = static_cast<u8*>(view);
+    mSize = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    mFd = fd;
+    mData = static_cast<u8*>(view);
+    mSize = static_cast<size_t>(st.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::close() {
+    if (mData == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(mData);
+    CloseHandle(mMapping);
+    CloseHandle(mFile);
+    mMapping = nullptr;
+    mFile = nullptr;
+#else
+    munmap(mData, mSize);
+    ::close(mFd);
+    mFd = -1;
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+}
+
 } // namespace util
\ No newline at end of file
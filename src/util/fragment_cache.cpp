@@ -0,0 +1,94 @@
+#include "util/fragment_cache.h"
+#include "util/file.h"
+
+#include <cstring>
+#include <vector>
+
+namespace util {
+
+static constexpr u32 cCacheMagic = 0x48434658; // XFCH
+static constexpr u32 cCacheVersion = 1;
+
+struct CacheHeader {
+    u32 magic;
+    u32 version;
+    u64 context;
+    u64 count;
+};
+
+struct CacheEntryHeader {
+    u64 key;
+    u64 size;
+};
+
+void FragmentCache::load(const std::string& path, u64 context) {
+    std::lock_guard lock(mMutex);
+    mContext = context;
+    mPrevious.clear();
+    mCurrent.clear();
+
+    std::vector<u8> buffer{};
+    if (!loadFile(path, buffer) || buffer.size() < sizeof(CacheHeader)) {
+        return;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (header.magic != cCacheMagic || header.version != cCacheVersion || header.context != context) {
+        return;
+    }
+
+    size_t offset = sizeof(header);
+    mPrevious.reserve(header.count);
+    for (u64 i = 0; i < header.count; ++i) {
+        CacheEntryHeader entry;
+        if (buffer.size() - offset < sizeof(entry)) {
+            break;
+        }
+        std::memcpy(&entry, buffer.data() + offset, sizeof(entry));
+        offset += sizeof(entry);
+        if (buffer.size() - offset < entry.size) {
+            break; // truncated, keep whatever was complete
+        }
+        mPrevious.try_emplace(entry.key, reinterpret_cast<const char*>(buffer.data() + offset), entry.size);
+        offset += entry.size;
+    }
+}
+
+bool FragmentCache::save(const std::string& path) const {
+    std::lock_guard lock(mMutex);
+
+    OutputStream output;
+    if (!output.open(path)) {
+        return false;
+    }
+
+    const CacheHeader header{ cCacheMagic, cCacheVersion, mContext, mCurrent.size() };
+    output.write(&header, sizeof(header));
+    for (const auto& [key, fragment] : mCurrent) {
+        const CacheEntryHeader entry{ key, fragment.size() };
+        output.write(&entry, sizeof(entry));
+        output.write(fragment);
+    }
+    return output.close();
+}
+
+std::string_view FragmentCache::find(u64 key) {
+    std::lock_guard lock(mMutex);
+    if (const auto it = mCurrent.find(key); it != mCurrent.end()) {
+        return it->second;
+    }
+    // moved over rather than copied, the node (and the string in it) stays where it is
+    auto node = mPrevious.extract(key);
+    if (node.empty()) {
+        return {};
+    }
+    return mCurrent.insert(std::move(node)).position->second;
+}
+
+void FragmentCache::store(u64 key, std::string fragment) {
+    std::lock_guard lock(mMutex);
+    mCurrent.insert_or_assign(key, std::move(fragment));
+}
+
+} // namespace util
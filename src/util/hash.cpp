@@ -0,0 +1,127 @@
+#include "util/hash.h"
+
+#include <bit>
+#include <cstring>
+
+namespace util {
+
+static constexpr u64 cPrime1 = 0x9e3779b185ebca87ull;
+static constexpr u64 cPrime2 = 0xc2b2ae3d27d4eb4full;
+static constexpr u64 cPrime3 = 0x165667b19e3779f9ull;
+static constexpr u64 cPrime4 = 0x85ebca77c2b2ae63ull;
+static constexpr u64 cPrime5 = 0x27d4eb2f165667c5ull;
+
+// assumes little endian like the rest of the tool
+static inline u64 read64(const u8* ptr) {
+    u64 value;
+    std::memcpy(&value, ptr, sizeof(u64));
+    return value;
+}
+
+static inline u32 read32(const u8* ptr) {
+    u32 value;
+    std::memcpy(&value, ptr, sizeof(u32));
+    return value;
+}
+
+static inline u64 round(u64 acc, u64 input) {
+    acc += input * cPrime2;
+    acc = std::rotl(acc, 31);
+    return acc * cPrime1;
+}
+
+static inline u64 mergeRound(u64 acc, u64 value) {
+    acc ^= round(0, value);
+    return acc * cPrime1 + cPrime4;
+}
+
+void XXHash64::reset(u64 seed) {
+    mSeed = seed;
+    mAccumulators = { seed + cPrime1 + cPrime2, seed + cPrime2, seed, seed - cPrime1 };
+    mBufferSize = 0;
+    mTotalSize = 0;
+}
+
+void XXHash64::update(const void* data, size_t size) {
+    const u8* ptr = static_cast<const u8*>(data);
+    const u8* end = ptr + size;
+    mTotalSize += size;
+
+    // not enough for a full stripe yet
+    if (mBufferSize + size < mBuffer.size()) {
+        std::memcpy(mBuffer.data() + mBufferSize, ptr, size);
+        mBufferSize += size;
+        return;
+    }
+
+    // finish off the partially filled stripe first
+    if (mBufferSize != 0) {
+        const size_t fill = mBuffer.size() - mBufferSize;
+        std::memcpy(mBuffer.data() + mBufferSize, ptr, fill);
+        for (size_t i = 0; i < mAccumulators.size(); ++i) {
+            mAccumulators[i] = round(mAccumulators[i], read64(mBuffer.data() + i * sizeof(u64)));
+        }
+        ptr += fill;
+        mBufferSize = 0;
+    }
+
+    while (end - ptr >= static_cast<ptrdiff_t>(mBuffer.size())) {
+        for (size_t i = 0; i < mAccumulators.size(); ++i) {
+            mAccumulators[i] = round(mAccumulators[i], read64(ptr + i * sizeof(u64)));
+        }
+        ptr += mBuffer.size();
+    }
+
+    mBufferSize = static_cast<size_t>(end - ptr);
+    std::memcpy(mBuffer.data(), ptr, mBufferSize);
+}
+
+u64 XXHash64::digest() const {
+    u64 hash;
+    if (mTotalSize >= mBuffer.size()) {
+        hash = std::rotl(mAccumulators[0], 1) + std::rotl(mAccumulators[1], 7) + std::rotl(mAccumulators[2], 12) + std::rotl(mAccumulators[3], 18);
+        for (const u64 acc : mAccumulators) {
+            hash = mergeRound(hash, acc);
+        }
+    } else {
+        hash = mSeed + cPrime5;
+    }
+    hash += mTotalSize;
+
+    const u8* ptr = mBuffer.data();
+    const u8* end = ptr + mBufferSize;
+    while (end - ptr >= 8) {
+        hash ^= round(0, read64(ptr));
+        hash = std::rotl(hash, 27) * cPrime1 + cPrime4;
+        ptr += 8;
+    }
+    if (end - ptr >= 4) {
+        hash ^= static_cast<u64>(read32(ptr)) * cPrime1;
+        hash = std::rotl(hash, 23) * cPrime2 + cPrime3;
+        ptr += 4;
+    }
+    while (ptr < end) {
+        hash ^= *ptr * cPrime5;
+        hash = std::rotl(hash, 11) * cPrime1;
+        ++ptr;
+    }
+
+    hash ^= hash >> 33;
+    hash *= cPrime2;
+    hash ^= hash >> 29;
+    hash *= cPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+u64 calcXXHash64(const void* data, size_t size, u64 seed) {
+    XXHash64 hasher(seed);
+    hasher.update(data, size);
+    return hasher.digest();
+}
+
+u64 calcXXHash64(const std::string_view str, u64 seed) {
+    return calcXXHash64(str.data(), str.size(), seed);
+}
+
+} // namespace util
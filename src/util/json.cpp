@@ -0,0 +1,472 @@
+#include "util/json.h"
+#include "util/yaml.h"
+
+#include <array>
+#include <cstring>
+#include <format>
+
+namespace banana {
+
+// bytes that can't go into a json string as they are
+static constexpr auto sNeedsEscape = [] {
+    std::array<bool, 0x100> table{};
+    for (u32 c = 0; c < 0x20; ++c)
+        table[c] = true;
+    table['"'] = true;
+    table['\\'] = true;
+    return table;
+}();
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// length of the json number at the start of value, 0 if there isn't one
+static size_t scanNumber(std::string_view value) {
+    size_t i = 0;
+    const auto digits = [&]() {
+        const size_t start = i;
+        while (i < value.size() && isDigit(value[i]))
+            ++i;
+        return i != start;
+    };
+    if (i < value.size() && value[i] == '-')
+        ++i;
+    if (i < value.size() && value[i] == '0') {
+        ++i;
+    } else if (!digits()) {
+        return 0;
+    }
+    if (i < value.size() && value[i] == '.') {
+        ++i;
+        if (!digits())
+            return 0;
+    }
+    if (i < value.size() && (value[i] == 'e' || value[i] == 'E')) {
+        ++i;
+        if (i < value.size() && (value[i] == '+' || value[i] == '-'))
+            ++i;
+        if (!digits())
+            return 0;
+    }
+    return i;
+}
+
+// whether the scalar can be written without quotes and still read back the same
+static bool isLiteral(std::string_view value) {
+    return value == "true" || value == "false" || value == "null" || (!value.empty() && scanNumber(value) == value.size());
+}
+
+void JsonWriter::EmitScalar(std::string_view value, bool plainImplicit, bool quotedImplicit, std::string_view tag) {
+    const bool hasTag = !tag.empty() && !plainImplicit && !quotedImplicit;
+    if (!hasTag && !plainImplicit && !quotedImplicit) {
+        throw std::runtime_error("Emit failed: neither tag nor implicit flags are specified");
+    }
+
+    closeRaw();
+    const bool isKey = isKeyPosition();
+    beginNode();
+    if (isKey) {
+        // keys have to be strings, so the tag goes in front of the text and a key that would look tagged gets !!str
+        mOutput.push_back('"');
+        if (hasTag) {
+            writeEscaped(tag);
+            mOutput.push_back(' ');
+        } else if (value.starts_with('!')) {
+            mOutput.append("!!str ");
+        }
+        writeEscaped(value);
+        mOutput.push_back('"');
+    } else if (hasTag || (!quotedImplicit && !isLiteral(value))) {
+        // plain scalars json has no literal for (.nan, .inf) get wrapped as well so they don't come back as strings
+        mOutput.append("{\"");
+        writeEscaped(tag.empty() ? std::string_view{"!!str"} : tag);
+        mOutput.append("\":");
+        if (isLiteral(value)) {
+            mOutput.append(value);
+        } else {
+            mOutput.push_back('"');
+            writeEscaped(value);
+            mOutput.push_back('"');
+        }
+        mOutput.push_back('}');
+    } else if (quotedImplicit) {
+        mOutput.push_back('"');
+        writeEscaped(value);
+        mOutput.push_back('"');
+    } else {
+        mOutput.append(value);
+    }
+    endNode();
+}
+
+void JsonWriter::BeginMapping(std::string_view tag, YamlWriter::Style) {
+    beginCollection(true, tag);
+}
+
+void JsonWriter::EndMapping() {
+    endCollection(true);
+}
+
+void JsonWriter::BeginSequence(std::string_view tag, YamlWriter::Style) {
+    beginCollection(false, tag);
+}
+
+void JsonWriter::EndSequence() {
+    endCollection(false);
+}
+
+void JsonWriter::BeginRawValue() {
+    if (mFrames.empty() || !mFrames.back().isMapping || !mFrames.back().expectValue || mFrames.back().isRaw) {
+        throw std::runtime_error("Emit failed: raw values are only allowed as mapping values");
+    }
+    beginNode();
+    mOutput.push_back('{');
+    mFrames.push_back({ .isMapping = true, .first = true, .expectValue = false, .isTagged = false, .isRaw = true, .isFragment = false });
+}
+
+void JsonWriter::WriteRaw(std::string_view text) {
+    if (mFrames.empty() || !mFrames.back().isRaw) {
+        throw std::runtime_error("Emit failed: raw text has to follow BeginRawValue");
+    }
+    if (text.empty()) {
+        return;
+    }
+    if (!mFrames.back().first) {
+        mOutput.push_back(',');
+    }
+    mFrames.back().first = false;
+    mOutput.append(text);
+    flushIfFull();
+}
+
+void JsonWriter::BeginFragment() {
+    if (!mFrames.empty() || !mOutput.empty()) {
+        throw std::runtime_error("Emit failed: a fragment has to start the output");
+    }
+    mFrames.push_back({ .isMapping = true, .first = true, .expectValue = false, .isTagged = false, .isRaw = false, .isFragment = true });
+}
+
+void JsonWriter::EndFragment() {
+    closeRaw();
+    if (mFrames.size() != 1 || !mFrames.back().isFragment) {
+        throw std::runtime_error("Emit failed: unclosed collection at end of fragment");
+    }
+    if (mFrames.back().expectValue) {
+        throw std::runtime_error("Emit failed: mapping key without a value");
+    }
+    mFrames.pop_back();
+    Flush();
+}
+
+void JsonWriter::Finish() {
+    closeRaw();
+    if (!mFrames.empty()) {
+        throw std::runtime_error("Emit failed: unclosed collection at end of document");
+    }
+    mOutput.push_back('\n');
+    Flush();
+}
+
+// writes whatever has to separate this node from the one before it
+void JsonWriter::beginNode() {
+    if (mFrames.empty()) {
+        return;
+    }
+    auto& frame = mFrames.back();
+    if (frame.isMapping && frame.expectValue) {
+        mOutput.push_back(':');
+        return;
+    }
+    if (!frame.first) {
+        mOutput.push_back(',');
+    }
+    frame.first = false;
+}
+
+void JsonWriter::endNode() {
+    if (!mFrames.empty() && mFrames.back().isMapping) {
+        mFrames.back().expectValue = !mFrames.back().expectValue;
+    }
+    flushIfFull();
+}
+
+void JsonWriter::closeRaw() {
+    if (!mFrames.empty() && mFrames.back().isRaw) {
+        mOutput.push_back('}');
+        mFrames.pop_back();
+        endNode();
+    }
+}
+
+void JsonWriter::beginCollection(bool isMapping, std::string_view tag) {
+    closeRaw();
+    if (isKeyPosition()) {
+        throw std::runtime_error("Emit failed: json keys have to be scalars");
+    }
+    beginNode();
+    if (!tag.empty()) {
+        mOutput.append("{\"");
+        writeEscaped(tag);
+        mOutput.append("\":");
+    }
+    mOutput.push_back(isMapping ? '{' : '[');
+    mFrames.push_back({ .isMapping = isMapping, .first = true, .expectValue = false, .isTagged = !tag.empty(), .isRaw = false, .isFragment = false });
+}
+
+void JsonWriter::endCollection(bool isMapping) {
+    closeRaw();
+    if (mFrames.empty() || mFrames.back().isMapping != isMapping || mFrames.back().isFragment) {
+        throw std::runtime_error("Emit failed: collection end doesn't match its start");
+    }
+    if (mFrames.back().expectValue) {
+        throw std::runtime_error("Emit failed: mapping key without a value");
+    }
+    mOutput.push_back(isMapping ? '}' : ']');
+    if (mFrames.back().isTagged) {
+        mOutput.push_back('}');
+    }
+    mFrames.pop_back();
+    endNode();
+}
+
+// escapes the contents of a string, the quotes are up to the caller
+void JsonWriter::writeEscaped(std::string_view value) {
+    static constexpr char sDigits[] = "0123456789abcdef";
+
+    size_t start = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        const u8 c = static_cast<u8>(value[i]);
+        if (!sNeedsEscape[c]) {
+            continue;
+        }
+        mOutput.append(value.substr(start, i - start));
+        start = i + 1;
+        switch (c) {
+            case '"': mOutput.append("\\\""); break;
+            case '\\': mOutput.append("\\\\"); break;
+            case '\b': mOutput.append("\\b"); break;
+            case '\f': mOutput.append("\\f"); break;
+            case '\n': mOutput.append("\\n"); break;
+            case '\r': mOutput.append("\\r"); break;
+            case '\t': mOutput.append("\\t"); break;
+            default: {
+                const char escape[] = { '\\', 'u', '0', '0', sDigits[c >> 4], sDigits[c & 0xf] };
+                mOutput.append(escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    mOutput.append(value.substr(start));
+}
+
+void JsonReader::fail(std::string_view what) const {
+    throw ParseError(std::format("Invalid json at offset {}: {}", mPos - mBegin, what));
+}
+
+void JsonReader::skipWhitespace() {
+    while (mPos != mEnd && (*mPos == ' ' || *mPos == '\n' || *mPos == '\r' || *mPos == '\t')) {
+        ++mPos;
+    }
+}
+
+JsonReader::Event JsonReader::Next() {
+    skipWhitespace();
+    switch (mState) {
+        case State::AfterValue: {
+            if (mStack.empty()) {
+                if (mPos != mEnd)
+                    fail("trailing characters after the document");
+                return Event::End;
+            }
+            if (mPos == mEnd)
+                fail("unexpected end of input");
+            const bool inObject = mStack.back();
+            if (*mPos == (inObject ? '}' : ']')) {
+                ++mPos;
+                mStack.pop_back();
+                return inObject ? Event::EndObject : Event::EndArray;
+            }
+            if (*mPos != ',')
+                fail(inObject ? "expected ',' or '}'" : "expected ',' or ']'");
+            ++mPos;
+            mState = inObject ? State::Key : State::Value;
+            return Next();
+        }
+        case State::FirstKey:
+            if (mPos != mEnd && *mPos == '}') {
+                ++mPos;
+                mStack.pop_back();
+                mState = State::AfterValue;
+                return Event::EndObject;
+            }
+            [[fallthrough]];
+        case State::Key:
+            if (mPos == mEnd || *mPos != '"')
+                fail("expected a key");
+            ++mPos;
+            mValue = readString();
+            mState = State::AfterKey;
+            return Event::Key;
+        case State::AfterKey:
+            if (mPos == mEnd || *mPos != ':')
+                fail("expected ':'");
+            ++mPos;
+            skipWhitespace();
+            return readValue();
+        case State::FirstValue:
+            if (mPos != mEnd && *mPos == ']') {
+                ++mPos;
+                mStack.pop_back();
+                mState = State::AfterValue;
+                return Event::EndArray;
+            }
+            [[fallthrough]];
+        case State::Value:
+            return readValue();
+    }
+    fail("invalid reader state");
+}
+
+JsonReader::Event JsonReader::readValue() {
+    if (mPos == mEnd)
+        fail("unexpected end of input");
+    switch (*mPos) {
+        case '{':
+            ++mPos;
+            mStack.push_back(true);
+            mState = State::FirstKey;
+            return Event::BeginObject;
+        case '[':
+            ++mPos;
+            mStack.push_back(false);
+            mState = State::FirstValue;
+            return Event::BeginArray;
+        case '"':
+            ++mPos;
+            mValue = readString();
+            mState = State::AfterValue;
+            return Event::String;
+        case 't':
+            expectWord("true");
+            break;
+        case 'f':
+            expectWord("false");
+            break;
+        case 'n':
+            expectWord("null");
+            break;
+        default:
+            mValue = readNumber();
+            break;
+    }
+    mState = State::AfterValue;
+    return Event::Literal;
+}
+
+// the opening quote has already been consumed, the unescaped text is written back over the escaped one
+std::string_view JsonReader::readString() {
+    char* const start = mPos;
+    char* out = mPos;
+    const auto readHex = [&]() {
+        if (mEnd - mPos < 4)
+            fail("truncated \\u escape");
+        u32 value = 0;
+        for (s32 i = 0; i < 4; ++i) {
+            const char c = *mPos++;
+            value <<= 4;
+            if (c >= '0' && c <= '9')
+                value |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                value |= c - 'A' + 10;
+            else
+                fail("invalid \\u escape");
+        }
+        return value;
+    };
+
+    while (true) {
+        // most strings have nothing to unescape, so nothing gets moved until the first backslash
+        while (mPos != mEnd && !sNeedsEscape[static_cast<u8>(*mPos)]) {
+            if (out != mPos)
+                *out = *mPos;
+            ++out;
+            ++mPos;
+        }
+        if (mPos == mEnd)
+            fail("unterminated string");
+        if (*mPos == '"') {
+            ++mPos;
+            return {start, out};
+        }
+        if (*mPos != '\\')
+            fail("control character in string");
+        ++mPos;
+        if (mPos == mEnd)
+            fail("unterminated string");
+        switch (*mPos++) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/': *out++ = '/'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                u32 code = readHex();
+                if (code >= 0xd800 && code < 0xdc00) {
+                    if (mEnd - mPos < 2 || mPos[0] != '\\' || mPos[1] != 'u')
+                        fail("unpaired surrogate");
+                    mPos += 2;
+                    const u32 low = readHex();
+                    if (low < 0xdc00 || low >= 0xe000)
+                        fail("unpaired surrogate");
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                } else if (code >= 0xdc00 && code < 0xe000) {
+                    fail("unpaired surrogate");
+                }
+                // never longer than the escape it came from
+                if (code < 0x80) {
+                    *out++ = static_cast<char>(code);
+                } else if (code < 0x800) {
+                    *out++ = static_cast<char>(0xc0 | code >> 6);
+                    *out++ = static_cast<char>(0x80 | (code & 0x3f));
+                } else if (code < 0x10000) {
+                    *out++ = static_cast<char>(0xe0 | code >> 12);
+                    *out++ = static_cast<char>(0x80 | (code >> 6 & 0x3f));
+                    *out++ = static_cast<char>(0x80 | (code & 0x3f));
+                } else {
+                    *out++ = static_cast<char>(0xf0 | code >> 18);
+                    *out++ = static_cast<char>(0x80 | (code >> 12 & 0x3f));
+                    *out++ = static_cast<char>(0x80 | (code >> 6 & 0x3f));
+                    *out++ = static_cast<char>(0x80 | (code & 0x3f));
+                }
+                break;
+            }
+            default:
+                fail("invalid escape");
+        }
+    }
+}
+
+// only checked against json's grammar here, the text is decoded with from_chars by whoever reads the value
+std::string_view JsonReader::readNumber() {
+    const size_t length = scanNumber({mPos, static_cast<size_t>(mEnd - mPos)});
+    if (length == 0)
+        fail("invalid value");
+    const std::string_view number{mPos, length};
+    mPos += length;
+    return number;
+}
+
+void JsonReader::expectWord(std::string_view word) {
+    if (static_cast<size_t>(mEnd - mPos) < word.size() || std::memcmp(mPos, word.data(), word.size()) != 0)
+        fail("invalid literal");
+    mValue = {mPos, word.size()};
+    mPos += word.size();
+}
+
+} // namespace banana
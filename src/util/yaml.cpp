@@ -19,7 +19,9 @@
 
 #include "yaml.h"
 
+#include <charconv>
 #include <format>
+#include <limits>
 #include <mutex>
 
 #include <c4/error.hpp>
@@ -32,20 +34,6 @@ namespace banana {
 
 using namespace std::string_view_literals;
 
-std::string FormatFloat(float value) {
-  std::string repr = std::format("{:.9g}", value);
-  if (repr.find(".") == std::string::npos && repr.find("e") == std::string::npos)
-    repr += ".0"sv;
-  return repr;
-}
-
-std::string FormatDouble(double value) {
-  std::string repr = std::format("{:.17f}", value);
-  if (repr.find(".") == std::string::npos && repr.find("e") == std::string::npos)
-    repr += ".0"sv;
-  return repr;
-}
-
 static bool IsInfinity(std::string_view input) {
   return util::IsAnyOf(input, ".inf", ".Inf", ".INF") ||
          util::IsAnyOf(input, "+.inf", "+.Inf", "+.INF");
@@ -59,89 +47,78 @@ static bool IsNaN(std::string_view input) {
   return util::IsAnyOf(input, ".nan", ".NaN", ".NAN");
 }
 
-static std::optional<TagBasedType> GetTagBasedType(const std::string_view tag,
-                                                   TagRecognizer recognizer) {
-  if (tag.empty())
-    return std::nullopt;
-  if (tag == "tag:yaml.org,2002:str")
-    return TagBasedType::Str;
-  if (tag == "tag:yaml.org,2002:float")
-    return TagBasedType::Float;
-  if (tag == "tag:yaml.org,2002:int")
-    return TagBasedType::Int;
-  if (tag == "tag:yaml.org,2002:bool")
-    return TagBasedType::Bool;
-  if (tag == "tag:yaml.org,2002:null")
-    return TagBasedType::Null;
-  if (const auto type = recognizer(tag))
-    return type;
-  return std::nullopt;
-}
-
-// Deliberately not compliant to the YAML 1.2 standard to get rid of unused features
-// that harm performance.
-Scalar ParseScalar(const std::string_view tag, const std::string_view value, bool is_quoted,
-                   TagRecognizer recognizer) {
-  const auto tag_type = GetTagBasedType(tag, recognizer);
-
-  if (tag_type == TagBasedType::Bool || util::IsAnyOf(value, "true", "false"))
-    return value[0] == 't';
-
-  // Floating-point conversions.
-  const bool is_possible_double = value.find('.') != std::string::npos;
-  if (tag_type == TagBasedType::Float || (!tag_type && is_possible_double && !is_quoted)) {
-    if (IsInfinity(value))
-      return std::numeric_limits<double>::infinity();
-    if (IsNegativeInfinity(value))
-      return -std::numeric_limits<double>::infinity();
-    if (IsNaN(value))
-      return std::numeric_limits<double>::quiet_NaN();
-    
-    char* str_end = nullptr;
-    double maybe_double = std::strtod(value.data(), &str_end);
-    if (value.data() + value.size() == str_end)
-      return maybe_double;
-    if (tag_type == TagBasedType::Float)
-      throw ParseError("Failed to parse value that was explicitly marked as float");
+std::optional<u64> DecodeInt(std::string_view value) {
+  bool negative = false;
+  if (!value.empty() && (value[0] == '-' || value[0] == '+')) {
+    negative = value[0] == '-';
+    value.remove_prefix(1);
   }
 
-  // Integer conversions. Not YAML 1.2 compliant: base 8 is not supported as it's not useful.
-  if (tag_type == TagBasedType::Int || (!tag_type && !value.empty() && !is_quoted)) {
-    char* int_str_end = nullptr;
-    const u64 maybe_u64 = std::strtoull(value.data(), &int_str_end, 0);
-    if (value.data() + value.size() == int_str_end)
-      return maybe_u64;
-    if (tag_type == TagBasedType::Int)
-      throw ParseError("Failed to parse value that was explicitly marked as integer");
+  int base = 10;
+  if (value.size() > 2 && value[0] == '0' && (value[1] == 'x' || value[1] == 'X')) {
+    base = 16;
+    value.remove_prefix(2);
+  } else if (value.size() > 1 && value[0] == '0') {
+    base = 8;
+    value.remove_prefix(1);
   }
 
-  if (tag_type == TagBasedType::Null || value == "null")
-    return nullptr;
+  u64 result = 0;
+  const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result, base);
+  if (value.empty() || ec != std::errc{} || ptr != value.data() + value.size())
+    return std::nullopt;
+  return negative ? 0 - result : result;
+}
 
-  // Fall back to treating the value as a string.
-  return std::string(value);
+std::optional<f64> DecodeFloat(std::string_view value) {
+  if (IsInfinity(value))
+    return std::numeric_limits<double>::infinity();
+  if (IsNegativeInfinity(value))
+    return -std::numeric_limits<double>::infinity();
+  if (IsNaN(value))
+    return std::numeric_limits<double>::quiet_NaN();
+
+  // from_chars doesn't take a leading +
+  if (!value.empty() && value[0] == '+')
+    value.remove_prefix(1);
+
+  f64 result = 0;
+  const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+  if (value.empty() || ec != std::errc{} || ptr != value.data() + value.size())
+    return std::nullopt;
+  return result;
 }
 
-bool StringNeedsQuotes(const std::string_view value) {
-  if (util::IsAnyOf(value, "true", "false"))
+std::optional<bool> DecodeBool(const std::string_view value) {
+  if (value == "true")
     return true;
+  if (value == "false")
+    return false;
+  return std::nullopt;
+}
 
-  const bool is_possible_double = value.find('.') != std::string::npos;
-  if (is_possible_double) {
-    if (IsInfinity(value) || IsNegativeInfinity(value) || IsNaN(value))
-      return true;
-    char* str_end = nullptr;
-    std::strtod(value.data(), &str_end);
-    if (value.data() + value.size() == str_end)
-      return true;
+Number DecodeNumber(const std::string_view value) {
+  if (const auto res = DecodeBool(value))
+    return *res;
+  // anything with a dot is a float
+  if (value.find('.') != std::string_view::npos) {
+    if (const auto res = DecodeFloat(value))
+      return *res;
+  } else if (const auto res = DecodeInt(value)) {
+    return *res;
   }
+  return std::monostate{};
+}
 
-  if (!value.empty()) {
-    char* int_str_end = nullptr;
-    std::strtoull(value.data(), &int_str_end, 0);
-    if (value.data() + value.size() == int_str_end)
-      return true;
-  }
+void ThrowDecodeError(const std::string_view value, const std::string_view type) {
+  throw ParseError(std::format("Failed to parse '{}' as {}", value, type));
+}
+
+bool StringNeedsQuotes(const std::string_view value) {
+  // anything the importer would read back as a bool or number, the decoders only look at
+  // [data, data + size) since the value usually isn't null terminated
+  if (!std::holds_alternative<std::monostate>(DecodeNumber(value)))
+    return true;
 
   if (value == "null")
     return true;
@@ -149,26 +126,6 @@ bool StringNeedsQuotes(const std::string_view value) {
   return false;
 }
 
-Scalar ParseScalar(const ryml::ConstNodeRef& node, TagRecognizer recognizer) {
-  const std::string_view tag = RymlGetValTag(node);
-  const std::string_view value = RymlSubstrToStrView(node.val());
-  const char* arena_start = node.tree()->arena().data();
-  bool is_quoted = false;
-  if (node.val().data() != arena_start)
-    is_quoted = util::IsAnyOf(*(node.val().data() - 1), '\'', '"');
-  return ParseScalar(tag, value, is_quoted, recognizer);
-}
-
-Scalar ParseScalarKey(const ryml::ConstNodeRef& node, TagRecognizer recognizer) {
-  const std::string_view tag = RymlGetKeyTag(node);
-  const std::string_view value = RymlSubstrToStrView(node.key());
-  const char* arena_start = node.tree()->arena().data();
-  bool is_quoted = false;
-  if (node.key().data() != arena_start)
-    is_quoted = util::IsAnyOf(*(node.key().data() - 1), '\'', '"');
-  return ParseScalar(tag, value, is_quoted, recognizer);
-}
-
 void InitRymlIfNeeded() {
   static std::once_flag s_flag;
   std::call_once(s_flag, [] {
@@ -183,21 +140,4 @@ void InitRymlIfNeeded() {
   });
 }
 
-LibyamlEmitter::LibyamlEmitter() {
-  yaml_emitter_initialize(&m_emitter);
-  yaml_emitter_set_unicode(&m_emitter, 1);
-  yaml_emitter_set_width(&m_emitter, 120);
-}
-
-LibyamlEmitter::~LibyamlEmitter() {
-  yaml_emitter_delete(&m_emitter);
-}
-
-void LibyamlEmitter::Emit(yaml_event_t& event, bool ignore_errors) {
-  if (!yaml_emitter_emit(&m_emitter, &event) && !ignore_errors) {
-    throw std::runtime_error("Emit failed: " +
-                             std::string(m_emitter.problem ? m_emitter.problem : "unknown"));
-  }
-}
-
 }  // namespace banana
\ No newline at end of file
@@ -0,0 +1,790 @@
+#include "util/yaml_writer.h"
+#include "util/yaml.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace banana {
+
+// everything below follows libyaml's emitter (emitter.c) closely so the output stays the same as before
+
+static u8 byteAt(std::string_view str, size_t i) {
+    return i < str.size() ? static_cast<u8>(str[i]) : 0;
+}
+
+static size_t charWidth(u8 octet) {
+    if ((octet & 0x80) == 0x00)
+        return 1;
+    if ((octet & 0xe0) == 0xc0)
+        return 2;
+    if ((octet & 0xf0) == 0xe0)
+        return 3;
+    if ((octet & 0xf8) == 0xf0)
+        return 4;
+    return 1;
+}
+
+static bool isBreakAt(std::string_view str, size_t i) {
+    const u8 c = byteAt(str, i);
+    return c == '\r' || c == '\n'
+        || (c == 0xc2 && byteAt(str, i + 1) == 0x85)
+        || (c == 0xe2 && byteAt(str, i + 1) == 0x80 && (byteAt(str, i + 2) == 0xa8 || byteAt(str, i + 2) == 0xa9));
+}
+
+static bool isBlankZAt(std::string_view str, size_t i) {
+    const u8 c = byteAt(str, i);
+    return c == ' ' || c == '\t' || c == '\0' || isBreakAt(str, i);
+}
+
+static bool isPrintableAt(std::string_view str, size_t i) {
+    const u8 c = byteAt(str, i);
+    const u8 c1 = byteAt(str, i + 1);
+    const u8 c2 = byteAt(str, i + 2);
+    return c == 0x0a
+        || (c >= 0x20 && c <= 0x7e)
+        || (c == 0xc2 && c1 >= 0xa0)
+        || (c > 0xc2 && c < 0xed)
+        || (c == 0xed && c1 < 0xa0)
+        || c == 0xee
+        || (c == 0xef && !(c1 == 0xbb && c2 == 0xbf) && !(c1 == 0xbf && (c2 == 0xbe || c2 == 0xbf)));
+}
+
+// characters that never affect how a scalar gets quoted, no matter where they are
+static constexpr auto sPlainSafe = [] {
+    std::array<bool, 0x100> table{};
+    for (u32 c = '0'; c <= '9'; ++c)
+        table[c] = true;
+    for (u32 c = 'a'; c <= 'z'; ++c)
+        table[c] = true;
+    for (u32 c = 'A'; c <= 'Z'; ++c)
+        table[c] = true;
+    for (const char c : std::string_view("_.-/+=()$~;"))
+        table[static_cast<u8>(c)] = true;
+    return table;
+}();
+
+static bool isPlainSafe(std::string_view value) {
+    for (const char c : value) {
+        if (!sPlainSafe[static_cast<u8>(c)])
+            return false;
+    }
+    // a lone dash is a sequence entry
+    return value != "-" && !value.starts_with("---") && !value.starts_with("...");
+}
+
+YamlWriter::ScalarAnalysis YamlWriter::analyzeScalar(std::string_view value) {
+    if (value.empty()) {
+        return { false, false, true, true };
+    }
+
+    // most scalars are names and numbers so skip the full scan for those
+    if (isPlainSafe(value)) {
+        return { false, true, true, true };
+    }
+
+    bool blockIndicators = false;
+    bool flowIndicators = false;
+    bool lineBreaks = false;
+    bool specialCharacters = false;
+    bool leadingSpace = false;
+    bool leadingBreak = false;
+    bool trailingSpace = false;
+    bool trailingBreak = false;
+    bool breakSpace = false;
+    bool spaceBreak = false;
+    bool previousSpace = false;
+    bool previousBreak = false;
+
+    if (value.starts_with("---") || value.starts_with("...")) {
+        blockIndicators = true;
+        flowIndicators = true;
+    }
+
+    bool precededByWhitespace = true;
+    bool followedByWhitespace = isBlankZAt(value, charWidth(byteAt(value, 0)));
+
+    for (size_t i = 0; i < value.size();) {
+        const char c = value[i];
+        const size_t width = charWidth(static_cast<u8>(c));
+        if (i == 0) {
+            switch (c) {
+                case '#': case ',': case '[': case ']': case '{': case '}': case '&': case '*':
+                case '!': case '|': case '>': case '\'': case '"': case '%': case '@': case '`':
+                    flowIndicators = true;
+                    blockIndicators = true;
+                    break;
+                case '?': case ':':
+                    flowIndicators = true;
+                    if (followedByWhitespace)
+                        blockIndicators = true;
+                    break;
+                case '-':
+                    if (followedByWhitespace) {
+                        flowIndicators = true;
+                        blockIndicators = true;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        } else {
+            switch (c) {
+                case ',': case '?': case '[': case ']': case '{': case '}':
+                    flowIndicators = true;
+                    break;
+                case ':':
+                    flowIndicators = true;
+                    if (followedByWhitespace)
+                        blockIndicators = true;
+                    break;
+                case '#':
+                    if (precededByWhitespace) {
+                        flowIndicators = true;
+                        blockIndicators = true;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (!isPrintableAt(value, i))
+            specialCharacters = true;
+
+        const bool isBreak = isBreakAt(value, i);
+        if (isBreak)
+            lineBreaks = true;
+
+        const bool first = i == 0;
+        const bool last = i + width >= value.size();
+        if (c == ' ') {
+            if (first)
+                leadingSpace = true;
+            if (last)
+                trailingSpace = true;
+            if (previousBreak)
+                breakSpace = true;
+            previousSpace = true;
+            previousBreak = false;
+        } else if (isBreak) {
+            if (first)
+                leadingBreak = true;
+            if (last)
+                trailingBreak = true;
+            if (previousSpace)
+                spaceBreak = true;
+            previousBreak = true;
+            previousSpace = false;
+        } else {
+            previousSpace = false;
+            previousBreak = false;
+        }
+
+        precededByWhitespace = isBlankZAt(value, i);
+        i += width;
+        if (i < value.size())
+            followedByWhitespace = isBlankZAt(value, i + charWidth(byteAt(value, i)));
+    }
+
+    ScalarAnalysis analysis = { lineBreaks, true, true, true };
+    if (leadingSpace || leadingBreak || trailingSpace || trailingBreak) {
+        analysis.flowPlainAllowed = false;
+        analysis.blockPlainAllowed = false;
+    }
+    if (breakSpace) {
+        analysis.flowPlainAllowed = false;
+        analysis.blockPlainAllowed = false;
+        analysis.singleQuotedAllowed = false;
+    }
+    if (spaceBreak || specialCharacters) {
+        analysis.flowPlainAllowed = false;
+        analysis.blockPlainAllowed = false;
+        analysis.singleQuotedAllowed = false;
+    }
+    if (lineBreaks) {
+        analysis.flowPlainAllowed = false;
+        analysis.blockPlainAllowed = false;
+    }
+    if (flowIndicators)
+        analysis.flowPlainAllowed = false;
+    if (blockIndicators)
+        analysis.blockPlainAllowed = false;
+    return analysis;
+}
+
+void YamlWriter::EmitScalar(std::string_view value, bool plainImplicit, bool quotedImplicit, std::string_view tag) {
+    enum class ScalarStyle { Plain, SingleQuoted, DoubleQuoted };
+
+    const auto analysis = analyzeScalar(value);
+    const bool hasTag = !tag.empty() && !plainImplicit && !quotedImplicit;
+    if (!hasTag && !plainImplicit && !quotedImplicit) {
+        throw std::runtime_error("Emit failed: neither tag nor implicit flags are specified");
+    }
+
+    beginNode(true, value.size() + (hasTag ? tag.size() : 0), analysis.multiline);
+    writeAnchor();
+
+    ScalarStyle style = value.empty() ? ScalarStyle::SingleQuoted : ScalarStyle::Plain;
+    if (mSimpleKeyContext && analysis.multiline)
+        style = ScalarStyle::DoubleQuoted;
+    if (style == ScalarStyle::Plain) {
+        if ((mFlowLevel != 0 && !analysis.flowPlainAllowed) || (mFlowLevel == 0 && !analysis.blockPlainAllowed))
+            style = ScalarStyle::SingleQuoted;
+        if (!hasTag && !plainImplicit)
+            style = ScalarStyle::SingleQuoted;
+    }
+    if (style == ScalarStyle::SingleQuoted && !analysis.singleQuotedAllowed)
+        style = ScalarStyle::DoubleQuoted;
+
+    if (hasTag) {
+        writeTag(tag);
+    } else if (!quotedImplicit && style != ScalarStyle::Plain) {
+        writeTag("!");
+    }
+
+    increaseIndent(true, false);
+    switch (style) {
+        case ScalarStyle::Plain:
+            writePlain(value, !mSimpleKeyContext);
+            break;
+        case ScalarStyle::SingleQuoted:
+            writeSingleQuoted(value, !mSimpleKeyContext);
+            break;
+        case ScalarStyle::DoubleQuoted:
+            writeDoubleQuoted(value, !mSimpleKeyContext);
+            break;
+    }
+    mIndent = mIndents.back();
+    mIndents.pop_back();
+
+    endNode();
+}
+
+std::string_view FloatToChars(float v, char (&buf)[32]) {
+    if (std::isnan(v)) {
+        return ".nan";
+    }
+    if (std::isinf(v)) {
+        return v < 0 ? "-.inf" : ".inf";
+    }
+    // shortest representation that parses back to the same float
+    auto end = std::to_chars(buf, buf + sizeof(buf) - 2, v).ptr;
+    // the importer reads floats as doubles and narrows them, rounding twice lands on the wrong float for a
+    // couple of values (e.g. 7.038531e-26) so those get the 9 significant digits the old formatting used
+    f64 check = 0.0;
+    std::from_chars(buf, end, check);
+    if (static_cast<f32>(check) != v) {
+        end = std::to_chars(buf, buf + sizeof(buf) - 2, v, std::chars_format::general, 9).ptr;
+    }
+    const std::string_view digits{buf, end};
+    if (digits.find('.') == std::string_view::npos) {
+        // keep a decimal point around so the importer doesn't mistake it for an int
+        const size_t exponent = digits.find('e');
+        if (exponent == std::string_view::npos) {
+            *end++ = '.';
+            *end++ = '0';
+        } else {
+            std::memmove(buf + exponent + 2, buf + exponent, digits.size() - exponent);
+            buf[exponent] = '.';
+            buf[exponent + 1] = '0';
+            end += 2;
+        }
+    }
+    return {buf, end};
+}
+
+std::string_view HexToChars(u32 v, u32 minDigits, char (&buf)[10]) {
+    static constexpr char sDigits[] = "0123456789abcdef";
+    u32 count = std::clamp(minDigits, 1u, 8u);
+    while (count < 8 && (v >> (count * 4)) != 0) {
+        ++count;
+    }
+    buf[0] = '0';
+    buf[1] = 'x';
+    for (u32 i = 0; i < count; ++i) {
+        buf[2 + i] = sDigits[(v >> ((count - 1 - i) * 4)) & 0xf];
+    }
+    return {buf, 2 + count};
+}
+
+void YamlWriter::EmitFloat(float v, std::string_view tag) {
+    char buf[32];
+    EmitScalar(FloatToChars(v, buf), tag == "!!float", false, tag);
+}
+
+void YamlWriter::EmitHex(u32 v, std::string_view tag, u32 minDigits) {
+    char buf[10];
+    EmitScalar(HexToChars(v, minDigits, buf), false, false, tag);
+}
+
+void YamlWriter::EmitString(std::string_view v) {
+    EmitScalar(v, !StringNeedsQuotes(v), true);
+}
+
+void YamlWriter::EmitAlias(std::string_view name) {
+    beginNode(true, name.size() + 1, false);
+    writeIndicator("*", true, false, false);
+    mOutput.append(name);
+    mColumn += static_cast<s32>(name.size());
+    endNode();
+}
+
+void YamlWriter::BeginMapping(std::string_view tag, Style style) {
+    beginCollection(true, tag, style);
+}
+
+void YamlWriter::EndMapping() {
+    endCollection(true);
+}
+
+void YamlWriter::BeginSequence(std::string_view tag, Style style) {
+    beginCollection(false, tag, style);
+}
+
+void YamlWriter::EndSequence() {
+    endCollection(false);
+}
+
+void YamlWriter::Finish() {
+    if (!mFrames.empty()) {
+        throw std::runtime_error("Emit failed: unclosed collection at end of document");
+    }
+    writeIndent();
+    Flush();
+}
+
+void YamlWriter::BeginRawValue() {
+    if (mFrames.empty() || mFrames.back().kind != Kind::BlockMapping || !mFrames.back().expectValue) {
+        throw std::runtime_error("Emit failed: raw values are only allowed as block mapping values");
+    }
+    // writes the ':' after the key, the raw text then starts on the next line like a nested block collection would
+    beginNode(false, 0, false);
+    endNode();
+    putBreak();
+    mWhitespace = true;
+    mIndention = true;
+}
+
+void YamlWriter::WriteRaw(std::string_view text) {
+    mOutput.append(text);
+    mColumn = 0;
+    mWhitespace = true;
+    mIndention = true;
+    flushIfFull();
+}
+
+void YamlWriter::beginNode(bool isScalar, size_t keyLength, bool multiline) {
+    mMappingContext = false;
+    mSimpleKeyContext = false;
+    if (mFrames.empty()) {
+        return;
+    }
+
+    openPending();
+
+    auto& parent = mFrames.back();
+    const bool isSimpleKey = isScalar && !multiline && keyLength <= 128;
+    switch (parent.kind) {
+        case Kind::BlockMapping:
+            mMappingContext = true;
+            if (!parent.expectValue) {
+                writeIndent();
+                parent.simpleKey = isSimpleKey;
+                if (isSimpleKey) {
+                    mSimpleKeyContext = true;
+                } else if (isScalar) {
+                    writeIndicator("?", true, false, true);
+                } else {
+                    throw std::runtime_error("Emit failed: collections can't be used as keys");
+                }
+            } else if (parent.simpleKey) {
+                writeIndicator(":", false, false, false);
+            } else {
+                writeIndent();
+                writeIndicator(":", true, false, true);
+            }
+            break;
+        case Kind::BlockSequence:
+            writeIndent();
+            writeIndicator("-", true, false, true);
+            break;
+        case Kind::FlowMapping:
+            mMappingContext = true;
+            if (!parent.expectValue) {
+                if (!parent.first) {
+                    writeIndicator(",", false, false, false);
+                }
+                if (mColumn > mWidth) {
+                    writeIndent();
+                }
+                parent.simpleKey = isSimpleKey;
+                if (isSimpleKey) {
+                    mSimpleKeyContext = true;
+                } else if (isScalar) {
+                    writeIndicator("?", true, false, false);
+                } else {
+                    throw std::runtime_error("Emit failed: collections can't be used as keys");
+                }
+            } else if (parent.simpleKey) {
+                writeIndicator(":", false, false, false);
+            } else {
+                if (mColumn > mWidth) {
+                    writeIndent();
+                }
+                writeIndicator(":", true, false, false);
+            }
+            break;
+        case Kind::FlowSequence:
+            if (!parent.first) {
+                writeIndicator(",", false, false, false);
+            }
+            if (mColumn > mWidth) {
+                writeIndent();
+            }
+            break;
+    }
+}
+
+void YamlWriter::endNode() {
+    if (mFrames.empty()) {
+        return;
+    }
+    auto& parent = mFrames.back();
+    if (parent.isMapping) {
+        parent.expectValue = !parent.expectValue;
+    }
+    parent.first = false;
+    flushIfFull();
+}
+
+void YamlWriter::openPending() {
+    auto& frame = mFrames.back();
+    if (frame.isOpen) {
+        return;
+    }
+    frame.isOpen = true;
+    if (frame.isFlow) {
+        writeIndicator(frame.isMapping ? "{" : "[", true, true, false);
+        increaseIndent(true, false);
+        ++mFlowLevel;
+    } else if (frame.isMapping) {
+        increaseIndent(false, false);
+    } else {
+        increaseIndent(false, frame.mappingContext && !mIndention);
+    }
+}
+
+void YamlWriter::beginCollection(bool isMapping, std::string_view tag, Style style) {
+    beginNode(false, 0, false);
+    writeAnchor();
+    if (!tag.empty()) {
+        writeTag(tag);
+    }
+
+    const bool isFlow = mFlowLevel != 0 || style == Flow;
+    Kind kind;
+    if (isMapping) {
+        kind = isFlow ? Kind::FlowMapping : Kind::BlockMapping;
+    } else {
+        kind = isFlow ? Kind::FlowSequence : Kind::BlockSequence;
+    }
+    mFrames.push_back({
+        .kind = kind,
+        .isMapping = isMapping,
+        .isOpen = false,
+        .isFlow = isFlow,
+        .first = true,
+        .expectValue = false,
+        .simpleKey = false,
+        .mappingContext = mMappingContext,
+    });
+}
+
+void YamlWriter::endCollection(bool isMapping) {
+    if (mFrames.empty() || mFrames.back().isMapping != isMapping) {
+        throw std::runtime_error("Emit failed: mismatched collection end");
+    }
+
+    const auto frame = mFrames.back();
+    mFrames.pop_back();
+    if (!frame.isOpen) {
+        // empty collections are always written in flow style
+        writeIndicator(isMapping ? "{" : "[", true, true, false);
+        writeIndicator(isMapping ? "}" : "]", false, false, false);
+    } else {
+        mIndent = mIndents.back();
+        mIndents.pop_back();
+        if (frame.isFlow) {
+            --mFlowLevel;
+            writeIndicator(isMapping ? "}" : "]", false, false, false);
+        }
+    }
+
+    endNode();
+}
+
+void YamlWriter::increaseIndent(bool flow, bool indentless) {
+    mIndents.push_back(mIndent);
+    if (mIndent < 0) {
+        mIndent = flow ? 2 : 0;
+    } else if (!indentless) {
+        mIndent += 2;
+    }
+}
+
+void YamlWriter::writeIndent() {
+    const s32 indent = mIndent >= 0 ? mIndent : 0;
+    if (!mIndention || mColumn > indent || (mColumn == indent && !mWhitespace)) {
+        putBreak();
+    }
+    while (mColumn < indent) {
+        put(' ');
+    }
+    mWhitespace = true;
+    mIndention = true;
+}
+
+void YamlWriter::writeIndicator(std::string_view indicator, bool needWhitespace, bool isWhitespace, bool isIndention) {
+    if (needWhitespace && !mWhitespace) {
+        put(' ');
+    }
+    mOutput.append(indicator);
+    mColumn += static_cast<s32>(indicator.size());
+    mWhitespace = isWhitespace;
+    mIndention = mIndention && isIndention;
+}
+
+void YamlWriter::writeTag(std::string_view tag) {
+    static constexpr char sDigits[] = "0123456789ABCDEF";
+
+    if (!mWhitespace) {
+        put(' ');
+    }
+    std::string_view suffix = tag;
+    if (tag.starts_with('!')) {
+        put('!');
+        suffix.remove_prefix(1);
+    } else {
+        mOutput.append("!<");
+        mColumn += 2;
+    }
+    for (const char c : suffix) {
+        const u8 octet = static_cast<u8>(c);
+        if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '-'
+            || std::string_view(";/?:@&=+$,.~*'()[]").find(c) != std::string_view::npos) {
+            put(c);
+        } else {
+            put('%');
+            put(sDigits[octet >> 4]);
+            put(sDigits[octet & 0xf]);
+        }
+    }
+    if (!tag.starts_with('!')) {
+        put('>');
+    }
+    mWhitespace = false;
+    mIndention = false;
+}
+
+void YamlWriter::writeAnchor() {
+    if (mAnchor.empty()) {
+        return;
+    }
+    writeIndicator("&", true, false, false);
+    mOutput.append(mAnchor);
+    mColumn += static_cast<s32>(mAnchor.size());
+    mAnchor.clear();
+}
+
+void YamlWriter::writeChar(std::string_view& value) {
+    const size_t width = std::min(charWidth(static_cast<u8>(value[0])), value.size());
+    mOutput.append(value.substr(0, width));
+    ++mColumn;
+    value.remove_prefix(width);
+}
+
+void YamlWriter::writeBreak(std::string_view& value) {
+    if (value[0] == '\n') {
+        putBreak();
+        value.remove_prefix(1);
+    } else {
+        writeChar(value);
+        mColumn = 0;
+    }
+}
+
+void YamlWriter::writePlain(std::string_view value, bool allowBreaks) {
+    if (!mWhitespace && (!value.empty() || mFlowLevel != 0)) {
+        put(' ');
+    }
+
+    // no spaces or breaks means nothing to fold
+    if (isPlainSafe(value)) {
+        mOutput.append(value);
+        mColumn += static_cast<s32>(value.size());
+        mWhitespace = false;
+        mIndention = false;
+        return;
+    }
+
+    bool spaces = false;
+    bool breaks = false;
+    while (!value.empty()) {
+        if (value[0] == ' ') {
+            if (allowBreaks && !spaces && mColumn > mWidth && byteAt(value, 1) != ' ') {
+                writeIndent();
+                value.remove_prefix(1);
+            } else {
+                writeChar(value);
+            }
+            spaces = true;
+        } else if (isBreakAt(value, 0)) {
+            if (!breaks && value[0] == '\n') {
+                putBreak();
+            }
+            writeBreak(value);
+            mIndention = true;
+            breaks = true;
+        } else {
+            if (breaks) {
+                writeIndent();
+            }
+            writeChar(value);
+            mIndention = false;
+            spaces = false;
+            breaks = false;
+        }
+    }
+
+    mWhitespace = false;
+    mIndention = false;
+}
+
+void YamlWriter::writeSingleQuoted(std::string_view value, bool allowBreaks) {
+    writeIndicator("'", true, false, false);
+
+    bool spaces = false;
+    bool breaks = false;
+    const size_t size = value.size();
+    while (!value.empty()) {
+        const size_t pos = size - value.size();
+        if (value[0] == ' ') {
+            if (allowBreaks && !spaces && mColumn > mWidth && pos != 0 && pos != size - 1 && byteAt(value, 1) != ' ') {
+                writeIndent();
+                value.remove_prefix(1);
+            } else {
+                writeChar(value);
+            }
+            spaces = true;
+        } else if (isBreakAt(value, 0)) {
+            if (!breaks && value[0] == '\n') {
+                putBreak();
+            }
+            writeBreak(value);
+            mIndention = true;
+            breaks = true;
+        } else {
+            if (breaks) {
+                writeIndent();
+            }
+            if (value[0] == '\'') {
+                put('\'');
+            }
+            writeChar(value);
+            mIndention = false;
+            spaces = false;
+            breaks = false;
+        }
+    }
+
+    if (breaks) {
+        writeIndent();
+    }
+    writeIndicator("'", false, false, false);
+
+    mWhitespace = false;
+    mIndention = false;
+}
+
+void YamlWriter::writeDoubleQuoted(std::string_view value, bool allowBreaks) {
+    static constexpr char sDigits[] = "0123456789ABCDEF";
+
+    writeIndicator("\"", true, false, false);
+
+    bool spaces = false;
+    const size_t size = value.size();
+    while (!value.empty()) {
+        const size_t pos = size - value.size();
+        const u8 octet = static_cast<u8>(value[0]);
+        const bool isBom = octet == 0xef && byteAt(value, 1) == 0xbb && byteAt(value, 2) == 0xbf;
+        if (!isPrintableAt(value, 0) || isBom || isBreakAt(value, 0) || octet == '"' || octet == '\\') {
+            const size_t width = std::min(charWidth(octet), value.size());
+            u32 codepoint = width == 1 ? octet : width == 2 ? octet & 0x1f : width == 3 ? octet & 0x0f : octet & 0x07;
+            for (size_t i = 1; i < width; ++i) {
+                codepoint = (codepoint << 6) | (static_cast<u8>(value[i]) & 0x3f);
+            }
+            value.remove_prefix(width);
+
+            put('\\');
+            switch (codepoint) {
+                case 0x00: put('0'); break;
+                case 0x07: put('a'); break;
+                case 0x08: put('b'); break;
+                case 0x09: put('t'); break;
+                case 0x0a: put('n'); break;
+                case 0x0b: put('v'); break;
+                case 0x0c: put('f'); break;
+                case 0x0d: put('r'); break;
+                case 0x1b: put('e'); break;
+                case 0x22: put('"'); break;
+                case 0x5c: put('\\'); break;
+                case 0x85: put('N'); break;
+                case 0xa0: put('_'); break;
+                case 0x2028: put('L'); break;
+                case 0x2029: put('P'); break;
+                default: {
+                    s32 digits;
+                    if (codepoint <= 0xff) {
+                        put('x');
+                        digits = 2;
+                    } else if (codepoint <= 0xffff) {
+                        put('u');
+                        digits = 4;
+                    } else {
+                        put('U');
+                        digits = 8;
+                    }
+                    for (s32 shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+                        put(sDigits[(codepoint >> shift) & 0xf]);
+                    }
+                    break;
+                }
+            }
+            spaces = false;
+        } else if (octet == ' ') {
+            if (allowBreaks && !spaces && mColumn > mWidth && pos != 0 && pos != size - 1) {
+                writeIndent();
+                if (byteAt(value, 1) == ' ') {
+                    put('\\');
+                }
+                value.remove_prefix(1);
+            } else {
+                writeChar(value);
+            }
+            spaces = true;
+        } else {
+            writeChar(value);
+            spaces = false;
+        }
+    }
+
+    writeIndicator("\"", false, false, false);
+
+    mWhitespace = false;
+    mIndention = false;
+}
+
+} // namespace banana
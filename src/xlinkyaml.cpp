@@ -1,18 +1,94 @@
 #include "system.h"
+#include "digest.h"
 #include "util/error.h"
 #include "util/crc32.h"
+#include "util/dictionary.h"
+#include "util/file.h"
+#include "util/fragment_cache.h"
+#include "util/hash.h"
+#include "util/parallel.h"
 
 #include "usernames.inc"
 
+#include <algorithm>
+#include <array>
 #include <bit>
+#include <cctype>
+#include <cmath>
+#include <deque>
+#include <filesystem>
 #include <iostream>
 #include <format>
+#include <unordered_map>
 #include <variant>
 
 namespace banana {
 
-void System::dumpCurve(LibyamlEmitterWithStorage<std::string>& emitter, const Curve& curve) const {
-    LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+// fields written inside each user, in order
+static constexpr std::array<std::string_view, 11> cUserSections = {
+    "LocalProperties", "UserParams", "Containers", "AssetCallTables", "ActionSlots", "Actions",
+    "ActionTriggers", "Properties", "PropertyTriggers", "AlwaysTriggers", "Unknown",
+};
+
+static bool WantsSection(const DumpOptions& options, std::string_view name) {
+    return options.sections.empty() || options.sections.contains(name);
+}
+
+static bool NamesUserSection(const DumpOptions& options) {
+    return std::ranges::any_of(cUserSections, [&](std::string_view name) { return options.sections.contains(name); });
+}
+
+// asking for Users on its own gives whole users, naming anything inside a user narrows them down to just that
+static bool WantsUserSection(const DumpOptions& options, std::string_view name) {
+    return !NamesUserSection(options) || options.sections.contains(name);
+}
+
+// finds pool entries identical to an earlier one so the compact profile can write them as an alias of the first
+class RepeatTable {
+public:
+    template <typename T>
+    RepeatTable(const std::vector<T>& pool, std::string_view prefix, bool enabled) : mPrefix(prefix) {
+        if (!enabled)
+            return;
+        mFirst.resize(pool.size());
+        mAnchored.resize(pool.size());
+        std::unordered_map<std::string, u32> seen;
+        seen.reserve(pool.size());
+        for (u32 i = 0; i < pool.size(); ++i) {
+            DigestKey key{};
+            digest(key, pool[i]);
+            const auto [it, inserted] = seen.try_emplace(std::move(key.bytes), i);
+            mFirst[i] = it->second;
+            if (!inserted) {
+                mAnchored[it->second] = true;
+            }
+        }
+    }
+
+    // writes an alias and returns true if the entry is a repeat, otherwise anchors it if anything refers back to it
+    template <typename Emitter>
+    bool emit(Emitter& emitter, u32 index) const {
+        if (index >= mFirst.size())
+            return false;
+        if (mFirst[index] != index) {
+            emitter.EmitAlias(std::format("{}{}", mPrefix, mFirst[index]));
+            return true;
+        }
+        if (mAnchored[index]) {
+            emitter.SetAnchor(std::format("{}{}", mPrefix, index));
+        }
+        return false;
+    }
+
+private:
+    std::string_view mPrefix;
+    std::vector<u32> mFirst{};
+    std::vector<bool> mAnchored{};
+};
+
+template <typename Emitter>
+void System::dumpCurve(Emitter& emitter, const Curve& curve) const {
+    typename Emitter::MappingScope scope{emitter, {}, YamlWriter::Block};
     emitter.EmitString("PropertyName");
     emitter.EmitString(curve.propertyName); // should verify this is matches the corresponding index if the property is local
     emitter.EmitString("PropertyIndex");
@@ -27,10 +103,10 @@ void System::dumpCurve(LibyamlEmitterWithStorage<std::string>& emitter, const Cu
     emitter.EmitInt(curve.unk2);
     emitter.EmitString("Points");
     {
-        LibyamlEmitter::SequenceScope seqScope{emitter, {}, curve.points.size() > 5 ? YAML_BLOCK_SEQUENCE_STYLE
-                                                                                    : YAML_FLOW_SEQUENCE_STYLE};
+        typename Emitter::SequenceScope seqScope{emitter, {}, curve.points.size() > 5 ? YamlWriter::Block
+                                                                                    : YamlWriter::Flow};
         for (const auto& point : curve.points) {
-            LibyamlEmitter::MappingScope pointScope{emitter, {}, YAML_FLOW_MAPPING_STYLE};
+            typename Emitter::MappingScope pointScope{emitter, {}, YamlWriter::Flow};
             emitter.EmitString("x");
             emitter.EmitFloat(point.x);
             emitter.EmitString("y");
@@ -39,18 +115,20 @@ void System::dumpCurve(LibyamlEmitterWithStorage<std::string>& emitter, const Cu
     }
 }
 
-void System::dumpRandom(LibyamlEmitterWithStorage<std::string>& emitter, const Random& random) const {
-    LibyamlEmitter::MappingScope scope{emitter, {}, YAML_FLOW_MAPPING_STYLE};
+template <typename Emitter>
+void System::dumpRandom(Emitter& emitter, const Random& random) const {
+    typename Emitter::MappingScope scope{emitter, {}, YamlWriter::Flow};
     emitter.EmitString("Min");
     emitter.EmitFloat(random.min);
     emitter.EmitString("Max");
     emitter.EmitFloat(random.max);
 }
 
-void System::dumpArrangeGroupParam(LibyamlEmitterWithStorage<std::string>& emitter, const ArrangeGroupParams& groups) const {
-    LibyamlEmitter::SequenceScope seqScope{emitter, {}, YAML_BLOCK_SEQUENCE_STYLE};
+template <typename Emitter>
+void System::dumpArrangeGroupParam(Emitter& emitter, const ArrangeGroupParams& groups, YamlWriter::Style style) const {
+    typename Emitter::SequenceScope seqScope{emitter, {}, YamlWriter::Block};
     for (const auto& group : groups.groups) {
-        LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+        typename Emitter::MappingScope scope{emitter, {}, style};
         emitter.EmitString("GroupName");
         emitter.EmitString(group.groupName);
         emitter.EmitString("LimitType");
@@ -63,7 +141,46 @@ void System::dumpArrangeGroupParam(LibyamlEmitterWithStorage<std::string>& emitt
 }
 
 
-void System::dumpParam(LibyamlEmitterWithStorage<std::string>& emitter, const Param& param, ParamType type) const {
+// loadParam rebuilds an inline value from the define's type, so anything that wouldn't come back with the same type
+// and bits (a type that doesn't match the define, bools other than 0 or 1, nan payloads) has to stay an index
+bool System::canInlineDirectValue(const Param& param, ParamType type) const {
+    const auto& value = mDirectValues[std::get<u32>(param.value)];
+    const auto defineType = mPDT.getParam(param.index, type).getType();
+    return value.type.e == defineType
+        && (defineType != xlink2::ParamType::Bool || value.value.u <= 1)
+        && (defineType != xlink2::ParamType::Float || !std::isnan(value.value.f));
+}
+
+size_t System::countDumpedDirectValues(const DumpOptions& options) const {
+    if (!options.inlineDirectValues) {
+        return mDirectValues.size();
+    }
+    size_t count = 0;
+    const auto visit = [&](const Param& param, ParamType type) {
+        if (param.type == xlink2::ValueReferenceType::Direct && !canInlineDirectValue(param, type)) {
+            count = std::max(count, static_cast<size_t>(std::get<u32>(param.value)) + 1);
+        }
+    };
+    for (const auto& [hash, user] : mUsers) {
+        for (const auto& param : user.mUserParams) {
+            visit(param, ParamType::USER);
+        }
+    }
+    for (const auto& set : mAssetParams) {
+        for (const auto& param : set.params) {
+            visit(param, ParamType::ASSET);
+        }
+    }
+    for (const auto& set : mTriggerOverwriteParams) {
+        for (const auto& param : set.params) {
+            visit(param, ParamType::TRIGGER);
+        }
+    }
+    return count;
+}
+
+template <typename Emitter>
+void System::dumpParam(Emitter& emitter, const Param& param, ParamType type, const DumpOptions& options) const {
     xlink2::ParamType paramType = xlink2::ParamType::Int;
     switch (type) {
         case ParamType::USER: {
@@ -92,25 +209,39 @@ void System::dumpParam(LibyamlEmitterWithStorage<std::string>& emitter, const Pa
     using ValType = xlink2::ParamType;
     switch (param.type) {
         case RefType::Direct: {
+            const u32 index = std::get<u32>(param.value);
+            const bool inlined = options.inlineDirectValues && canInlineDirectValue(param, type);
             switch (paramType) {
                 case ValType::Int: {
-                    emitter.EmitInt(std::get<u32>(param.value), "!directValue");
-                    // emitter.EmitInt(getDirectValueS32(std::get<u32>(param.value)));
+                    if (inlined) {
+                        emitter.EmitInt(getDirectValueS32(index));
+                    } else {
+                        emitter.EmitInt(index, "!directValue");
+                    }
                     break;
                 }
                 case ValType::Float: {
-                    emitter.EmitInt(std::get<u32>(param.value), "!directValue");
-                    // emitter.EmitFloat(getDirectValueF32(std::get<u32>(param.value)));
+                    if (inlined) {
+                        emitter.EmitFloat(getDirectValueF32(index));
+                    } else {
+                        emitter.EmitInt(index, "!directValue");
+                    }
                     break;
                 }
                 case ValType::Bool: {
-                    emitter.EmitInt(std::get<u32>(param.value), "!directValue");
-                    // emitter.EmitBool(getDirectValueU32(std::get<u32>(param.value)) != 0);
+                    if (inlined) {
+                        emitter.EmitBool(getDirectValueU32(index) != 0);
+                    } else {
+                        emitter.EmitInt(index, "!directValue");
+                    }
                     break;
                 }
                 case ValType::Enum: {
-                    emitter.EmitInt(std::get<u32>(param.value), "!directValue");
-                    // emitter.EmitScalar(std::format("{:#010x}", getDirectValueU32(std::get<u32>(param.value))), false, false, "!u");
+                    if (inlined) {
+                        emitter.EmitHex(getDirectValueU32(index), "!u");
+                    } else {
+                        emitter.EmitInt(index, "!directValue");
+                    }
                     break;
                 }
                 case ValType::String:
@@ -150,9 +281,9 @@ void System::dumpParam(LibyamlEmitterWithStorage<std::string>& emitter, const Pa
         case RefType::RandomPowComplement1Point5: {
             if (paramType != ValType::Float)
                 throw InvalidDataError("Random calls must be floats!");
-            LibyamlEmitter::MappingScope mapScope{emitter, "!random", YAML_FLOW_MAPPING_STYLE};
+            typename Emitter::MappingScope mapScope{emitter, "!random", YamlWriter::Flow};
             emitter.EmitString("Type");
-            emitter.EmitScalar(std::format("{:#010x}", static_cast<u32>(param.type)), false, false, "!u");
+            emitter.EmitHex(static_cast<u32>(param.type), "!u");
             emitter.EmitString("Index");
             emitter.EmitInt(std::get<u32>(param.value));
             break;
@@ -166,7 +297,7 @@ void System::dumpParam(LibyamlEmitterWithStorage<std::string>& emitter, const Pa
         case RefType::Bitfield: { // should this just be called immediate? seems to be used just for ints?
             if (paramType != ValType::Int)
                 throw InvalidDataError(std::format("Bitfields need to be ints! {:d}", static_cast<u32>(paramType)));
-            emitter.EmitScalar(std::format("{:#x}", std::get<u32>(param.value)), false, false, "!bitfield");
+            emitter.EmitHex(std::get<u32>(param.value), "!bitfield", 1);
             break;
         }
         default:
@@ -174,14 +305,16 @@ void System::dumpParam(LibyamlEmitterWithStorage<std::string>& emitter, const Pa
     }
 }
 
-void System::dumpParamSet(LibyamlEmitterWithStorage<std::string>& emitter, const ParamSet& params, ParamType type) const {
-    LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+template <typename Emitter>
+void System::dumpParamSet(Emitter& emitter, const ParamSet& params, ParamType type, const DumpOptions& options) const {
+    typename Emitter::MappingScope scope{emitter, {}, YamlWriter::Block};
     for (const auto& param : params.params) {
-        dumpParam(emitter, param, type);
+        dumpParam(emitter, param, type, options);
     }
 }
 
-void System::dumpCondition(LibyamlEmitterWithStorage<std::string>& emitter, const Condition& condition) const {
+template <typename Emitter>
+void System::dumpCondition(Emitter& emitter, const Condition& condition) const {
     static constexpr std::string_view sCompareTypeStrings[6] = {
         "Equal", "GreaterThan", "GreaterThanOrEqual",
         "LessThan", "LessThanOrEqual", "NotEqual",
@@ -194,14 +327,14 @@ void System::dumpCondition(LibyamlEmitterWithStorage<std::string>& emitter, cons
     using Type = xlink2::ContainerType;
     switch (condition.parentContainerType) {
         case Type::Switch: {
-            LibyamlEmitter::MappingScope scope{emitter, "!switch", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!switch", YamlWriter::Block};
             const auto cond = condition.getAs<Type::Switch>();
             emitter.EmitString("CompareType");
             emitter.EmitString(sCompareTypeStrings[static_cast<u32>(cond->compareType)]);
             emitter.EmitString("IsGlobal");
             emitter.EmitBool(cond->isGlobal);
             emitter.EmitString("Value1"); // action hash or enum value/index
-            emitter.EmitScalar(std::format("{:#010x}", cond->actionHash), false, false, "!u");
+            emitter.EmitHex(cond->actionHash, "!u");
             emitter.EmitString("Value2");
             switch (cond->propType) {
                 case xlink2::PropertyType::S32:
@@ -220,7 +353,7 @@ void System::dumpCondition(LibyamlEmitterWithStorage<std::string>& emitter, cons
                     emitter.EmitBool(cond->conditionValue.b);
                     break;
                 case xlink2::PropertyType::Enum: {
-                    emitter.EmitScalar(std::format("{:#010x}", std::bit_cast<u32, s32>(cond->conditionValue.i)), false, false, "!u");
+                    emitter.EmitHex(std::bit_cast<u32, s32>(cond->conditionValue.i), "!u");
                     emitter.EmitString("EnumName");
                     emitter.EmitString(cond->enumName);
                     break;
@@ -231,21 +364,21 @@ void System::dumpCondition(LibyamlEmitterWithStorage<std::string>& emitter, cons
             break;
         }
         case Type::Random: {
-            LibyamlEmitter::MappingScope scope{emitter, "!random", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!random", YamlWriter::Block};
             const auto cond = condition.getAs<Type::Random2>();
             emitter.EmitString("Weight");
             emitter.EmitFloat(cond->weight);
             break;
         }
         case Type::Random2: {
-            LibyamlEmitter::MappingScope scope{emitter, "!random2", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!random2", YamlWriter::Block};
             const auto cond = condition.getAs<Type::Random2>();
             emitter.EmitString("Weight");
             emitter.EmitFloat(cond->weight);
             break;
         }
         case Type::Blend: {
-            LibyamlEmitter::MappingScope scope{emitter, "!blend", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!blend", YamlWriter::Block};
             const auto cond = condition.getAs<Type::Blend>();
             emitter.EmitString("Min");
             emitter.EmitFloat(cond->min);
@@ -258,7 +391,7 @@ void System::dumpCondition(LibyamlEmitterWithStorage<std::string>& emitter, cons
             break;
         }
         case Type::Sequence: {
-            LibyamlEmitter::MappingScope scope{emitter, "!sequence", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!sequence", YamlWriter::Block};
             const auto cond = condition.getAs<Type::Sequence>();
             emitter.EmitString("ContinueOnFade");
             emitter.EmitInt(cond->continueOnFade);
@@ -266,13 +399,13 @@ void System::dumpCondition(LibyamlEmitterWithStorage<std::string>& emitter, cons
         }
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
         case Type::Grid: {
-            LibyamlEmitter::MappingScope scope{emitter, "!grid", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!grid", YamlWriter::Block};
             break;
         }
 #endif
 #if XLINK_TARGET_IS_TOTK
         case Type::Jump: {
-            LibyamlEmitter::MappingScope scope{emitter, "!jump", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!jump", YamlWriter::Block};
             break;
         }
 #endif
@@ -281,11 +414,12 @@ void System::dumpCondition(LibyamlEmitterWithStorage<std::string>& emitter, cons
     }
 }
 
-void System::dumpContainer(LibyamlEmitterWithStorage<std::string>& emitter, const Container& container) const {
+template <typename Emitter>
+void System::dumpContainer(Emitter& emitter, const Container& container) const {
     using Type = xlink2::ContainerType;
     switch (container.type) {
         case Type::Switch: {
-            LibyamlEmitter::MappingScope scope{emitter, "!switch", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!switch", YamlWriter::Block};
             const auto param = container.getAs<Type::Switch>();
             emitter.EmitString("ValueName");
             emitter.EmitString(param->actionSlotName);
@@ -311,7 +445,7 @@ void System::dumpContainer(LibyamlEmitterWithStorage<std::string>& emitter, cons
             break;
         }
         case Type::Random: {
-            LibyamlEmitter::MappingScope scope{emitter, "!random", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!random", YamlWriter::Block};
             emitter.EmitString("ChildContainerBaseIndex");
             emitter.EmitInt(container.childContainerStartIdx);
             emitter.EmitString("ChildContainerCount");
@@ -323,7 +457,7 @@ void System::dumpContainer(LibyamlEmitterWithStorage<std::string>& emitter, cons
             break;
         }
         case Type::Random2: {
-            LibyamlEmitter::MappingScope scope{emitter, "!random2", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!random2", YamlWriter::Block};
             emitter.EmitString("ChildContainerBaseIndex");
             emitter.EmitInt(container.childContainerStartIdx);
             emitter.EmitString("ChildContainerCount");
@@ -335,7 +469,7 @@ void System::dumpContainer(LibyamlEmitterWithStorage<std::string>& emitter, cons
             break;
         }
         case Type::Blend: {
-            LibyamlEmitter::MappingScope scope{emitter, "!blend", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!blend", YamlWriter::Block};
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
             if (container.isNotBlendAll) {
                 const auto param = container.getAs<Type::Blend, true>();
@@ -360,7 +494,7 @@ void System::dumpContainer(LibyamlEmitterWithStorage<std::string>& emitter, cons
             break;
         }
         case Type::Sequence: {
-            LibyamlEmitter::MappingScope scope{emitter, "!sequence", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!sequence", YamlWriter::Block};
             emitter.EmitString("ChildContainerBaseIndex");
             emitter.EmitInt(container.childContainerStartIdx);
             emitter.EmitString("ChildContainerCount");
@@ -373,7 +507,7 @@ void System::dumpContainer(LibyamlEmitterWithStorage<std::string>& emitter, cons
         }
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
         case Type::Grid: {
-            LibyamlEmitter::MappingScope scope{emitter, "!grid", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!grid", YamlWriter::Block};
             const auto param = container.getAs<Type::Grid>();;
             emitter.EmitString("PropertyName1");
             emitter.EmitString(param->propertyName1);
@@ -389,21 +523,21 @@ void System::dumpContainer(LibyamlEmitterWithStorage<std::string>& emitter, cons
             emitter.EmitBool(param->isGlobal2);
             emitter.EmitString("Property1Values");
             {
-                LibyamlEmitter::SequenceScope seqScope{emitter, {}, YAML_FLOW_SEQUENCE_STYLE};
+                typename Emitter::SequenceScope seqScope{emitter, {}, YamlWriter::Flow};
                 for (const auto value : param->values1) {
                     emitter.EmitInt(value);
                 }
             }
             emitter.EmitString("Property2Values");
             {
-                LibyamlEmitter::SequenceScope seqScope{emitter, {}, YAML_FLOW_SEQUENCE_STYLE};
+                typename Emitter::SequenceScope seqScope{emitter, {}, YamlWriter::Flow};
                 for (const auto value : param->values2) {
                     emitter.EmitInt(value);
                 }
             }
             emitter.EmitString("IndexGridMap");
             {
-                LibyamlEmitter::SequenceScope seqScope{emitter, {}, YAML_FLOW_SEQUENCE_STYLE};
+                typename Emitter::SequenceScope seqScope{emitter, {}, YamlWriter::Flow};
                 for (const auto index : param->indices) {
                     emitter.EmitInt(index);
                 }
@@ -419,7 +553,7 @@ void System::dumpContainer(LibyamlEmitterWithStorage<std::string>& emitter, cons
 #endif
 #if XLINK_TARGET_IS_TOTK
         case Type::Jump: {
-            LibyamlEmitter::MappingScope scope{emitter, "!jump", YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope scope{emitter, "!jump", YamlWriter::Block};
             emitter.EmitString("ChildContainerBaseIndex");
             emitter.EmitInt(container.childContainerStartIdx);
             emitter.EmitString("ChildContainerCount");
@@ -434,8 +568,9 @@ void System::dumpContainer(LibyamlEmitterWithStorage<std::string>& emitter, cons
     }
 }
 
-void System::dumpAssetCallTable(LibyamlEmitterWithStorage<std::string>& emitter, const AssetCallTable& act) const {
-    LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+template <typename Emitter>
+void System::dumpAssetCallTable(Emitter& emitter, const AssetCallTable& act) const {
+    typename Emitter::MappingScope scope{emitter, {}, YamlWriter::Block};
 
     emitter.EmitString("KeyName");
     emitter.EmitString(act.keyName);
@@ -450,17 +585,18 @@ void System::dumpAssetCallTable(LibyamlEmitterWithStorage<std::string>& emitter,
     emitter.EmitString("ParentIndex");
     emitter.EmitInt(act.parentIndex);
     emitter.EmitString("GUID");
-    emitter.EmitScalar(std::format("{:#010x}", act.guid), false, false, "!u");
+    emitter.EmitHex(act.guid, "!u");
     emitter.EmitString("KeyNameHash");
-    emitter.EmitScalar(std::format("{:#010x}", act.keyNameHash), false, false, "!u");
+    emitter.EmitHex(act.keyNameHash, "!u");
     emitter.EmitString("AssetParamOrContainerIndex");
     emitter.EmitInt(act.assetParamIdx);
     emitter.EmitString("ConditionIndex");
     emitter.EmitInt(act.conditionIdx);
 }
 
-void System::dumpActionSlot(LibyamlEmitterWithStorage<std::string>& emitter, const ActionSlot& slot) const {
-    LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+template <typename Emitter>
+void System::dumpActionSlot(Emitter& emitter, const ActionSlot& slot, YamlWriter::Style style) const {
+    typename Emitter::MappingScope scope{emitter, {}, style};
 
     emitter.EmitString("SlotName");
     emitter.EmitString(slot.actionSlotName);
@@ -470,8 +606,9 @@ void System::dumpActionSlot(LibyamlEmitterWithStorage<std::string>& emitter, con
     emitter.EmitInt(slot.actionCount);
 }
 
-void System::dumpAction(LibyamlEmitterWithStorage<std::string>& emitter, const Action& action) const {
-    LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+template <typename Emitter>
+void System::dumpAction(Emitter& emitter, const Action& action, YamlWriter::Style style) const {
+    typename Emitter::MappingScope scope{emitter, {}, style};
 
     emitter.EmitString("ActionName");
     emitter.EmitString(action.actionName);
@@ -485,11 +622,12 @@ void System::dumpAction(LibyamlEmitterWithStorage<std::string>& emitter, const A
 #endif
 }
 
-void System::dumpActionTrigger(LibyamlEmitterWithStorage<std::string>& emitter, const ActionTrigger& trigger) const {
-    LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+template <typename Emitter>
+void System::dumpActionTrigger(Emitter& emitter, const ActionTrigger& trigger) const {
+    typename Emitter::MappingScope scope{emitter, {}, YamlWriter::Block};
 
     emitter.EmitString("GUID");
-    emitter.EmitScalar(std::format("{:#010x}", trigger.guid), false, false, "!u");
+    emitter.EmitHex(trigger.guid, "!u");
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
     emitter.EmitString("Unknown");
     emitter.EmitInt(trigger.unk);
@@ -514,11 +652,12 @@ void System::dumpActionTrigger(LibyamlEmitterWithStorage<std::string>& emitter,
     emitter.EmitString("TriggerOverwriteParamIndex");
     emitter.EmitInt(trigger.triggerOverwriteIdx);
     emitter.EmitString("OverwriteHash");
-    emitter.EmitScalar(std::format("{:#06x}", trigger.overwriteHash), false, false, "!u");
+    emitter.EmitHex(trigger.overwriteHash, "!u", 4);
 }
 
-void System::dumpProperty(LibyamlEmitterWithStorage<std::string>& emitter, const Property& prop) const {
-    LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+template <typename Emitter>
+void System::dumpProperty(Emitter& emitter, const Property& prop, YamlWriter::Style style) const {
+    typename Emitter::MappingScope scope{emitter, {}, style};
 
     emitter.EmitString("PropertyName");
     emitter.EmitString(prop.propertyName);
@@ -530,15 +669,16 @@ void System::dumpProperty(LibyamlEmitterWithStorage<std::string>& emitter, const
     emitter.EmitInt(prop.propTriggerCount);
 }
 
-void System::dumpPropertyTrigger(LibyamlEmitterWithStorage<std::string>& emitter, const PropertyTrigger& trigger) const {
-    LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+template <typename Emitter>
+void System::dumpPropertyTrigger(Emitter& emitter, const PropertyTrigger& trigger, YamlWriter::Style style) const {
+    typename Emitter::MappingScope scope{emitter, {}, style};
 
     emitter.EmitString("GUID");
-    emitter.EmitScalar(std::format("{:#010x}", trigger.guid), false, false, "!u");
+    emitter.EmitHex(trigger.guid, "!u");
     emitter.EmitString("Flag");
     emitter.EmitInt(trigger.flag);
     emitter.EmitString("OverwriteHash");
-    emitter.EmitScalar(std::format("{:#06x}", trigger.overwriteHash), false, false, "!u");
+    emitter.EmitHex(trigger.overwriteHash, "!u", 4);
     emitter.EmitString("AssetCallTableIndex");
     emitter.EmitInt(trigger.assetCallTableIdx);
     emitter.EmitString("ConditionIndex");
@@ -547,42 +687,45 @@ void System::dumpPropertyTrigger(LibyamlEmitterWithStorage<std::string>& emitter
     emitter.EmitInt(trigger.triggerOverwriteIdx);
 }
 
-void System::dumpAlwaysTrigger(LibyamlEmitterWithStorage<std::string>& emitter, const AlwaysTrigger& trigger) const {
-    LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+template <typename Emitter>
+void System::dumpAlwaysTrigger(Emitter& emitter, const AlwaysTrigger& trigger, YamlWriter::Style style) const {
+    typename Emitter::MappingScope scope{emitter, {}, style};
 
     emitter.EmitString("GUID");
-    emitter.EmitScalar(std::format("{:#010x}", trigger.guid), false, false, "!u");
+    emitter.EmitHex(trigger.guid, "!u");
     emitter.EmitString("Flag");
     emitter.EmitInt(trigger.flag);
     emitter.EmitString("OverwriteHash");
-    emitter.EmitScalar(std::format("{:#06x}", trigger.overwriteHash), false, false, "!u");
+    emitter.EmitHex(trigger.overwriteHash, "!u", 4);
     emitter.EmitString("AssetCallTableIndex");
     emitter.EmitInt(trigger.assetCallIdx);
     emitter.EmitString("TriggerOverwriteParamIndex");
     emitter.EmitInt(trigger.triggerOverwriteIdx);
 }
 
-void System::dumpUser(LibyamlEmitterWithStorage<std::string>& emitter, const User& user) const {
-    LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+template <typename Emitter>
+void System::dumpUser(Emitter& emitter, const User& user, const DumpOptions& options) const {
+    typename Emitter::MappingScope scope{emitter, {}, YamlWriter::Block};
+    const auto recordStyle = options.compact ? YamlWriter::Flow : YamlWriter::Block;
 
-    emitter.EmitString("LocalProperties");
-    {
-        LibyamlEmitter::SequenceScope seqScope{emitter, {}, YAML_BLOCK_SEQUENCE_STYLE};
+    if (WantsUserSection(options, "LocalProperties")) {
+        emitter.EmitString("LocalProperties");
+        typename Emitter::SequenceScope seqScope{emitter, {}, YamlWriter::Block};
         for (const auto& prop : user.mLocalProperties) {
             emitter.EmitString(prop);
         }
     }
-    emitter.EmitString("UserParams");
-    {
-        LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+    if (WantsUserSection(options, "UserParams")) {
+        emitter.EmitString("UserParams");
+        typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
         for (const auto& param : user.mUserParams) {
-            dumpParam(emitter, param, ParamType::USER);
+            dumpParam(emitter, param, ParamType::USER, options);
         }
     }
 
-    emitter.EmitString("Containers");
-    {
-        LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+    if (WantsUserSection(options, "Containers")) {
+        emitter.EmitString("Containers");
+        typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
         for (u32 i = 0; const auto& container : user.mContainers) {
             emitter.EmitInt(i);
             dumpContainer(emitter, container);
@@ -590,9 +733,9 @@ void System::dumpUser(LibyamlEmitterWithStorage<std::string>& emitter, const Use
         }
     }
 
-    emitter.EmitString("AssetCallTables");
-    {
-        LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+    if (WantsUserSection(options, "AssetCallTables")) {
+        emitter.EmitString("AssetCallTables");
+        typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
         for (u32 i = 0; const auto& act: user.mAssetCallTables) {
             emitter.EmitInt(i);
             dumpAssetCallTable(emitter, act);
@@ -600,29 +743,29 @@ void System::dumpUser(LibyamlEmitterWithStorage<std::string>& emitter, const Use
         }
     }
 
-    emitter.EmitString("ActionSlots");
-    {
-        LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+    if (WantsUserSection(options, "ActionSlots")) {
+        emitter.EmitString("ActionSlots");
+        typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
         for (u32 i = 0; const auto& slot: user.mActionSlots) {
             emitter.EmitInt(i);
-            dumpActionSlot(emitter, slot);
+            dumpActionSlot(emitter, slot, recordStyle);
             ++i;
         }
     }
 
-    emitter.EmitString("Actions");
-    {
-        LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+    if (WantsUserSection(options, "Actions")) {
+        emitter.EmitString("Actions");
+        typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
         for (u32 i = 0; const auto& action: user.mActions) {
             emitter.EmitInt(i);
-            dumpAction(emitter, action);
+            dumpAction(emitter, action, recordStyle);
             ++i;
         }
     }
 
-    emitter.EmitString("ActionTriggers");
-    {
-        LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+    if (WantsUserSection(options, "ActionTriggers")) {
+        emitter.EmitString("ActionTriggers");
+        typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
         for (u32 i = 0; const auto& trigger: user.mActionTriggers) {
             emitter.EmitInt(i);
             dumpActionTrigger(emitter, trigger);
@@ -630,108 +773,133 @@ void System::dumpUser(LibyamlEmitterWithStorage<std::string>& emitter, const Use
         }
     }
 
-    emitter.EmitString("Properties");
-    {
-        LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+    if (WantsUserSection(options, "Properties")) {
+        emitter.EmitString("Properties");
+        typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
         for (u32 i = 0; const auto& prop: user.mProperties) {
             emitter.EmitInt(i);
-            dumpProperty(emitter, prop);
+            dumpProperty(emitter, prop, recordStyle);
             ++i;
         }
     }
 
-    emitter.EmitString("PropertyTriggers");
-    {
-        LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+    if (WantsUserSection(options, "PropertyTriggers")) {
+        emitter.EmitString("PropertyTriggers");
+        typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
         for (u32 i = 0; const auto& trigger: user.mPropertyTriggers) {
             emitter.EmitInt(i);
-            dumpPropertyTrigger(emitter, trigger);
+            dumpPropertyTrigger(emitter, trigger, recordStyle);
             ++i;
         }
     }
 
-    emitter.EmitString("AlwaysTriggers");
-    {
-        LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+    if (WantsUserSection(options, "AlwaysTriggers")) {
+        emitter.EmitString("AlwaysTriggers");
+        typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
         for (u32 i = 0; const auto& trigger: user.mAlwaysTriggers) {
             emitter.EmitInt(i);
-            dumpAlwaysTrigger(emitter, trigger);
+            dumpAlwaysTrigger(emitter, trigger, recordStyle);
             ++i;
         }
     }
 
 #if XLINK_TARGET == TOTK
-    emitter.EmitString("Unknown");
-    emitter.EmitInt(user.mUnknown);
+    if (WantsUserSection(options, "Unknown")) {
+        emitter.EmitString("Unknown");
+        emitter.EmitInt(user.mUnknown);
+    }
 #endif
 }
 
-std::string System::dumpYAML(bool exportStrings) const {
-    LibyamlEmitterWithStorage<std::string> emitter{};
-    yaml_event_t event;
+std::string System::dumpYAML(const DumpOptions& options) const {
+    YamlWriter emitter{};
+    dumpYAML(emitter, options);
+    return std::move(emitter.GetOutput());
+}
+
+void System::dumpYAML(YamlWriter& emitter, const DumpOptions& options) const {
+    dumpDocument(emitter, options);
+}
 
-    yaml_stream_start_event_initialize(&event, YAML_UTF8_ENCODING);
-    emitter.Emit(event);
+std::string System::dumpJSON(const DumpOptions& options) const {
+    JsonWriter emitter{};
+    dumpJSON(emitter, options);
+    return std::move(emitter.GetOutput());
+}
 
-    yaml_document_start_event_initialize(&event, nullptr, nullptr, nullptr, 1);
-    emitter.Emit(event);
+void System::dumpJSON(JsonWriter& emitter, const DumpOptions& options) const {
+    // json has no aliases, and the fragment cache only holds yaml
+    DumpOptions jsonOptions = options;
+    jsonOptions.compact = false;
+    jsonOptions.fragmentCache = nullptr;
+    dumpDocument(emitter, jsonOptions);
+}
 
+template <typename Emitter>
+void System::dumpDocument(Emitter& emitter, const DumpOptions& options) const {
     {
-        LibyamlEmitter::MappingScope scope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+        typename Emitter::MappingScope scope{emitter, {}, YamlWriter::Block};
 
         emitter.EmitString("Version");
         emitter.EmitInt(mVersion);
 
-        mPDT.dumpYAML(emitter, exportStrings);
-        {
+        if (WantsSection(options, "ParamDefineTable")) {
+            mPDT.dumpYAML(emitter, options.exportStrings);
+        }
+        if (WantsSection(options, "LocalProperties")) {
             emitter.EmitString("LocalProperties");
-            LibyamlEmitter::SequenceScope seqScope{emitter, {}, YAML_BLOCK_SEQUENCE_STYLE};
+            typename Emitter::SequenceScope seqScope{emitter, {}, YamlWriter::Block};
             for (const auto& prop : mLocalProperties) {
                 emitter.EmitString(prop);
             }
         }
-        {
+        if (WantsSection(options, "LocalPropertyEnumValues")) {
             emitter.EmitString("LocalPropertyEnumValues");
-            LibyamlEmitter::SequenceScope seqScope{emitter, {}, YAML_BLOCK_SEQUENCE_STYLE};
+            typename Emitter::SequenceScope seqScope{emitter, {}, YamlWriter::Block};
             for (const auto& prop : mLocalPropertyEnumStrings) {
                 emitter.EmitString(prop);
             }
         }
-        {
+        if (WantsSection(options, "Curves")) {
             emitter.EmitString("Curves");
-            LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
             for (u32 i = 0; const auto& curve : mCurves) {
                 emitter.EmitInt(i);
                 dumpCurve(emitter, curve);
                 ++i;
             }
         }
-        {
+        if (WantsSection(options, "RandomTable")) {
             emitter.EmitString("RandomTable");
-            LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
             for (u32 i = 0; const auto& rand : mRandomCalls) {
                 emitter.EmitInt(i);
                 dumpRandom(emitter, rand);
                 ++i;
             }
         }
-        {
+        if (WantsSection(options, "ArrangeGroupParams")) {
             emitter.EmitString("ArrangeGroupParams");
-            LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
+            const RepeatTable repeats{mArrangeGroupParams, "arrange", options.compact};
             for (u32 i = 0; const auto& group : mArrangeGroupParams) {
                 emitter.EmitInt(i);
-                dumpArrangeGroupParam(emitter, group);
+                if (!repeats.emit(emitter, i)) {
+                    dumpArrangeGroupParam(emitter, group, options.compact ? YamlWriter::Flow : YamlWriter::Block);
+                }
                 ++i;
             }
         }
-        {
+        if (WantsSection(options, "DirectValues")) {
             emitter.EmitString("DirectValues");
-            LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
-            for (u32 i = 0; const auto& value : mDirectValues) {
+            typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
+            // with inlined values this stops after the last entry a param still refers to by index (usually that's
+            // none at all), the rest of the table gets rebuilt from the inlined values on import
+            for (u32 i = 0; const auto& value : std::span<const DirectValue>{mDirectValues}.first(countDumpedDirectValues(options))) {
                 emitter.EmitInt(i);
                 switch (value.type.e) {
                     case static_cast<xlink2::ParamType>(-1): {
-                        emitter.EmitScalar(std::format("{:#010x}", value.value.u), false, false, "!unknown");
+                        emitter.EmitHex(value.value.u, "!unknown");
                         break;
                     }
                     case xlink2::ParamType::Int: {
@@ -747,7 +915,7 @@ std::string System::dumpYAML(bool exportStrings) const {
                         break;
                     }
                     case xlink2::ParamType::Enum: {
-                        emitter.EmitScalar(std::format("{:#010x}", value.value.u), false, false, "!u");
+                        emitter.EmitHex(value.value.u, "!u");
                         break;
                     }
                     default:
@@ -756,73 +924,227 @@ std::string System::dumpYAML(bool exportStrings) const {
                 ++i;
             }
         }
-        {
+        if (WantsSection(options, "AssetParams")) {
             emitter.EmitString("AssetParams");
-            LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
+            const RepeatTable repeats{mAssetParams, "asset", options.compact};
             for (u32 i = 0; const auto& param : mAssetParams) {
                 emitter.EmitInt(i);
-                dumpParamSet(emitter, param, ParamType::ASSET);
+                if (!repeats.emit(emitter, i)) {
+                    dumpParamSet(emitter, param, ParamType::ASSET, options);
+                }
                 ++i;
             }
         }
-        {
+        if (WantsSection(options, "TriggerOverwriteParams")) {
             emitter.EmitString("TriggerOverwriteParams");
-            LibyamlEmitter::MappingScope mapScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
+            const RepeatTable repeats{mTriggerOverwriteParams, "trigger", options.compact};
             for (u32 i = 0; const auto& param : mTriggerOverwriteParams) {
                 emitter.EmitInt(i);
-                dumpParamSet(emitter, param, ParamType::TRIGGER);
+                if (!repeats.emit(emitter, i)) {
+                    dumpParamSet(emitter, param, ParamType::TRIGGER, options);
+                }
                 ++i;
             }
         }
-        {
+        if (WantsSection(options, "Conditions")) {
             emitter.EmitString("Conditions");
-            LibyamlEmitter::MappingScope seqScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
+            typename Emitter::MappingScope seqScope{emitter, {}, YamlWriter::Block};
             for (u32 i = 0; const auto& condition : mConditions) {
                 emitter.EmitInt(i);
                 dumpCondition(emitter, condition);
                 ++i;
             }
         }
-        {
+        if (WantsSection(options, "Users") || NamesUserSection(options)) {
             emitter.EmitString("Users");
-            LibyamlEmitter::MappingScope seqScope{emitter, {}, YAML_BLOCK_MAPPING_STYLE};
-            for (const auto& [hash, user] : mUsers) {
-                const auto res = mVersion == 0x24 ? sELinkUserNames.find(hash) : sSLinkUserNames.find(hash);
-                if (res == (mVersion == 0x24 ? sELinkUserNames.end() : sSLinkUserNames.end())) {
-                    emitter.EmitScalar(std::format("{:#010x}", hash), false, false, "!u");
-                } else {
-                    emitter.EmitString(res->second);
-                }
-                dumpUser(emitter, user);
+            if (mUsers.empty() || !options.includeUsers) {
+                typename Emitter::MappingScope mapScope{emitter, {}, YamlWriter::Block};
+            } else {
+                emitter.BeginRawValue();
+                dumpUsers(emitter, options);
             }
         }
-        if (exportStrings) {
+        if (options.exportStrings && WantsSection(options, "Strings")) {
             emitter.EmitString("Strings");
-            LibyamlEmitter::SequenceScope seqScope{emitter, {}, YAML_BLOCK_SEQUENCE_STYLE};
+            typename Emitter::SequenceScope seqScope{emitter, {}, YamlWriter::Block};
             for (const auto& string : mStrings) {
                 emitter.EmitString(string);
             }
         }
     }
 
-    yaml_document_end_event_initialize(&event, 1);
-    emitter.Emit(event);
+    emitter.Finish();
+}
 
-    yaml_stream_end_event_initialize(&event);
-    emitter.Emit(event);
+template <typename Emitter>
+void System::dumpUsers(Emitter& emitter, const DumpOptions& options) const {
+    std::vector<const std::pair<const u32, User>*> users;
+    users.reserve(mUsers.size());
+    for (const auto& entry : mUsers) {
+        users.push_back(&entry);
+    }
 
-    return std::move(emitter.GetOutput());
+    // users are independent of each other so each one gets its own emitter on a worker thread
+    // they're done a batch at a time so only a handful of fragments are ever alive when the output is being streamed
+    const size_t batchSize = util::getWorkerCount() * 4;
+    std::vector<std::string> fragments;
+    for (size_t start = 0; start < users.size(); start += batchSize) {
+        const size_t count = std::min(batchSize, users.size() - start);
+        fragments.assign(count, {});
+        util::parallelFor(count, [&](size_t i) {
+            const auto& [hash, user] = *users[start + i];
+            if constexpr (std::is_same_v<Emitter, JsonWriter>) {
+                fragments[i] = dumpUserFragmentJSON(hash, user, options);
+            } else {
+                fragments[i] = dumpUserFragment(hash, user, 2, options);
+            }
+        });
+        for (const auto& fragment : fragments) {
+            emitter.WriteRaw(fragment);
+        }
+    }
 }
 
-template<typename T>
-inline std::optional<T> FindParseScalar(const std::string_view key, const c4::yml::ConstNodeRef& node) {
-    const auto child = node.find_child(StrViewToRymlSubstr(key));
-    if (child.invalid())
-        return std::nullopt;
-    
-    return ParseScalarAs<T>(child);
+std::string_view System::lookupUserName(u32 hash) const {
+    const auto name = mVersion == 0x24 ? sELinkUserNames.find(hash) : sSLinkUserNames.find(hash);
+    if (name.empty() && mNames != nullptr) {
+        return mNames->findName(util::NameDictionary::Section::User, hash);
+    }
+    return name;
+}
+
+template <typename Emitter>
+void System::dumpUserName(Emitter& emitter, u32 hash) const {
+    const auto name = lookupUserName(hash);
+    if (name.empty()) {
+        emitter.EmitHex(hash, "!u");
+    } else {
+        emitter.EmitString(name);
+    }
+}
+
+u64 System::getFragmentContext(const DumpOptions& options) const {
+    util::XXHash64 hasher;
+    // user names are looked up by version, and in the dictionary if there is one
+    digestValue(hasher, mVersion);
+    digestValue(hasher, mNames != nullptr ? mNames->getContentHash() : 0);
+    digest(hasher, mPDT);
+    digestValue(hasher, options.inlineDirectValues);
+    digestValue(hasher, options.compact);
+    digestValue(hasher, static_cast<u32>(options.sections.size()));
+    for (const auto& section : options.sections) {
+        digestString(hasher, section);
+    }
+    return hasher.digest();
+}
+
+u64 System::getUserFragmentKey(u32 hash, const User& user, u32 indent, const DumpOptions& options) const {
+    util::XXHash64 hasher;
+    digestValue(hasher, hash);
+    digestValue(hasher, user.getContentHash());
+    digestValue(hasher, indent);
+    // inlined direct values are the only pool contents a user's yaml shows, everything else is written as an index
+    // (the type decides whether it's inlined at all)
+    if (options.inlineDirectValues) {
+        for (const auto& param : user.mUserParams) {
+            if (param.type == xlink2::ValueReferenceType::Direct) {
+                const auto& value = mDirectValues[std::get<u32>(param.value)];
+                digestValue(hasher, value.type.u);
+                digestValue(hasher, value.value.u);
+            }
+        }
+    }
+    return hasher.digest();
+}
+
+std::string System::dumpUserFragment(u32 hash, const User& user, u32 indent, const DumpOptions& options) const {
+    u64 cacheKey = 0;
+    if (options.fragmentCache != nullptr) {
+        cacheKey = getUserFragmentKey(hash, user, indent, options);
+        if (const auto cached = options.fragmentCache->find(cacheKey); !cached.empty()) {
+            return std::string(cached);
+        }
+    }
+
+    YamlWriter emitter{};
+    // narrower so long scalars get folded at the same column as they would be in the full document
+    emitter.SetWidth(120 - static_cast<s32>(indent));
+
+    {
+        YamlWriter::MappingScope scope{emitter, {}, YamlWriter::Block};
+        dumpUserName(emitter, hash);
+        dumpUser(emitter, user, options);
+    }
+    emitter.Finish();
+
+    // shift everything over to the nesting level it ends up at, indentation is the only thing that differs
+    const std::string_view text = emitter.GetOutput();
+    std::string result;
+    result.reserve(text.size() + text.size() / 16 * indent);
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        const auto line = text.substr(pos, end - pos);
+        if (!line.empty()) {
+            result.append(indent, ' ');
+            result.append(line);
+        }
+        result.push_back('\n');
+        pos = end + 1;
+    }
+    if (options.fragmentCache != nullptr) {
+        options.fragmentCache->store(cacheKey, result);
+    }
+    return result;
 }
 
+std::string System::dumpUserFragmentJSON(u32 hash, const User& user, const DumpOptions& options) const {
+    // just the "name":{...} member, the braces around it belong to the Users object
+    JsonWriter emitter{};
+    emitter.BeginFragment();
+    dumpUserName(emitter, hash);
+    dumpUser(emitter, user, options);
+    emitter.EndFragment();
+    return std::move(emitter.GetOutput());
+}
+
+// hands out a mapping's fields assuming they're read in the same order dumpYAML writes them
+// the expected next sibling is checked first and only a mismatch falls back to searching the whole mapping
+class FieldCursor {
+public:
+    explicit FieldCursor(const c4::yml::ConstNodeRef& node) : mNode(node), mNext(node.first_child()) {}
+
+    // invalid if there's no such field
+    c4::yml::ConstNodeRef find(const std::string_view key) {
+        c4::yml::ConstNodeRef child = mNext;
+        if (child.invalid() || RymlSubstrToStrView(child.key()) != key) {
+            child = mNode.find_child(StrViewToRymlSubstr(key));
+            if (child.invalid())
+                return child;
+        }
+        mNext = child.next_sibling();
+        return child;
+    }
+
+    template<typename T>
+    T get(const std::string_view key) {
+        const auto child = find(key);
+        if (child.invalid())
+            throw ParseError(std::format("Did not find {} field!", key));
+
+        return DecodeScalar<T>(child);
+    }
+
+private:
+    c4::yml::ConstNodeRef mNode;
+    c4::yml::ConstNodeRef mNext;
+};
+
 inline void ParseSequence(const c4::yml::ConstNodeRef& node, void* userdata, void(*callback)(void*, const c4::yml::ConstNodeRef&, u32)) {
     for (u32 i = 0; const auto& child : node) {
         callback(userdata, child, i); ++i;
@@ -830,24 +1152,27 @@ inline void ParseSequence(const c4::yml::ConstNodeRef& node, void* userdata, voi
 }
 
 void System::loadCurve(Curve& curve, const c4::yml::ConstNodeRef& node) {
-    curve.propertyName = addString(*FindParseScalar<std::string>("PropertyName", node));
-    curve.propertyIndex = static_cast<s16>(*FindParseScalar<u64>("PropertyIndex", node));
-    curve.isGlobal = *FindParseScalar<bool>("IsGlobal", node);
-    curve.type = static_cast<u16>(*FindParseScalar<u64>("CurveType", node));
-    curve.unk = static_cast<s32>(*FindParseScalar<u64>("Unknown1", node));
-    curve.unk2 = static_cast<u16>(*FindParseScalar<u64>("Unknown2", node));
-    const auto p = node.find_child("Points");
+    FieldCursor fields{node};
+    curve.propertyName = addString(fields.get<std::string_view>("PropertyName"));
+    curve.propertyIndex = static_cast<s16>(fields.get<u64>("PropertyIndex"));
+    curve.isGlobal = fields.get<bool>("IsGlobal");
+    curve.type = static_cast<u16>(fields.get<u64>("CurveType"));
+    curve.unk = static_cast<s32>(fields.get<u64>("Unknown1"));
+    curve.unk2 = static_cast<u16>(fields.get<u64>("Unknown2"));
+    const auto p = fields.find("Points");
     curve.points.resize(p.num_children());
     ParseSequence(p, &curve.points, [](void* data, const c4::yml::ConstNodeRef& n, u32 index) -> void {
         auto points = reinterpret_cast<std::vector<CurvePoint>*>(data);
-        (*points)[index].x = static_cast<f32>(*FindParseScalar<f64>("x", n));
-        (*points)[index].y = static_cast<f32>(*FindParseScalar<f64>("y", n));
+        FieldCursor fields{n};
+        (*points)[index].x = static_cast<f32>(fields.get<f64>("x"));
+        (*points)[index].y = static_cast<f32>(fields.get<f64>("y"));
     });
 }
 
 void System::loadRandom(Random& rand, const c4::yml::ConstNodeRef& node) {
-    rand.min = static_cast<f32>(*FindParseScalar<f64>("Min", node));
-    rand.max = static_cast<f32>(*FindParseScalar<f64>("Max", node));
+    FieldCursor fields{node};
+    rand.min = static_cast<f32>(fields.get<f64>("Min"));
+    rand.max = static_cast<f32>(fields.get<f64>("Max"));
 }
 
 void System::loadArrangeGroupParams(ArrangeGroupParams& groups, const c4::yml::ConstNodeRef& node) {
@@ -856,143 +1181,120 @@ void System::loadArrangeGroupParams(ArrangeGroupParams& groups, const c4::yml::C
     Arg arg = { this, &groups.groups };
     ParseSequence(node, &arg, [](void* data, const c4::yml::ConstNodeRef& n, u32 index) -> void {
         auto arg = reinterpret_cast<Arg*>(data);
-        (*arg->groups)[index].groupName = arg->sys->addString(*FindParseScalar<std::string>("GroupName", n));
-        (*arg->groups)[index].limitType = static_cast<s8>(*FindParseScalar<u64>("LimitType", n));
-        (*arg->groups)[index].limitThreshold = static_cast<s8>(*FindParseScalar<u64>("LimitThreshold", n));
-        (*arg->groups)[index].unk = static_cast<u8>(*FindParseScalar<u64>("Unknown", n));
+        FieldCursor fields{n};
+        (*arg->groups)[index].groupName = arg->sys->addString(fields.get<std::string_view>("GroupName"));
+        (*arg->groups)[index].limitType = static_cast<s8>(fields.get<u64>("LimitType"));
+        (*arg->groups)[index].limitThreshold = static_cast<s8>(fields.get<u64>("LimitThreshold"));
+        (*arg->groups)[index].unk = static_cast<u8>(fields.get<u64>("Unknown"));
     });
 }
 
 
-void System::loadParam(Param& param, const c4::yml::ConstNodeRef& node, ParamType type /*, std::map<DirectValue, s32>& valueMap */) {
+void System::loadParam(Param& param, const c4::yml::ConstNodeRef& node, ParamType type) {
     param.index = mPDT.searchParamIndex(RymlSubstrToStrView(node.key()), type);
-    const std::string_view tag = RymlGetValTag(node);
+    const Tag tag = RymlGetValTagId(node);
     const auto define = mPDT.getParam(param.index, type);
-    if (tag.empty() || tag == "!directValue") {
+    if (tag == Tag::DirectValue) {
         switch (define.getType()) {
-            case xlink2::ParamType::Int: {
-                param.type = xlink2::ValueReferenceType::Direct;
-                param.value = static_cast<u32>(*ParseScalarAs<u64>(node));
-                // const s32 val = static_cast<s32>(*ParseScalarAs<u64>(node));
-                // auto res = valueMap.find(DirectValue{{.s = val}, {.e = xlink2::ParamType::Int}});
-                // if (res == valueMap.end()) {
-                //     mDirectValues.emplace_back(std::bit_cast<u32, s32>(val));
-                //     param.value = static_cast<u32>(mDirectValues.size() - 1);
-                //     valueMap.emplace(DirectValue{{.s = val}, {.e = xlink2::ParamType::Int}}, static_cast<s32>(mDirectValues.size() - 1));
-                // } else {
-                //     param.value = static_cast<u32>(res->second);
-                // }
-                return;
-            }
-            case xlink2::ParamType::Float: {
-                param.type = xlink2::ValueReferenceType::Direct;
-                param.value = static_cast<u32>(*ParseScalarAs<u64>(node));
-                // const f32 val = static_cast<f32>(*ParseScalarAs<f64>(node));
-                // auto res = valueMap.find(DirectValue{{.f = val}, {.e = xlink2::ParamType::Float}});
-                // if (res == valueMap.end()) {
-                //     mDirectValues.emplace_back(std::bit_cast<u32, f32>(val));
-                //     param.value = static_cast<u32>(mDirectValues.size() - 1);
-                //     valueMap.emplace(DirectValue{{.f = val}, {.e = xlink2::ParamType::Float}}, static_cast<s32>(mDirectValues.size() - 1));
-                // } else {
-                //     param.value = static_cast<u32>(res->second);
-                // }
-                return;
-            }
-            case xlink2::ParamType::Bool: {
+            case xlink2::ParamType::Int:
+            case xlink2::ParamType::Float:
+            case xlink2::ParamType::Bool:
+            case xlink2::ParamType::Enum:
                 param.type = xlink2::ValueReferenceType::Direct;
-                param.value = static_cast<u32>(*ParseScalarAs<u64>(node));
-                // const bool val = *ParseScalarAs<bool>(node);
-                // auto res = valueMap.find(DirectValue{{.b = val}, {.e = xlink2::ParamType::Bool}});
-                // if (res == valueMap.end()) {
-                //     mDirectValues.emplace_back(val ? 1 : 0);
-                //     param.value = static_cast<u32>(mDirectValues.size() - 1);
-                //     valueMap.emplace(DirectValue{{.b = val}, {.e = xlink2::ParamType::Bool}}, static_cast<s32>(mDirectValues.size() - 1));
-                // } else {
-                //     param.value = static_cast<u32>(res->second);
-                // }
+                param.value = static_cast<u32>(DecodeScalar<u64>(node));
                 return;
-            }
-            case xlink2::ParamType::Enum: {
-                param.type = xlink2::ValueReferenceType::Direct;
-                param.value = static_cast<u32>(*ParseScalarAs<u64>(node));
-                // const u32 val = static_cast<u32>(*ParseScalarAs<u64>(node));
-                // auto res = valueMap.find(DirectValue{{.u = val}, {.e = xlink2::ParamType::Enum}});
-                // if (res == valueMap.end()) {
-                //     mDirectValues.emplace_back(val);
-                //     param.value = static_cast<u32>(mDirectValues.size() - 1);
-                //     valueMap.emplace(DirectValue{{.u = val}, {.e = xlink2::ParamType::Enum}}, static_cast<s32>(mDirectValues.size() - 1));
-                // } else {
-                //     param.value = static_cast<u32>(res->second);
-                // }
-                return;
-            }
+            default:
+                throw ParseError(std::format("Invalid direct value param type {:#x}", static_cast<u32>(define.getType())));
+        }
+    }
+    // anything else written in place is the value itself and gets its direct value slot once the user is merged
+    if (tag == Tag::None || (tag == Tag::U && define.getType() == xlink2::ParamType::Enum)) {
+        DirectValue value{};
+        value.type.e = define.getType();
+        switch (define.getType()) {
+            case xlink2::ParamType::Int:
+            case xlink2::ParamType::Enum:
+                value.value.u = static_cast<u32>(DecodeScalar<u64>(node));
+                break;
+            case xlink2::ParamType::Float:
+                value.value.f = static_cast<f32>(DecodeScalar<f64>(node));
+                break;
+            case xlink2::ParamType::Bool:
+                value.value.u = DecodeScalar<bool>(node) ? 1 : 0;
+                break;
             case xlink2::ParamType::String: {
                 param.type = xlink2::ValueReferenceType::String;
-                param.value = addString(*ParseScalarAs<std::string>(node));
+                param.value = addString(RymlSubstrToStrView(node.val()));
                 return;
             }
             default:
                 throw ParseError(std::format("Invalid param type {:#x}", static_cast<u32>(define.getType())));
         }
-    }
-    else if (tag == "!curve") {
+        param.type = xlink2::ValueReferenceType::Direct;
+        if (sLoadArena != nullptr) {
+            sLoadArena->directValues.emplace_back(&param, value);
+        } else {
+            param.value = static_cast<u32>(internDirectValue(value));
+        }
+        return;
+    } else if (tag == Tag::Curve) {
         if (define.getType() != xlink2::ParamType::Float)
             throw ParseError("Curves must be floats!");
         param.type = xlink2::ValueReferenceType::Curve;
-        param.value = static_cast<u32>(*ParseScalarAs<u64>(node));
+        param.value = static_cast<u32>(DecodeScalar<u64>(node));
         return;
-    } else if (tag == "!random") {
+    } else if (tag == Tag::Random) {
         if (define.getType() != xlink2::ParamType::Float)
             throw ParseError("Random calls must be floats!");
-        param.type = static_cast<xlink2::ValueReferenceType>(*FindParseScalar<u64>("Type", node));
-        param.value = static_cast<u32>(*FindParseScalar<u64>("Index", node));
+        FieldCursor fields{node};
+        param.type = static_cast<xlink2::ValueReferenceType>(fields.get<u64>("Type"));
+        param.value = static_cast<u32>(fields.get<u64>("Index"));
         return;
-    } else if (tag == "!bitfield") {
+    } else if (tag == Tag::Bitfield) {
         if (define.getType() != xlink2::ParamType::Int)
             throw ParseError("!bitfield must use Int!");
         param.type = xlink2::ValueReferenceType::Bitfield;
-        param.value = static_cast<u32>(*ParseScalarAs<u64>(node));
+        param.value = static_cast<u32>(DecodeScalar<u64>(node));
         return;
-    } else if (tag == "!arrangeGroupParam") {
+    } else if (tag == Tag::ArrangeGroupParam) {
         if (define.getType() != xlink2::ParamType::Bitfield)
             throw ParseError("ArrangeGroupParams must be bitfields!");
         param.type = xlink2::ValueReferenceType::ArrangeParam;
-        param.value = static_cast<u32>(*ParseScalarAs<u64>(node));
+        param.value = static_cast<u32>(DecodeScalar<u64>(node));
         return;
     }
     
-    throw ParseError(std::format("Invalid tag! {:s}", tag));
+    throw ParseError(std::format("Invalid tag! {:s}", RymlGetValTag(node)));
 }
 
-void System::loadParamSet(ParamSet& params, const c4::yml::ConstNodeRef& node, ParamType type /*, std::map<DirectValue, s32>& valueMap */) {
+void System::loadParamSet(ParamSet& params, const c4::yml::ConstNodeRef& node, ParamType type) {
     params.params.resize(node.num_children());
     for (u32 i = 0; const auto& child : node) {
-        loadParam(params.params[i], child, type /*, valueMap */);
+        loadParam(params.params[i], child, type);
         ++i;
     }
 }
 
 void System::loadCondition(Condition& condition, const c4::yml::ConstNodeRef& node) {
-    const std::string_view tag = RymlGetValTag(node);
-
-    switch (util::calcCRC32(tag)) {
-        case 0x2a8d07ed: { // !switch
+    FieldCursor fields{node};
+    switch (RymlGetValTagId(node)) {
+        case Tag::Switch: {
             static constexpr std::array<std::string_view, 6> sCompareTypes = {
                 "Equal", "GreaterThan", "GreaterThanOrEqual", "LessThan", "LessThanOrEqual", "NotEqual",  
             };
             condition.parentContainerType = xlink2::ContainerType::Switch;
             auto c = condition.getAs<xlink2::ContainerType::Switch>();
-            c->compareType = util::matchEnum<xlink2::CompareType>(*FindParseScalar<std::string>("CompareType", node), sCompareTypes);
-            c->isGlobal = *FindParseScalar<bool>("IsGlobal", node);
-            c->actionHash = static_cast<u32>(*FindParseScalar<u64>("Value1", node));
-            const auto valNode = RymlGetMapItem(node, "Value2");
-            const std::string_view valTag = RymlGetValTag(valNode);
-            if (valTag == "!u") {
+            c->compareType = util::matchEnum<xlink2::CompareType>(fields.get<std::string_view>("CompareType"), sCompareTypes);
+            c->isGlobal = fields.get<bool>("IsGlobal");
+            c->actionHash = static_cast<u32>(fields.get<u64>("Value1"));
+            const auto valNode = fields.find("Value2");
+            const Tag valTag = RymlGetValTagId(valNode);
+            if (valTag == Tag::U) {
                 c->propType = xlink2::PropertyType::Enum;
-                c->conditionValue.i = std::bit_cast<s32, u32>(static_cast<u32>(*ParseScalarAs<u64>(valNode)));
-                c->enumName = addString(*FindParseScalar<std::string>("EnumName", node));
-            } else if (valTag.empty()) {
-                const auto value = ParseScalar(valNode);
+                c->conditionValue.i = std::bit_cast<s32, u32>(static_cast<u32>(DecodeScalar<u64>(valNode)));
+                c->enumName = addString(fields.get<std::string_view>("EnumName"));
+            } else if (valTag == Tag::None) {
+                const auto value = DecodeNumber(valNode);
                 if (const u64* asInt = std::get_if<u64>(&value)) {
                     c->propType = xlink2::PropertyType::S32;
                     c->conditionValue.i = static_cast<s32>(*asInt);
@@ -1005,136 +1307,135 @@ void System::loadCondition(Condition& condition, const c4::yml::ConstNodeRef& no
                 } else {
                     throw ParseError("Failed to parse switch condition property value");
                 }
-            } else if (valTag == "!i4") {
+            } else if (valTag == Tag::I4) {
                 c->propType = xlink2::PropertyType::_04;
-                c->conditionValue.i = static_cast<s32>(*ParseScalarAs<u64>(valNode));
-            } else if (valTag == "!f5") {
+                c->conditionValue.i = static_cast<s32>(DecodeScalar<u64>(valNode));
+            } else if (valTag == Tag::F5) {
                 c->propType = xlink2::PropertyType::_05;
-                c->conditionValue.f = static_cast<f32>(*ParseScalarAs<f64>(valNode));
+                c->conditionValue.f = static_cast<f32>(DecodeScalar<f64>(valNode));
             } else {
                 throw ParseError("Failed to parse switch condition property value");
             }
             break;
         }
-        case 0x535f9620: { // !random
+        case Tag::Random: {
             condition.parentContainerType = xlink2::ContainerType::Random;
             auto c = condition.getAs<xlink2::ContainerType::Random>();
-            c->weight = static_cast<f32>(*FindParseScalar<f64>("Weight", node));
+            c->weight = static_cast<f32>(fields.get<f64>("Weight"));
             break;
         }
-        case 0x21e8c153: { // !random2
+        case Tag::Random2: {
             condition.parentContainerType = xlink2::ContainerType::Random2;
             auto c = condition.getAs<xlink2::ContainerType::Random2>();
-            c->weight = static_cast<f32>(*FindParseScalar<f64>("Weight", node));
+            c->weight = static_cast<f32>(fields.get<f64>("Weight"));
             break;
         }
-        case 0x108df105: { // !blend
+        case Tag::Blend: {
             static constexpr std::array<std::string_view, 6> sBlendTypes = {
                 "None", "Multiply", "SquareRoot", "Sin", "Add", "SetToOne", 
             };
             condition.parentContainerType = xlink2::ContainerType::Blend;
             auto c = condition.getAs<xlink2::ContainerType::Blend>();
-            c->min = static_cast<f32>(*FindParseScalar<f64>("Min", node));
-            c->max = static_cast<f32>(*FindParseScalar<f64>("Max", node));
-            c->blendTypeToMin = util::matchEnum<xlink2::BlendType>(*FindParseScalar<std::string>("BlendTypeMin", node), sBlendTypes);
-            c->blendTypeToMax = util::matchEnum<xlink2::BlendType>(*FindParseScalar<std::string>("BlendTypeMax", node), sBlendTypes);
+            c->min = static_cast<f32>(fields.get<f64>("Min"));
+            c->max = static_cast<f32>(fields.get<f64>("Max"));
+            c->blendTypeToMin = util::matchEnum<xlink2::BlendType>(fields.get<std::string_view>("BlendTypeMin"), sBlendTypes);
+            c->blendTypeToMax = util::matchEnum<xlink2::BlendType>(fields.get<std::string_view>("BlendTypeMax"), sBlendTypes);
             break;
         }
-        case 0x44278a0c: { // !sequence
+        case Tag::Sequence: {
             condition.parentContainerType = xlink2::ContainerType::Sequence;
             auto c = condition.getAs<xlink2::ContainerType::Sequence>();
-            c->continueOnFade = static_cast<s32>(*FindParseScalar<u64>("ContinueOnFade", node));
+            c->continueOnFade = static_cast<s32>(fields.get<u64>("ContinueOnFade"));
             break;
         }
 
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
-        case 0x35e7f782: { // !grid
+        case Tag::Grid: {
             condition.parentContainerType = xlink2::ContainerType::Grid;
             break;
         }
 #endif
 #if XLINK_TARGET_IS_TOTK
-        case 0xbc7428a3: { // !jump
+        case Tag::Jump: {
             condition.parentContainerType = xlink2::ContainerType::Jump;
             break;
         }
 #endif
         default: {
-            throw ParseError(std::format("Invalid condition tag: {:#010x}", util::calcCRC32(tag)));
+            throw ParseError(std::format("Invalid condition tag: {}", RymlGetValTag(node)));
         }
     }
 }
 
 void System::loadContainer(Container& container, const c4::yml::ConstNodeRef& node) {
-    const std::string_view tag = RymlGetValTag(node);
-
-    switch (util::calcCRC32(tag)) {
-        case 0x2a8d07ed: { // !switch
+    FieldCursor fields{node};
+    switch (RymlGetValTagId(node)) {
+        case Tag::Switch: {
             auto c = container.getAs<xlink2::ContainerType::Switch>();
             container.type = xlink2::ContainerType::Switch;
-            c->actionSlotName = addString(*FindParseScalar<std::string>("ValueName", node));
-            c->propertyIndex = static_cast<s16>(*FindParseScalar<u64>("PropertyIndex", node));
-            c->isGlobal = *FindParseScalar<bool>("IsGlobal", node);
-            c->watchPropertyId = static_cast<s32>(*FindParseScalar<u64>("WatchPropertyId", node));
+            c->actionSlotName = addString(fields.get<std::string_view>("ValueName"));
+            c->propertyIndex = static_cast<s16>(fields.get<u64>("PropertyIndex"));
+            c->isGlobal = fields.get<bool>("IsGlobal");
+            c->watchPropertyId = static_cast<s32>(fields.get<u64>("WatchPropertyId"));
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
-            c->unk = static_cast<s32>(*FindParseScalar<u64>("Unknown", node));
-            c->isActionTrigger = *FindParseScalar<bool>("IsActionTrigger", node);
+            c->unk = static_cast<s32>(fields.get<u64>("Unknown"));
+            c->isActionTrigger = fields.get<bool>("IsActionTrigger");
 #endif
             break;
         }
-        case 0x535f9620: { // !random
+        case Tag::Random: {
             container.type = xlink2::ContainerType::Random;
             break;
         }
-        case 0x21e8c153: { // !random2
+        case Tag::Random2: {
             container.type = xlink2::ContainerType::Random2;
             break;
         }
-        case 0x108df105: { // !blend
+        case Tag::Blend: {
             container.type = xlink2::ContainerType::Blend;
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
             container.isNotBlendAll = false;
             if (node.num_children() > 3) { // type 2 blend
                 container.isNotBlendAll = true;
                 auto c = container.getAs<xlink2::ContainerType::Blend, true>();
-                c->actionSlotName = addString(*FindParseScalar<std::string>("ValueName", node));
-                c->unk = static_cast<s32>(*FindParseScalar<u64>("Unknown", node));
-                c->propertyIndex = static_cast<s16>(*FindParseScalar<u64>("PropertyIndex", node));
-                c->isGlobal = *FindParseScalar<bool>("IsGlobal", node);
-                c->isActionTrigger = *FindParseScalar<bool>("IsActionTrigger", node);
+                c->actionSlotName = addString(fields.get<std::string_view>("ValueName"));
+                c->unk = static_cast<s32>(fields.get<u64>("Unknown"));
+                c->propertyIndex = static_cast<s16>(fields.get<u64>("PropertyIndex"));
+                c->isGlobal = fields.get<bool>("IsGlobal");
+                c->isActionTrigger = fields.get<bool>("IsActionTrigger");
             }
 #endif
             break;
         }
-        case 0x44278a0c: { // !sequence
+        case Tag::Sequence: {
             container.type = xlink2::ContainerType::Sequence;
             break;
         }
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
-        case 0x35e7f782: { // !grid
+        case Tag::Grid: {
             auto c = container.getAs<xlink2::ContainerType::Grid>();
             container.type = xlink2::ContainerType::Grid;
-            c->propertyName1 = addString(*FindParseScalar<std::string>("PropertyName1", node));
-            c->propertyName2 = addString(*FindParseScalar<std::string>("PropertyName2", node));
-            c->propertyIndex1 = static_cast<s16>(*FindParseScalar<u64>("PropertyIndex1", node));
-            c->propertyIndex2 = static_cast<s16>(*FindParseScalar<u64>("PropertyIndex2", node));
-            c->isGlobal1 = *FindParseScalar<bool>("IsProperty1Global", node);
-            c->isGlobal2 = *FindParseScalar<bool>("IsProperty2Global", node);
-            const auto vals1 = RymlGetMapItem(node, "Property1Values");
-            const auto vals2 = RymlGetMapItem(node, "Property2Values");
+            c->propertyName1 = addString(fields.get<std::string_view>("PropertyName1"));
+            c->propertyName2 = addString(fields.get<std::string_view>("PropertyName2"));
+            c->propertyIndex1 = static_cast<s16>(fields.get<u64>("PropertyIndex1"));
+            c->propertyIndex2 = static_cast<s16>(fields.get<u64>("PropertyIndex2"));
+            c->isGlobal1 = fields.get<bool>("IsProperty1Global");
+            c->isGlobal2 = fields.get<bool>("IsProperty2Global");
+            const auto vals1 = fields.find("Property1Values");
+            const auto vals2 = fields.find("Property2Values");
             c->values1.resize(vals1.num_children());
             c->values2.resize(vals2.num_children());
             auto parseU32Array = [](void* data, const c4::yml::ConstNodeRef& n, u32 index) -> void {
                 std::vector<u32>* values = reinterpret_cast<std::vector<u32>*>(data);
-                (*values)[index] = static_cast<u32>(*ParseScalarAs<u64>(n));
+                (*values)[index] = static_cast<u32>(DecodeScalar<u64>(n));
             };
             ParseSequence(vals1, &c->values1, parseU32Array);
             ParseSequence(vals2, &c->values2, parseU32Array);
             auto parseS32Array = [](void* data, const c4::yml::ConstNodeRef& n, u32 index) -> void {
                 std::vector<s32>* values = reinterpret_cast<std::vector<s32>*>(data);
-                (*values)[index] = static_cast<s32>(*ParseScalarAs<u64>(n));
+                (*values)[index] = static_cast<s32>(DecodeScalar<u64>(n));
             };
-            const auto indices = RymlGetMapItem(node, "IndexGridMap");
+            const auto indices = fields.find("IndexGridMap");
             c->indices.resize(indices.num_children());
             if (c->indices.size() != (c->values1.size() * c->values2.size()))
                 throw ParseError("Grid has the incorrect number of indices!\n");
@@ -1143,118 +1444,160 @@ void System::loadContainer(Container& container, const c4::yml::ConstNodeRef& no
         }
 #endif
 #if XLINK_TARGET_IS_TOTK
-        case 0xbc7428a3: { // !jump
+        case Tag::Jump: {
             container.type = xlink2::ContainerType::Jump;
             break;
         }
 #endif
         default: {
-            throw ParseError(std::format("Invalid container tag: {:#010x}", util::calcCRC32(tag)));
+            throw ParseError(std::format("Invalid container tag: {}", RymlGetValTag(node)));
         }
     }
 
-    container.childContainerStartIdx = static_cast<s32>(*FindParseScalar<u64>("ChildContainerBaseIndex", node));
-    container.childCount = static_cast<s32>(*FindParseScalar<u64>("ChildContainerCount", node));
+    container.childContainerStartIdx = static_cast<s32>(fields.get<u64>("ChildContainerBaseIndex"));
+    container.childCount = static_cast<s32>(fields.get<u64>("ChildContainerCount"));
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
-    container.isNeedObserve = *FindParseScalar<bool>("IsNeedObserve", node);
+    container.isNeedObserve = fields.get<bool>("IsNeedObserve");
 #endif
 }
 
 void System::loadAssetCallTable(AssetCallTable& act, const c4::yml::ConstNodeRef& node) {
-    act.keyName = addString(*FindParseScalar<std::string>("KeyName", node));
-    act.assetIndex = static_cast<u16>(*FindParseScalar<u64>("AssetIndex", node)); // this field isn't necessary so maybe we should axe it?
-    act.flag = (*FindParseScalar<bool>("IsContainer", node) ? 1 : 0) | static_cast<u16>(*FindParseScalar<u64>("Flag", node));
-    act.duration = static_cast<s32>(*FindParseScalar<u64>("Duration", node));
-    act.parentIndex = static_cast<s32>(*FindParseScalar<u64>("ParentIndex", node));
-    act.guid = static_cast<u32>(*FindParseScalar<u64>("GUID", node));
-    act.keyNameHash = static_cast<u32>(*FindParseScalar<u64>("KeyNameHash", node)); // this one also is unnecessary
-    act.assetParamIdx = static_cast<s32>(*FindParseScalar<u64>("AssetParamOrContainerIndex", node));
-    act.conditionIdx = static_cast<s32>(*FindParseScalar<u64>("ConditionIndex", node));
+    FieldCursor fields{node};
+    act.keyName = addString(fields.get<std::string_view>("KeyName"));
+    act.assetIndex = static_cast<u16>(fields.get<u64>("AssetIndex")); // this field isn't necessary so maybe we should axe it?
+    act.flag = (fields.get<bool>("IsContainer") ? 1 : 0) | static_cast<u16>(fields.get<u64>("Flag"));
+    act.duration = static_cast<s32>(fields.get<u64>("Duration"));
+    act.parentIndex = static_cast<s32>(fields.get<u64>("ParentIndex"));
+    act.guid = static_cast<u32>(fields.get<u64>("GUID"));
+    act.keyNameHash = static_cast<u32>(fields.get<u64>("KeyNameHash")); // this one also is unnecessary
+    act.assetParamIdx = static_cast<s32>(fields.get<u64>("AssetParamOrContainerIndex"));
+    act.conditionIdx = static_cast<s32>(fields.get<u64>("ConditionIndex"));
 }
 
 void System::loadActionSlot(ActionSlot& slot, const c4::yml::ConstNodeRef& node) {
-    slot.actionSlotName = addString(*FindParseScalar<std::string>("SlotName", node));
-    slot.actionStartIdx = static_cast<s16>(*FindParseScalar<u64>("ActionBaseIndex", node));
-    slot.actionCount = static_cast<s16>(*FindParseScalar<u64>("ActionCount", node));
+    FieldCursor fields{node};
+    slot.actionSlotName = addString(fields.get<std::string_view>("SlotName"));
+    slot.actionStartIdx = static_cast<s16>(fields.get<u64>("ActionBaseIndex"));
+    slot.actionCount = static_cast<s16>(fields.get<u64>("ActionCount"));
 }
 
 void System::loadAction(Action& action, const c4::yml::ConstNodeRef& node) {
-    action.actionName = addString(*FindParseScalar<std::string>("ActionName", node));
-    action.actionTriggerStartIdx = static_cast<s16>(*FindParseScalar<u64>("TriggerBaseIndex", node));
-    action.actionTriggerCount = static_cast<s16>(*FindParseScalar<u64>("TriggerCount", node));
+    FieldCursor fields{node};
+    action.actionName = addString(fields.get<std::string_view>("ActionName"));
+    action.actionTriggerStartIdx = static_cast<s16>(fields.get<u64>("TriggerBaseIndex"));
+    action.actionTriggerCount = static_cast<s16>(fields.get<u64>("TriggerCount"));
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
-    action.enableMatchStart = *FindParseScalar<bool>("EnableMatchStart", node);
+    action.enableMatchStart = fields.get<bool>("EnableMatchStart");
 #endif
 }
 
 void System::loadActionTrigger(ActionTrigger& trigger, const c4::yml::ConstNodeRef& node) {
-    trigger.guid = static_cast<u32>(*FindParseScalar<u64>("GUID", node));
+    FieldCursor fields{node};
+    trigger.guid = static_cast<u32>(fields.get<u64>("GUID"));
 #if XLINK_TARGET_IS_TOTK || XLINK_TARGET_IS_THUNDER
-    trigger.unk = static_cast<u32>(*FindParseScalar<u64>("Unknown", node));
+    trigger.unk = static_cast<u32>(fields.get<u64>("Unknown"));
 #endif
-    trigger.triggerOnce = *FindParseScalar<bool>("TriggerOnce", node);
-    trigger.fade = *FindParseScalar<bool>("IsFade", node);
-    trigger.alwaysTrigger = *FindParseScalar<bool>("AlwaysTrigger", node);
-    const auto startFrameMaybe = node.find_child("StartFrame");
+    trigger.triggerOnce = fields.get<bool>("TriggerOnce");
+    trigger.fade = fields.get<bool>("IsFade");
+    trigger.alwaysTrigger = fields.get<bool>("AlwaysTrigger");
+    trigger.assetCallIdx = static_cast<s32>(fields.get<u64>("AssetCallTableIndex"));
+    const auto startFrameMaybe = fields.find("StartFrame");
     if (startFrameMaybe.invalid()) {
-        trigger.previousActionName = addString(*FindParseScalar<std::string>("PreviousActionName", node));
+        trigger.previousActionName = addString(fields.get<std::string_view>("PreviousActionName"));
         trigger.nameMatch = true;
     } else {
-        trigger.startFrame = static_cast<s32>(*ParseScalarAs<u64>(startFrameMaybe));
+        trigger.startFrame = static_cast<s32>(DecodeScalar<u64>(startFrameMaybe));
         trigger.nameMatch = false;
     }
-    trigger.assetCallIdx = static_cast<s32>(*FindParseScalar<u64>("AssetCallTableIndex", node));
-    trigger.endFrame = static_cast<s32>(*FindParseScalar<u64>("EndFrame", node));
-    trigger.triggerOverwriteIdx = static_cast<s32>(*FindParseScalar<u64>("TriggerOverwriteParamIndex", node));
-    trigger.overwriteHash = static_cast<u16>(*FindParseScalar<u64>("OverwriteHash", node));
+    trigger.endFrame = static_cast<s32>(fields.get<u64>("EndFrame"));
+    trigger.triggerOverwriteIdx = static_cast<s32>(fields.get<u64>("TriggerOverwriteParamIndex"));
+    trigger.overwriteHash = static_cast<u16>(fields.get<u64>("OverwriteHash"));
 }
 
 void System::loadProperty(Property& prop, const c4::yml::ConstNodeRef& node) {
-    prop.propertyName = addString(*FindParseScalar<std::string>("PropertyName", node));
-    prop.isGlobal = *FindParseScalar<bool>("IsGlobal", node);
-    prop.propTriggerStartIdx = static_cast<s32>(*FindParseScalar<u64>("TriggerBaseIndex", node));
-    prop.propTriggerCount = static_cast<s32>(*FindParseScalar<u64>("TriggerCount", node));
+    FieldCursor fields{node};
+    prop.propertyName = addString(fields.get<std::string_view>("PropertyName"));
+    prop.isGlobal = fields.get<bool>("IsGlobal");
+    prop.propTriggerStartIdx = static_cast<s32>(fields.get<u64>("TriggerBaseIndex"));
+    prop.propTriggerCount = static_cast<s32>(fields.get<u64>("TriggerCount"));
 }
 
 void System::loadPropertyTrigger(PropertyTrigger& trigger, const c4::yml::ConstNodeRef& node) {
-    trigger.guid = static_cast<u32>(*FindParseScalar<u64>("GUID", node));
-    trigger.flag = static_cast<u16>(*FindParseScalar<u64>("Flag", node));
-    trigger.overwriteHash = static_cast<u16>(*FindParseScalar<u64>("OverwriteHash", node));
-    trigger.assetCallTableIdx = static_cast<s32>(*FindParseScalar<u64>("AssetCallTableIndex", node));
-    trigger.conditionIdx = static_cast<s32>(*FindParseScalar<u64>("ConditionIndex", node));
-    trigger.triggerOverwriteIdx = static_cast<s32>(*FindParseScalar<u64>("TriggerOverwriteParamIndex", node));
+    FieldCursor fields{node};
+    trigger.guid = static_cast<u32>(fields.get<u64>("GUID"));
+    trigger.flag = static_cast<u16>(fields.get<u64>("Flag"));
+    trigger.overwriteHash = static_cast<u16>(fields.get<u64>("OverwriteHash"));
+    trigger.assetCallTableIdx = static_cast<s32>(fields.get<u64>("AssetCallTableIndex"));
+    trigger.conditionIdx = static_cast<s32>(fields.get<u64>("ConditionIndex"));
+    trigger.triggerOverwriteIdx = static_cast<s32>(fields.get<u64>("TriggerOverwriteParamIndex"));
 }
 
 void System::loadAlwaysTrigger(AlwaysTrigger& trigger, const c4::yml::ConstNodeRef& node) {
-    trigger.guid = static_cast<u32>(*FindParseScalar<u64>("GUID", node));
-    trigger.flag = static_cast<u16>(*FindParseScalar<u64>("Flag", node));
-    trigger.overwriteHash = static_cast<u16>(*FindParseScalar<u64>("OverwriteHash", node));
-    trigger.assetCallIdx = static_cast<s32>(*FindParseScalar<u64>("AssetCallTableIndex", node));
-    trigger.triggerOverwriteIdx = static_cast<s32>(*FindParseScalar<u64>("TriggerOverwriteParamIndex", node));
+    FieldCursor fields{node};
+    trigger.guid = static_cast<u32>(fields.get<u64>("GUID"));
+    trigger.flag = static_cast<u16>(fields.get<u64>("Flag"));
+    trigger.overwriteHash = static_cast<u16>(fields.get<u64>("OverwriteHash"));
+    trigger.assetCallIdx = static_cast<s32>(fields.get<u64>("AssetCallTableIndex"));
+    trigger.triggerOverwriteIdx = static_cast<s32>(fields.get<u64>("TriggerOverwriteParamIndex"));
 }
 
-void System::loadUser(User& user, const c4::yml::ConstNodeRef& node /*, std::map<DirectValue, s32>& valueMap */) {
-    const auto localProps = node.find_child("LocalProperties");
+// user names that aren't known get written as their hash instead
+inline u32 ParseUserHash(const c4::yml::ConstNodeRef& node) {
+    if (RymlGetKeyTagId(node) == Tag::U) {
+        return static_cast<u32>(DecodeScalarKey<u64>(node));
+    }
+    return util::calcCRC32(DecodeScalarKey<std::string_view>(node));
+}
+
+void System::loadDirectValue(DirectValue& value, const c4::yml::ConstNodeRef& node) {
+    if (!node.has_val_tag()) {
+        const auto number = DecodeNumber(node);
+        if (const u64* asInt = std::get_if<u64>(&number)) {
+            value.type.e = xlink2::ParamType::Int;
+            value.value.s = static_cast<s32>(*asInt);
+        } else if (const f64* asFloat = std::get_if<f64>(&number)) {
+            value.type.e = xlink2::ParamType::Float;
+            value.value.f = static_cast<f32>(*asFloat);
+        } else if (const bool* asBool = std::get_if<bool>(&number)) {
+            value.type.e = xlink2::ParamType::Bool;
+            value.value.b = *asBool;
+        } else {
+            throw ParseError("Failed to parse switch condition property value");
+        }
+    } else {
+        const Tag tag = RymlGetValTagId(node);
+        value.value.u = static_cast<u32>(DecodeScalar<u64>(node));
+        if (tag == Tag::U) {
+            value.type.e = xlink2::ParamType::Enum;
+        } else {
+            value.type.e = static_cast<xlink2::ParamType>(-1);
+        }
+    }
+}
+
+void System::loadUser(User& user, const c4::yml::ConstNodeRef& node) {
+    FieldCursor fields{node};
+    const auto localProps = fields.find("LocalProperties");
     if (localProps.invalid() || !localProps.is_seq())
         throw ParseError("Did not find LocalProperties field!\n");
 
     user.mLocalProperties.resize(localProps.num_children());
     for (u32 i = 0; const auto& prop : localProps) {
-        user.mLocalProperties[i] = addString({prop.val().data(), prop.val().size()});
+        user.mLocalProperties[i] = addString(RymlSubstrToStrView(prop.val()));
         ++i;
     }
 
-    const auto userParams = node.find_child("UserParams");
+    const auto userParams = fields.find("UserParams");
     if (userParams.invalid() || !userParams.is_map())
         throw ParseError("Did not find UserParams field!\n");
 
     user.mUserParams.resize(userParams.num_children());
     for (u32 i = 0; const auto& child : userParams) {
-        loadParam(user.mUserParams[i], child, ParamType::USER /*, valueMap */);
+        loadParam(user.mUserParams[i], child, ParamType::USER);
         ++i;
     }
 
-    const auto containers = node.find_child("Containers");
+    const auto containers = fields.find("Containers");
     if (containers.invalid() || !containers.is_map())
         throw ParseError("Did not find Containers field!\n");
 
@@ -1264,7 +1607,7 @@ void System::loadUser(User& user, const c4::yml::ConstNodeRef& node /*, std::map
         ++i;
     }
 
-    const auto acts = node.find_child("AssetCallTables");
+    const auto acts = fields.find("AssetCallTables");
     if (acts.invalid() || !acts.is_map())
         throw ParseError("Did not find AssetCallTables field!\n");
 
@@ -1274,7 +1617,7 @@ void System::loadUser(User& user, const c4::yml::ConstNodeRef& node /*, std::map
         ++i;
     }
 
-    const auto slots = node.find_child("ActionSlots");
+    const auto slots = fields.find("ActionSlots");
     if (slots.invalid() || !slots.is_map())
         throw ParseError("Did not find ActionSlots field!\n");
 
@@ -1284,7 +1627,7 @@ void System::loadUser(User& user, const c4::yml::ConstNodeRef& node /*, std::map
         ++i;
     }
 
-    const auto actions = node.find_child("Actions");
+    const auto actions = fields.find("Actions");
     if (actions.invalid() || !actions.is_map())
         throw ParseError("Did not find Actions field!\n");
 
@@ -1294,7 +1637,7 @@ void System::loadUser(User& user, const c4::yml::ConstNodeRef& node /*, std::map
         ++i;
     }
 
-    const auto actionTriggers = node.find_child("ActionTriggers");
+    const auto actionTriggers = fields.find("ActionTriggers");
     if (actionTriggers.invalid() || !actionTriggers.is_map())
         throw ParseError("Did not find ActionTriggers field!\n");
 
@@ -1304,7 +1647,7 @@ void System::loadUser(User& user, const c4::yml::ConstNodeRef& node /*, std::map
         ++i;
     }
 
-    const auto props = node.find_child("Properties");
+    const auto props = fields.find("Properties");
     if (props.invalid() || !props.is_map())
         throw ParseError("Did not find Properties field!\n");
 
@@ -1314,7 +1657,7 @@ void System::loadUser(User& user, const c4::yml::ConstNodeRef& node /*, std::map
         ++i;
     }
 
-    const auto propTriggers = node.find_child("PropertyTriggers");
+    const auto propTriggers = fields.find("PropertyTriggers");
     if (propTriggers.invalid() || !propTriggers.is_map())
         throw ParseError("Did not find PropertyTriggers field!\n");
 
@@ -1324,7 +1667,7 @@ void System::loadUser(User& user, const c4::yml::ConstNodeRef& node /*, std::map
         ++i;
     }
 
-    const auto alwaysTriggers = node.find_child("AlwaysTriggers");
+    const auto alwaysTriggers = fields.find("AlwaysTriggers");
     if (alwaysTriggers.invalid() || !alwaysTriggers.is_map())
         throw ParseError("Did not find AlwaysTriggers field!\n");
 
@@ -1335,15 +1678,130 @@ void System::loadUser(User& user, const c4::yml::ConstNodeRef& node /*, std::map
     }
 
 #if XLINK_TARGET == TOTK
-    user.mUnknown = static_cast<u32>(*FindParseScalar<u64>("Unknown", node));
+    user.mUnknown = static_cast<u32>(fields.get<u64>("Unknown"));
 #endif
 }
 
+thread_local System::LoadArena* System::sLoadArena = nullptr;
+
+s32 System::internDirectValue(const DirectValue& value) {
+    const auto key = static_cast<u64>(value.type.u) << 32 | value.value.u;
+    const auto matches = [&](s32 index) {
+        const auto& entry = mDirectValues[static_cast<u32>(index)];
+        return entry.type.u == value.type.u && entry.value.u == value.value.u;
+    };
+
+    if (const auto it = mDirectValueIndices.find(key); it != mDirectValueIndices.end() && matches(it->second)) {
+        return it->second;
+    }
+    // catch up on anything added or replaced since the last lookup, the first copy of a value wins
+    if (mIndexedDirectValues > mDirectValues.size()) {
+        mDirectValueIndices.clear();
+        mIndexedDirectValues = 0;
+    }
+    for (; mIndexedDirectValues < mDirectValues.size(); ++mIndexedDirectValues) {
+        const auto& entry = mDirectValues[mIndexedDirectValues];
+        mDirectValueIndices.emplace(static_cast<u64>(entry.type.u) << 32 | entry.value.u, static_cast<s32>(mIndexedDirectValues));
+    }
+    if (const auto it = mDirectValueIndices.find(key); it != mDirectValueIndices.end()) {
+        if (matches(it->second)) {
+            return it->second;
+        }
+        // the entry was overwritten in place, start over
+        mDirectValueIndices.clear();
+        mIndexedDirectValues = 0;
+        return internDirectValue(value);
+    }
+
+    mDirectValues.push_back(value);
+    mIndexedDirectValues = mDirectValues.size();
+    markDirty(Pool::DirectValues);
+    const s32 index = static_cast<s32>(mDirectValues.size() - 1);
+    mDirectValueIndices.emplace(key, index);
+    return index;
+}
+
+std::string_view System::addArenaString(std::string_view s) {
+    // nothing writes to mStrings while users are loading so every thread can look things up in it
+    if (const auto it = mStrings.find(s); it != mStrings.end()) {
+        return *it;
+    }
+    if (const auto it = sLoadArena->strings.find(s); it != sLoadArena->strings.end()) {
+        return *it;
+    }
+    return *sLoadArena->strings.insert(isBorrowable(s) ? s : std::string_view(sLoadArena->storage.emplace_back(s))).first;
+}
+
+void System::loadUserIsolated(LoadedUser& entry, const c4::yml::ConstNodeRef& node) {
+    entry.hash = ParseUserHash(node);
+
+    struct ArenaScope {
+        ArenaScope(LoadArena* arena) {
+            sLoadArena = arena;
+        }
+        ~ArenaScope() {
+            sLoadArena = nullptr;
+        }
+    } scope{&entry.arena};
+    loadUser(entry.user, node);
+}
+
+void System::mergeLoadedUser(LoadedUser& entry) {
+    mStrings.merge(entry.arena.strings);
+    mStringStorage.splice(mStringStorage.end(), entry.arena.storage);
+    // the leftovers were already added by an earlier user, point at that copy so the user matches what mStrings has
+    if (!entry.arena.strings.empty()) {
+        entry.user.forEachString([&](std::string_view& str) {
+            if (entry.arena.strings.contains(str)) {
+                str = *mStrings.find(str);
+            }
+        });
+    }
+    // slots are handed out in document order here rather than whenever a worker got to them
+    for (const auto& [param, value] : entry.arena.directValues) {
+        param->value = static_cast<u32>(internDirectValue(value));
+    }
+    // later duplicates replace earlier ones, same as loading them in place did
+    mUsers.insert_or_assign(entry.hash, std::move(entry.user));
+}
+
+void System::loadUsers(const c4::yml::ConstNodeRef& node) {
+    std::vector<c4::yml::ConstNodeRef> children;
+    children.reserve(node.num_children());
+    for (const auto& child : node) {
+        children.push_back(child);
+    }
+
+    // users only read their own subtree and the pdt, so they can be loaded independently as long as strings are kept apart
+    std::vector<LoadedUser> loaded(children.size());
+    util::parallelFor(children.size(), [&](size_t i) {
+        loadUserIsolated(loaded[i], children[i]);
+    });
+
+    // merging in document order means the same copy of a string always wins regardless of how the work was split up
+    for (auto& entry : loaded) {
+        mergeLoadedUser(entry);
+    }
+}
+
 bool System::loadYAML(std::string_view text) {
     InitRymlIfNeeded();
+    // the tree's arena goes away once we're done, so every string gets copied out of it
     ryml::Tree tree = ryml::parse_in_arena(StrViewToRymlSubstr(text));
+    tree.resolve(); // the compact profile writes repeated pool entries as aliases
+    return loadYAMLTree(tree.rootref());
+}
 
-    const auto node = tree.rootref();
+bool System::loadYAML(std::vector<u8>&& text) {
+    InitRymlIfNeeded();
+    // scalars are unescaped in place so the text has to be ours to modify, and it has to outlive the strings borrowed from it
+    mText = std::move(text);
+    ryml::Tree tree = ryml::parse_in_place(ryml::substr{reinterpret_cast<char*>(mText.data()), mText.size()});
+    tree.resolve();
+    return loadYAMLTree(tree.rootref());
+}
+
+bool System::loadYAMLTree(const c4::yml::ConstNodeRef& node) {
     if (node.invalid() || !node.is_map()) {
         std::cerr << "Not a valid yaml input file!\n";
         return false;
@@ -1355,7 +1813,7 @@ bool System::loadYAML(std::string_view text) {
         return false;
     }
 
-    const auto res = ParseScalarAs<u64>(version);
+    const auto res = DecodeInt(RymlSubstrToStrView(version.val()));
     if (res != std::nullopt) {
         mVersion = static_cast<u32>(*res);
     } else {
@@ -1369,7 +1827,7 @@ bool System::loadYAML(std::string_view text) {
     }
 
     const auto pdt = node.find_child("ParamDefineTable");
-    if (pdt.invalid() || !pdt.has_val_tag() || pdt.val_tag() != "!pdt" || !pdt.is_map()) {
+    if (pdt.invalid() || !pdt.has_val_tag() || RymlGetValTagId(pdt) != Tag::Pdt || !pdt.is_map()) {
         std::cerr << "Did not find ParamDefineTable field!\n";
         return false;
     }
@@ -1382,7 +1840,7 @@ bool System::loadYAML(std::string_view text) {
     const auto strings = node.find_child("Strings");
     if (!strings.invalid() && strings.is_seq()) {
         for (const auto& child : strings) {
-            mStrings.insert({child.val().data(), child.val().size()});
+            addString(RymlSubstrToStrView(child.val()));
         }
     }
 
@@ -1394,7 +1852,7 @@ bool System::loadYAML(std::string_view text) {
 
     mLocalProperties.resize(localProps.num_children());
     for (u32 i = 0; const auto& prop : localProps) {
-        mLocalProperties[i] = addString({prop.val().data(), prop.val().size()});
+        mLocalProperties[i] = addString(RymlSubstrToStrView(prop.val()));
         ++i;
     }
 
@@ -1406,7 +1864,7 @@ bool System::loadYAML(std::string_view text) {
 
     mLocalPropertyEnumStrings.resize(localEnums.num_children());
     for (u32 i = 0; const auto& prop : localEnums) {
-        mLocalPropertyEnumStrings[i] = addString({prop.val().data(), prop.val().size()});
+        mLocalPropertyEnumStrings[i] = addString(RymlSubstrToStrView(prop.val()));
         ++i;
     }
 
@@ -1454,51 +1912,17 @@ bool System::loadYAML(std::string_view text) {
 
     mDirectValues.resize(directVals.num_children());
     for (u32 i = 0; const auto& val : directVals) {
-        if (!val.has_val_tag()) {
-            const auto value = ParseScalar(val);
-            if (const u64* asInt = std::get_if<u64>(&value)) {
-                mDirectValues[i].type.e = xlink2::ParamType::Int;
-                mDirectValues[i].value.s = static_cast<s32>(*asInt);
-            } else if (const f64* asFloat = std::get_if<f64>(&value)) {
-                mDirectValues[i].type.e = xlink2::ParamType::Float;
-                mDirectValues[i].value.f = static_cast<f32>(*asFloat);
-            } else if (const bool* asBool = std::get_if<bool>(&value)) {
-                mDirectValues[i].type.e = xlink2::ParamType::Bool;
-                mDirectValues[i].value.b = *asBool;
-            } else {
-                throw ParseError("Failed to parse switch condition property value");
-            }
-        } else {
-            const std::string_view tag = RymlGetValTag(val);
-            mDirectValues[i].value.u = static_cast<u32>(*ParseScalarAs<u64>(val));
-            if (tag == "!u") {
-                mDirectValues[i].type.e = xlink2::ParamType::Enum;
-            } else {
-                mDirectValues[i].type.e = static_cast<xlink2::ParamType>(-1);
-            }
-        }
+        loadDirectValue(mDirectValues[i], val);
         ++i;
     }
 
-    // std::map<DirectValue, s32> valueMap{};
-
     const auto users = node.find_child("Users");
     if (users.invalid() || !users.is_map()) {
         std::cerr << "Did not find Users field!\n";
         return false;
     }
 
-    for (const auto& child : users) {
-        const std::string_view keyTag = RymlGetKeyTag(child);
-        u32 hash;
-        if (keyTag == "!u") {
-            hash = static_cast<u32>(*ParseScalarKeyAs<u64>(child));
-        } else {
-            hash = util::calcCRC32(*ParseScalarKeyAs<std::string>(child));
-        }
-        auto newUser = mUsers.emplace(hash, User());
-        loadUser((*newUser.first).second, child /*, valueMap*/);
-    }
+    loadUsers(users);
 
     const auto assets = node.find_child("AssetParams");
     if (assets.invalid() || !assets.is_map()) {
@@ -1508,7 +1932,7 @@ bool System::loadYAML(std::string_view text) {
 
     mAssetParams.resize(assets.num_children());
     for (u32 i = 0; const auto& child : assets) {
-        loadParamSet(mAssetParams[i], child, ParamType::ASSET /*, valueMap*/);
+        loadParamSet(mAssetParams[i], child, ParamType::ASSET);
         ++i;
     }
 
@@ -1520,7 +1944,7 @@ bool System::loadYAML(std::string_view text) {
 
     mTriggerOverwriteParams.resize(triggers.num_children());
     for (u32 i = 0; const auto& child : triggers) {
-        loadParamSet(mTriggerOverwriteParams[i], child, ParamType::TRIGGER /*, valueMap*/);
+        loadParamSet(mTriggerOverwriteParams[i], child, ParamType::TRIGGER);
         ++i;
     }
 
@@ -1540,4 +1964,901 @@ bool System::loadYAML(std::string_view text) {
     return true;
 }
 
-} // namespace banana
\ No newline at end of file
+// entries are keyed by their index in the pool, returns whether anything was loaded
+template <typename T, typename Load>
+static bool OverlayPool(const c4::yml::ConstNodeRef& node, std::string_view section, std::vector<T>& pool, Load&& load) {
+    const auto entries = node.find_child(StrViewToRymlSubstr(section));
+    if (entries.invalid()) {
+        return false;
+    }
+    if (!entries.is_map()) {
+        throw ParseError(std::format("{} is not a mapping!", section));
+    }
+    for (const auto& entry : entries) {
+        const u64 index = DecodeScalarKey<u64>(entry);
+        if (index > pool.size()) {
+            throw ParseError(std::format("{} index {} leaves a gap after the end of the pool ({} entries)", section, index, pool.size()));
+        }
+        if (index == pool.size()) {
+            pool.emplace_back();
+        } else {
+            pool[index] = T{};
+        }
+        load(pool[index], entry);
+    }
+    return entries.num_children() != 0;
+}
+
+bool System::loadYAMLOverlay(std::vector<u8>&& text) {
+    try {
+        return applyYAMLOverlay(std::move(text));
+    } catch (const ParseError& e) {
+        std::cerr << std::format("Failed to parse overlay: {}\n", e.what());
+        return false;
+    } catch (const RymlError& e) {
+        std::cerr << std::format("Failed to parse overlay: {}\n", e.what());
+        return false;
+    }
+}
+
+bool System::applyYAMLOverlay(std::vector<u8>&& text) {
+    InitRymlIfNeeded();
+    ryml::Tree tree;
+    if (mText.empty()) {
+        mText = std::move(text);
+        tree = ryml::parse_in_place(ryml::substr{reinterpret_cast<char*>(mText.data()), mText.size()});
+    } else {
+        // strings may already be borrowed from the text we're holding, so this one gets copied out of instead
+        tree = ryml::parse_in_arena(ryml::csubstr{reinterpret_cast<const char*>(text.data()), text.size()});
+    }
+    tree.resolve();
+
+    const auto node = tree.rootref();
+    if (node.invalid() || !node.is_map()) {
+        std::cerr << "Not a valid yaml input file!\n";
+        return false;
+    }
+
+    if (const auto version = node.find_child("Version"); !version.invalid()) {
+        if (DecodeInt(RymlSubstrToStrView(version.val())) != static_cast<u64>(mVersion)) {
+            std::cerr << "Overlay version doesn't match the base file!\n";
+            return false;
+        }
+    }
+
+    // every param refers to the pdt by index, there's no sensible way to patch it
+    if (!node.find_child("ParamDefineTable").invalid()) {
+        std::cerr << "Overlays can't change the ParamDefineTable!\n";
+        return false;
+    }
+
+    if (const auto strings = node.find_child("Strings"); !strings.invalid() && strings.is_seq()) {
+        for (const auto& child : strings) {
+            addString(RymlSubstrToStrView(child.val()));
+        }
+    }
+
+    // these are small and always rewritten, so they're replaced as a whole
+    if (const auto localProps = node.find_child("LocalProperties"); !localProps.invalid() && localProps.is_seq()) {
+        mLocalProperties.clear();
+        for (const auto& prop : localProps) {
+            mLocalProperties.push_back(addString(RymlSubstrToStrView(prop.val())));
+        }
+    }
+    if (const auto localEnums = node.find_child("LocalPropertyEnumValues"); !localEnums.invalid() && localEnums.is_seq()) {
+        mLocalPropertyEnumStrings.clear();
+        for (const auto& prop : localEnums) {
+            mLocalPropertyEnumStrings.push_back(addString(RymlSubstrToStrView(prop.val())));
+        }
+    }
+
+    if (OverlayPool(node, "Curves", mCurves, [&](Curve& curve, const c4::yml::ConstNodeRef& n) { loadCurve(curve, n); })) {
+        markDirty(Pool::Curves);
+    }
+    if (OverlayPool(node, "RandomTable", mRandomCalls, [&](Random& random, const c4::yml::ConstNodeRef& n) { loadRandom(random, n); })) {
+        markDirty(Pool::RandomCalls);
+    }
+    if (OverlayPool(node, "ArrangeGroupParams", mArrangeGroupParams, [&](ArrangeGroupParams& group, const c4::yml::ConstNodeRef& n) {
+        loadArrangeGroupParams(group, n);
+    })) {
+        markDirty(Pool::ArrangeGroupParams);
+    }
+    if (OverlayPool(node, "DirectValues", mDirectValues, [&](DirectValue& value, const c4::yml::ConstNodeRef& n) { loadDirectValue(value, n); })) {
+        markDirty(Pool::DirectValues);
+        // entries were replaced in place, so the lookup internDirectValue uses has to be rebuilt from scratch
+        mDirectValueIndices.clear();
+        mIndexedDirectValues = 0;
+    }
+    if (OverlayPool(node, "AssetParams", mAssetParams, [&](ParamSet& param, const c4::yml::ConstNodeRef& n) {
+        loadParamSet(param, n, ParamType::ASSET);
+    })) {
+        markDirty(Pool::AssetParams);
+    }
+    if (OverlayPool(node, "TriggerOverwriteParams", mTriggerOverwriteParams, [&](ParamSet& param, const c4::yml::ConstNodeRef& n) {
+        loadParamSet(param, n, ParamType::TRIGGER);
+    })) {
+        markDirty(Pool::TriggerOverwriteParams);
+    }
+    if (OverlayPool(node, "Conditions", mConditions, [&](Condition& cond, const c4::yml::ConstNodeRef& n) { loadCondition(cond, n); })) {
+        markDirty(Pool::Conditions);
+    }
+
+    // freshly loaded users start out dirty, the rest keep their source bytes
+    if (const auto users = node.find_child("Users"); !users.invalid()) {
+        if (!users.is_map()) {
+            std::cerr << "Users is not a mapping!\n";
+            return false;
+        }
+        loadUsers(users);
+    }
+
+    return true;
+}
+
+// copies one node at a time out of the parser's events into a small tree so the usual loaders can be reused
+// the tree (and the strings it points at) only ever holds the entry currently being loaded
+class EventTreeBuilder {
+public:
+    explicit EventTreeBuilder(LibyamlParser& parser) : mParser(parser) {}
+
+    void reset() {
+        mTree.clear();
+        mTree.clear_arena();
+        mStrings.clear();
+        mTree.to_map(mTree.root_id());
+    }
+
+    struct Key {
+        ryml::csubstr value;
+        ryml::csubstr tag;
+        bool quoted;
+    };
+
+    // the current event has to be a scalar key, it's copied since the event goes away on the next call
+    Key readKey() {
+        const auto& event = mParser.Current();
+        if (event.type != YAML_SCALAR_EVENT)
+            throw ParseError("Only scalar keys are supported");
+        return { store(scalarValue(event)), store(tagOf(event.data.scalar.tag)), event.data.scalar.style != YAML_PLAIN_SCALAR_STYLE };
+    }
+
+    // builds the node starting at the current event as the value of key under the root
+    c4::yml::ConstNodeRef readEntry(const Key& key) {
+        return mTree.cref(append(mTree.root_id(), &key));
+    }
+
+    // skips over the node starting at the current event
+    void skip() {
+        s32 depth = 0;
+        for (auto type = mParser.Current().type;; type = mParser.Next().type) {
+            if (type == YAML_MAPPING_START_EVENT || type == YAML_SEQUENCE_START_EVENT) {
+                ++depth;
+            } else if (type == YAML_MAPPING_END_EVENT || type == YAML_SEQUENCE_END_EVENT) {
+                --depth;
+            }
+            if (depth == 0)
+                return;
+        }
+    }
+
+    static std::string_view scalarValue(const yaml_event_t& event) {
+        return { reinterpret_cast<const char*>(event.data.scalar.value), event.data.scalar.length };
+    }
+
+    // empty if the node starting at event has no anchor
+    static std::string_view anchorOf(const yaml_event_t& event) {
+        const yaml_char_t* anchor = nullptr;
+        switch (event.type) {
+            case YAML_SCALAR_EVENT: anchor = event.data.scalar.anchor; break;
+            case YAML_MAPPING_START_EVENT: anchor = event.data.mapping_start.anchor; break;
+            case YAML_SEQUENCE_START_EVENT: anchor = event.data.sequence_start.anchor; break;
+            default: break;
+        }
+        return anchor != nullptr ? reinterpret_cast<const char*>(anchor) : std::string_view{};
+    }
+
+private:
+    // libyaml hands tags back fully resolved while ryml keeps them the way they were written
+    static std::string tagOf(const yaml_char_t* tag) {
+        if (tag == nullptr)
+            return {};
+        const std::string_view view = reinterpret_cast<const char*>(tag);
+        constexpr std::string_view cCorePrefix = "tag:yaml.org,2002:";
+        if (view.starts_with(cCorePrefix)) {
+            return std::format("!!{}", view.substr(cCorePrefix.size()));
+        }
+        return std::string(view);
+    }
+
+    ryml::csubstr store(std::string_view str) {
+        if (str.empty())
+            return {};
+        return StrViewToRymlSubstr(mStrings.emplace_back(str));
+    }
+
+    ryml::id_type append(ryml::id_type parent, const Key* key) {
+        const auto& event = mParser.Current();
+        const ryml::id_type id = mTree.append_child(parent);
+        const auto keyFlags = key != nullptr && key->quoted ? ryml::KEYQUO : ryml::NOTYPE;
+
+        switch (event.type) {
+            case YAML_SCALAR_EVENT: {
+                const auto value = store(scalarValue(event));
+                const auto flags = keyFlags | (event.data.scalar.style != YAML_PLAIN_SCALAR_STYLE ? ryml::VALQUO : ryml::NOTYPE);
+                if (key != nullptr) {
+                    mTree.to_keyval(id, key->value, value, flags);
+                } else {
+                    mTree.to_val(id, value, flags);
+                }
+                setTags(id, key, store(tagOf(event.data.scalar.tag)));
+                return id;
+            }
+            case YAML_MAPPING_START_EVENT: {
+                if (key != nullptr) {
+                    mTree.to_map(id, key->value, keyFlags);
+                } else {
+                    mTree.to_map(id);
+                }
+                setTags(id, key, store(tagOf(event.data.mapping_start.tag)));
+                while (mParser.Next().type != YAML_MAPPING_END_EVENT) {
+                    const Key childKey = readKey();
+                    mParser.Next();
+                    append(id, &childKey);
+                }
+                return id;
+            }
+            case YAML_SEQUENCE_START_EVENT: {
+                if (key != nullptr) {
+                    mTree.to_seq(id, key->value, keyFlags);
+                } else {
+                    mTree.to_seq(id);
+                }
+                setTags(id, key, store(tagOf(event.data.sequence_start.tag)));
+                while (mParser.Next().type != YAML_SEQUENCE_END_EVENT) {
+                    append(id, nullptr);
+                }
+                return id;
+            }
+            case YAML_ALIAS_EVENT:
+                throw ParseError("Aliases are only supported for whole pool entries when streaming");
+            default:
+                throw ParseError("Unexpected yaml event");
+        }
+    }
+
+    void setTags(ryml::id_type id, const Key* key, ryml::csubstr valTag) {
+        if (key != nullptr && !key->tag.empty())
+            mTree.set_key_tag(id, key->tag);
+        if (!valTag.empty())
+            mTree.set_val_tag(id, valTag);
+    }
+
+    LibyamlParser& mParser;
+    ryml::Tree mTree{};
+    std::deque<std::string> mStrings{}; // deque so the views handed to the tree don't move as more get added
+};
+
+// the json counterpart of EventTreeBuilder, which also undoes the tag wrappers JsonWriter adds
+// the reader unescapes strings in place, so the tree points straight into the text instead of copying anything
+class JsonEntryBuilder {
+public:
+    explicit JsonEntryBuilder(JsonReader& reader) : mReader(reader) {}
+
+    void reset() {
+        mTree.clear();
+        mTree.clear_arena();
+        mTree.to_map(mTree.root_id());
+    }
+
+    struct Key {
+        ryml::csubstr value;
+        ryml::csubstr tag;
+    };
+
+    // tagged keys are written as "!tag text"
+    static Key splitKey(std::string_view key) {
+        if (!key.starts_with('!'))
+            return { StrViewToRymlSubstr(key), {} };
+        const size_t space = key.find(' ');
+        if (space == std::string_view::npos)
+            throw ParseError(std::format("Tag wrapper {} has to be the only key of its object", key));
+        return { StrViewToRymlSubstr(key.substr(space + 1)), explicitTag(key.substr(0, space)) };
+    }
+
+    // builds the value starting at event as the value of key under the root
+    c4::yml::ConstNodeRef readEntry(const Key& key, JsonReader::Event event) {
+        const ryml::id_type id = mTree.append_child(mTree.root_id());
+        read(id, &key, event, false, {});
+        return mTree.cref(id);
+    }
+
+    // skips over the value starting at event
+    void skip(JsonReader::Event event) {
+        using Event = JsonReader::Event;
+        s32 depth = 0;
+        for (;; event = mReader.Next()) {
+            if (event == Event::BeginObject || event == Event::BeginArray) {
+                ++depth;
+            } else if (event == Event::EndObject || event == Event::EndArray) {
+                --depth;
+            } else if (event == Event::End) {
+                throw ParseError("Unexpected end of the json document");
+            }
+            if (depth == 0)
+                return;
+        }
+    }
+
+private:
+    static bool isWrapper(std::string_view key) {
+        return key.starts_with('!') && key.find(' ') == std::string_view::npos;
+    }
+
+    // core tags only say what the scalar already is, the yaml doesn't write them either
+    static ryml::csubstr explicitTag(std::string_view tag) {
+        return tag.starts_with("!!") ? ryml::csubstr{} : StrViewToRymlSubstr(tag);
+    }
+
+    // fills in id from the value starting at event, wrapped is set for the value inside a tag wrapper
+    void read(ryml::id_type id, const Key* key, JsonReader::Event event, bool wrapped, ryml::csubstr tag) {
+        using Event = JsonReader::Event;
+        switch (event) {
+            case Event::String:
+            case Event::Literal: {
+                // a wrapped scalar is plain however json had to write it since the tag says what it is
+                const auto flags = event == Event::String && !wrapped ? ryml::VALQUO : ryml::NOTYPE;
+                const auto value = StrViewToRymlSubstr(mReader.Value());
+                if (key != nullptr) {
+                    mTree.to_keyval(id, key->value, value, flags);
+                } else {
+                    mTree.to_val(id, value, flags);
+                }
+                setTags(id, key, tag);
+                return;
+            }
+            case Event::BeginObject: {
+                Event next = mReader.Next();
+                if (!wrapped && next == Event::Key && isWrapper(mReader.Value())) {
+                    const std::string_view wrapperTag = mReader.Value();
+                    read(id, key, mReader.Next(), true, explicitTag(wrapperTag));
+                    if (mReader.Next() != Event::EndObject)
+                        throw ParseError(std::format("Tag wrapper {} has to be the only key of its object", wrapperTag));
+                    return;
+                }
+                if (key != nullptr) {
+                    mTree.to_map(id, key->value);
+                } else {
+                    mTree.to_map(id);
+                }
+                setTags(id, key, tag);
+                // the reader only hands out keys until the object ends
+                for (; next != Event::EndObject; next = mReader.Next()) {
+                    const Key childKey = splitKey(mReader.Value());
+                    read(mTree.append_child(id), &childKey, mReader.Next(), false, {});
+                }
+                return;
+            }
+            case Event::BeginArray: {
+                if (key != nullptr) {
+                    mTree.to_seq(id, key->value);
+                } else {
+                    mTree.to_seq(id);
+                }
+                setTags(id, key, tag);
+                for (Event next = mReader.Next(); next != Event::EndArray; next = mReader.Next()) {
+                    read(mTree.append_child(id), nullptr, next, false, {});
+                }
+                return;
+            }
+            default:
+                throw ParseError("Unexpected json event");
+        }
+    }
+
+    void setTags(ryml::id_type id, const Key* key, ryml::csubstr valTag) {
+        if (key != nullptr && !key->tag.empty())
+            mTree.set_key_tag(id, key->tag);
+        if (!valTag.empty())
+            mTree.set_val_tag(id, valTag);
+    }
+
+    JsonReader& mReader;
+    ryml::Tree mTree{};
+};
+
+// walks the top level sections of a yaml document for loadSections, one pool entry or user at a time
+class YamlSections {
+public:
+    explicit YamlSections(LibyamlParser& parser) : mParser(parser), mBuilder(parser) {}
+
+    bool begin() {
+        if (mParser.Next().type != YAML_STREAM_START_EVENT || mParser.Next().type != YAML_DOCUMENT_START_EVENT
+            || mParser.Next().type != YAML_MAPPING_START_EVENT) {
+            std::cerr << "Not a valid yaml input file!\n";
+            return false;
+        }
+        return true;
+    }
+
+    // moves on to the value of the next section, false once the document is done
+    bool next(std::string& section) {
+        if (mParser.Next().type == YAML_MAPPING_END_EVENT)
+            return false;
+        if (mParser.Current().type != YAML_SCALAR_EVENT)
+            throw ParseError("Not a valid yaml input file!");
+        section = EventTreeBuilder::scalarValue(mParser.Current());
+        mParser.Next();
+        return true;
+    }
+
+    std::optional<u64> readInt() {
+        return mParser.Current().type == YAML_SCALAR_EVENT ? DecodeInt(EventTreeBuilder::scalarValue(mParser.Current())) : std::nullopt;
+    }
+
+    c4::yml::ConstNodeRef readNode(std::string_view name) {
+        mBuilder.reset();
+        return mBuilder.readEntry({ StrViewToRymlSubstr(name), {}, false });
+    }
+
+    // calls func on each value of the section's mapping, one at a time
+    template <typename Func>
+    void forEachEntry(std::string_view section, Func&& func) {
+        if (mParser.Current().type != YAML_MAPPING_START_EVENT)
+            throw ParseError(std::format("{} is not a mapping!", section));
+        while (mParser.Next().type != YAML_MAPPING_END_EVENT) {
+            mBuilder.reset();
+            const auto key = mBuilder.readKey();
+            mParser.Next();
+            func(mBuilder.readEntry(key));
+        }
+    }
+
+    // same as forEachEntry but an entry can also be an alias of an earlier one in the same pool, which just gets copied
+    template <typename T, typename Load>
+    void forEachPoolEntry(std::string_view section, std::vector<T>& pool, Load&& load) {
+        if (mParser.Current().type != YAML_MAPPING_START_EVENT)
+            throw ParseError(std::format("{} is not a mapping!", section));
+        std::unordered_map<std::string, size_t> anchors;
+        while (mParser.Next().type != YAML_MAPPING_END_EVENT) {
+            mBuilder.reset();
+            const auto key = mBuilder.readKey();
+            const auto& event = mParser.Next();
+            if (event.type == YAML_ALIAS_EVENT) {
+                const auto it = anchors.find(reinterpret_cast<const char*>(event.data.alias.anchor));
+                if (it == anchors.end())
+                    throw ParseError(std::format("{} has an alias to an unknown anchor!", section));
+                pool.push_back(pool[it->second]);
+                continue;
+            }
+            if (const auto anchor = EventTreeBuilder::anchorOf(event); !anchor.empty()) {
+                anchors.insert_or_assign(std::string(anchor), pool.size());
+            }
+            load(pool.emplace_back(), mBuilder.readEntry(key));
+        }
+    }
+
+    template <typename Func>
+    void forEachString(std::string_view section, Func&& func) {
+        if (mParser.Current().type != YAML_SEQUENCE_START_EVENT)
+            throw ParseError(std::format("{} is not a sequence!", section));
+        while (mParser.Next().type != YAML_SEQUENCE_END_EVENT) {
+            if (mParser.Current().type != YAML_SCALAR_EVENT)
+                throw ParseError(std::format("{} should only contain strings!", section));
+            func(EventTreeBuilder::scalarValue(mParser.Current()));
+        }
+    }
+
+    void skip() {
+        mBuilder.skip();
+    }
+
+private:
+    LibyamlParser& mParser;
+    EventTreeBuilder mBuilder;
+};
+
+// same as YamlSections for what dumpJSON writes, there are no aliases to deal with
+class JsonSections {
+public:
+    using Event = JsonReader::Event;
+
+    explicit JsonSections(JsonReader& reader) : mReader(reader), mBuilder(reader) {}
+
+    bool begin() {
+        if (mReader.Next() != Event::BeginObject) {
+            std::cerr << "Not a valid json input file!\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool next(std::string& section) {
+        // the reader only hands out keys until the object ends
+        if (mReader.Next() == Event::EndObject) {
+            if (mReader.Next() != Event::End)
+                throw ParseError("Trailing data after the json document");
+            return false;
+        }
+        section = mReader.Value();
+        mEvent = mReader.Next();
+        return true;
+    }
+
+    std::optional<u64> readInt() {
+        return mEvent == Event::Literal ? DecodeInt(mReader.Value()) : std::nullopt;
+    }
+
+    c4::yml::ConstNodeRef readNode(std::string_view name) {
+        mBuilder.reset();
+        return mBuilder.readEntry({ StrViewToRymlSubstr(name), {} }, mEvent);
+    }
+
+    template <typename Func>
+    void forEachEntry(std::string_view section, Func&& func) {
+        if (mEvent != Event::BeginObject)
+            throw ParseError(std::format("{} is not a mapping!", section));
+        for (Event event = mReader.Next(); event != Event::EndObject; event = mReader.Next()) {
+            mBuilder.reset();
+            const auto key = JsonEntryBuilder::splitKey(mReader.Value());
+            func(mBuilder.readEntry(key, mReader.Next()));
+        }
+    }
+
+    template <typename T, typename Load>
+    void forEachPoolEntry(std::string_view section, std::vector<T>& pool, Load&& load) {
+        forEachEntry(section, [&](const c4::yml::ConstNodeRef& node) { load(pool.emplace_back(), node); });
+    }
+
+    template <typename Func>
+    void forEachString(std::string_view section, Func&& func) {
+        if (mEvent != Event::BeginArray)
+            throw ParseError(std::format("{} is not a sequence!", section));
+        for (Event event = mReader.Next(); event != Event::EndArray; event = mReader.Next()) {
+            if (event != Event::String)
+                throw ParseError(std::format("{} should only contain strings!", section));
+            func(mReader.Value());
+        }
+    }
+
+    void skip() {
+        mBuilder.skip(mEvent);
+    }
+
+private:
+    JsonReader& mReader;
+    JsonEntryBuilder mBuilder;
+    Event mEvent = Event::End; // first event of the current section's value
+};
+
+template <typename Sections>
+bool System::loadSections(Sections& sections) {
+    if (!sections.begin()) {
+        return false;
+    }
+
+    constexpr std::array<std::string_view, 12> cRequiredSections = {
+        "Version", "ParamDefineTable", "LocalProperties", "LocalPropertyEnumValues", "Curves", "RandomTable",
+        "ArrangeGroupParams", "DirectValues", "AssetParams", "TriggerOverwriteParams", "Conditions", "Users",
+    };
+    std::array<bool, cRequiredSections.size()> found{};
+    bool hasPDT = false;
+
+    std::string section;
+    while (sections.next(section)) {
+        if (const auto it = std::ranges::find(cRequiredSections, section); it != cRequiredSections.end()) {
+            found[it - cRequiredSections.begin()] = true;
+        }
+
+        // there's no going back to an earlier section, so anything resolving parameter names needs the pdt loaded already
+        if ((section == "Users" || section == "AssetParams" || section == "TriggerOverwriteParams") && !hasPDT) {
+            std::cerr << std::format("ParamDefineTable has to come before {}!\n", section);
+            return false;
+        }
+
+        if (section == "Version") {
+            const auto res = sections.readInt();
+            if (res == std::nullopt) {
+                std::cerr << "Failed to parse version!\n";
+                return false;
+            }
+            mVersion = static_cast<u32>(*res);
+            if (mVersion != ResourceAccessor::sELinkResourceVersion && mVersion != ResourceAccessor::sSLinkResourceVersion) {
+                std::cerr << "Invalid version!\n";
+                return false;
+            }
+        } else if (section == "ParamDefineTable") {
+            const auto pdt = sections.readNode("ParamDefineTable");
+            if (!pdt.has_val_tag() || RymlGetValTagId(pdt) != Tag::Pdt || !pdt.is_map()) {
+                std::cerr << "Did not find ParamDefineTable field!\n";
+                return false;
+            }
+            if (!mPDT.loadYAML(pdt)) {
+                std::cerr << "Failed to load ParamDefineTable!\n";
+                return false;
+            }
+            hasPDT = true;
+        } else if (section == "Strings") {
+            sections.forEachString(section, [&](std::string_view str) { addString(str); });
+        } else if (section == "LocalProperties") {
+            sections.forEachString(section, [&](std::string_view str) { mLocalProperties.push_back(addString(str)); });
+        } else if (section == "LocalPropertyEnumValues") {
+            sections.forEachString(section, [&](std::string_view str) { mLocalPropertyEnumStrings.push_back(addString(str)); });
+        } else if (section == "Curves") {
+            sections.forEachEntry(section, [&](const c4::yml::ConstNodeRef& node) { loadCurve(mCurves.emplace_back(), node); });
+        } else if (section == "RandomTable") {
+            sections.forEachEntry(section, [&](const c4::yml::ConstNodeRef& node) { loadRandom(mRandomCalls.emplace_back(), node); });
+        } else if (section == "ArrangeGroupParams") {
+            sections.forEachPoolEntry(section, mArrangeGroupParams, [&](ArrangeGroupParams& groups, const c4::yml::ConstNodeRef& node) {
+                loadArrangeGroupParams(groups, node);
+            });
+        } else if (section == "DirectValues") {
+            sections.forEachEntry(section, [&](const c4::yml::ConstNodeRef& node) { loadDirectValue(mDirectValues.emplace_back(), node); });
+        } else if (section == "AssetParams") {
+            sections.forEachPoolEntry(section, mAssetParams, [&](ParamSet& params, const c4::yml::ConstNodeRef& node) {
+                loadParamSet(params, node, ParamType::ASSET);
+            });
+        } else if (section == "TriggerOverwriteParams") {
+            sections.forEachPoolEntry(section, mTriggerOverwriteParams, [&](ParamSet& params, const c4::yml::ConstNodeRef& node) {
+                loadParamSet(params, node, ParamType::TRIGGER);
+            });
+        } else if (section == "Conditions") {
+            sections.forEachEntry(section, [&](const c4::yml::ConstNodeRef& node) { loadCondition(mConditions.emplace_back(), node); });
+        } else if (section == "Users") {
+            // later duplicates replace earlier ones, same as loadUsers
+            sections.forEachEntry(section, [&](const c4::yml::ConstNodeRef& node) {
+                User user{};
+                loadUser(user, node);
+                mUsers.insert_or_assign(ParseUserHash(node), std::move(user));
+            });
+        } else {
+            sections.skip();
+        }
+    }
+
+    for (size_t i = 0; i < cRequiredSections.size(); ++i) {
+        if (!found[i]) {
+            std::cerr << std::format("Did not find {} field!\n", cRequiredSections[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool System::loadYAMLStream(util::InputStream& input) {
+    InitRymlIfNeeded();
+    // compressed input gets decompressed a block at a time as the parser asks for it
+    LibyamlParser parser{[](void* data, unsigned char* buffer, size_t size, size_t* sizeRead) -> int {
+        auto& stream = *static_cast<util::InputStream*>(data);
+        *sizeRead = stream.read(buffer, size);
+        return stream.hasFailed() ? 0 : 1;
+    }, &input};
+    YamlSections sections{parser};
+    return loadSections(sections);
+}
+
+bool System::loadJSON(std::string_view text) {
+    // the reader unescapes in place, so it needs a copy it can write to
+    return loadJSON(std::vector<u8>(text.begin(), text.end()));
+}
+
+bool System::loadJSON(std::vector<u8>&& text) {
+    InitRymlIfNeeded();
+    // strings are borrowed from the text, so it's kept around like loadYAML does
+    mText = std::move(text);
+    JsonReader reader{{reinterpret_cast<char*>(mText.data()), mText.size()}};
+    JsonSections sections{reader};
+    return loadSections(sections);
+}
+
+static constexpr u32 cSplitManifestVersion = 1;
+static constexpr std::string_view cSplitManifestName = "manifest.yaml";
+static constexpr std::string_view cSplitRootName = "root.yaml";
+
+static bool WriteTextFile(const std::filesystem::path& path, std::string_view text) {
+    util::OutputStream output;
+    if (!output.open(path.string())) {
+        return false;
+    }
+    output.write(text);
+    return output.close();
+}
+
+// manifest entries have to stay inside the export directory, so no absolute paths and no ..
+static bool IsManifestPathValid(const std::string_view path) {
+    const std::filesystem::path p{path};
+    if (path.empty() || p.is_absolute() || p.has_root_name() || p.has_root_directory()) {
+        return false;
+    }
+    return std::ranges::none_of(p, [](const std::filesystem::path& part) { return part == ".."; });
+}
+
+bool System::dumpYAMLSplit(const std::string& dir, const DumpOptions& options) const {
+    const std::filesystem::path base{dir};
+    std::error_code ec;
+    std::filesystem::create_directories(base / "users", ec);
+    if (ec) {
+        std::cerr << std::format("Failed to create {}!\n", (base / "users").string());
+        return false;
+    }
+
+    {
+        util::OutputStream output;
+        if (!output.open((base / cSplitRootName).string())) {
+            std::cerr << "Failed to open root file!\n";
+            return false;
+        }
+        YamlWriter writer;
+        writer.SetSink([&output](std::string_view text) { output.write(text); });
+        DumpOptions rootOptions = options;
+        rootOptions.includeUsers = false;
+        dumpYAML(writer, rootOptions);
+        if (!output.close()) {
+            std::cerr << "Failed to write root file!\n";
+            return false;
+        }
+    }
+
+    // names are only used as is if they're safe on every filesystem, including case insensitive ones
+    std::vector<std::pair<const std::pair<const u32, User>*, std::string>> files;
+    files.reserve(mUsers.size());
+    std::set<std::string> taken;
+    for (const auto& entry : mUsers) {
+        std::string name{lookupUserName(entry.first)};
+        const bool safe = !name.empty() && std::ranges::all_of(name, [](char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '.';
+        });
+        std::string folded = name;
+        std::ranges::transform(folded, folded.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        if (!safe || name.starts_with('.') || !taken.insert(std::move(folded)).second) {
+            name = std::format("{:#010x}", entry.first);
+        }
+        files.emplace_back(&entry, std::format("users/{}.yaml", name));
+    }
+
+    std::vector<u8> failed(files.size());
+    util::parallelFor(files.size(), [&](size_t i) {
+        const auto& [entry, file] = files[i];
+        failed[i] = !WriteTextFile(base / file, dumpUserFragment(entry->first, entry->second, 0, options));
+    });
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (failed[i]) {
+            std::cerr << std::format("Failed to write {}!\n", files[i].second);
+            return false;
+        }
+    }
+
+    // written last so an interrupted export never leaves a manifest pointing at files that aren't there
+    YamlWriter manifest;
+    {
+        YamlWriter::MappingScope scope{manifest, {}, YamlWriter::Block};
+        manifest.EmitString("Version");
+        manifest.EmitInt(cSplitManifestVersion);
+        manifest.EmitString("Root");
+        manifest.EmitString(cSplitRootName);
+        manifest.EmitString("Users");
+        YamlWriter::SequenceScope seqScope{manifest, {}, YamlWriter::Block};
+        for (const auto& [entry, file] : files) {
+            manifest.EmitString(file);
+        }
+    }
+    manifest.Finish();
+    if (!WriteTextFile(base / cSplitManifestName, manifest.GetOutput())) {
+        std::cerr << "Failed to write manifest!\n";
+        return false;
+    }
+    return true;
+}
+
+bool System::loadYAMLSplit(const std::string& dir) {
+    const std::filesystem::path base{dir};
+
+    std::vector<u8> manifestText{};
+    if (!util::loadFile((base / cSplitManifestName).string(), manifestText)) {
+        std::cerr << "Failed to open manifest!\n";
+        return false;
+    }
+
+    InitRymlIfNeeded();
+    const ryml::Tree manifest = ryml::parse_in_arena(ryml::csubstr{reinterpret_cast<const char*>(manifestText.data()), manifestText.size()});
+    if (!manifest.rootref().is_map()) {
+        std::cerr << "Not a valid manifest!\n";
+        return false;
+    }
+    FieldCursor fields{manifest.rootref()};
+    if (fields.get<u64>("Version") != cSplitManifestVersion) {
+        std::cerr << "Unsupported manifest version!\n";
+        return false;
+    }
+    const std::string rootFile{fields.get<std::string_view>("Root")};
+    const auto userList = fields.find("Users");
+    if (userList.invalid() || !userList.is_seq()) {
+        std::cerr << "Did not find Users field!\n";
+        return false;
+    }
+    std::vector<std::string> userFiles;
+    userFiles.reserve(userList.num_children());
+    for (const auto& child : userList) {
+        userFiles.emplace_back(DecodeScalar<std::string_view>(child));
+    }
+
+    if (!IsManifestPathValid(rootFile) || !std::ranges::all_of(userFiles, IsManifestPathValid)) {
+        std::cerr << "Manifest points outside of its directory!\n";
+        return false;
+    }
+
+    std::vector<u8> rootText{};
+    if (!util::loadFile((base / rootFile).string(), rootText)) {
+        std::cerr << "Failed to open root file!\n";
+        return false;
+    }
+
+    // users refer to the pools by index, so if those could have moved around everything has to be loaded again
+    const u64 rootHash = util::calcXXHash64(rootText.data(), rootText.size());
+    if (!mSplitSource.has_value() || mSplitSource->rootHash != rootHash) {
+        // the dictionary isn't part of the loaded model so it outlives the reset
+        const auto names = mNames;
+        *this = System{};
+        mNames = names;
+        if (!loadYAML(std::move(rootText))) {
+            return false;
+        }
+        mSplitSource.emplace().rootHash = rootHash;
+    }
+    auto& source = *mSplitSource;
+
+    struct UserFile {
+        u64 fileHash = 0;
+        bool changed = false;
+        LoadedUser loaded{};
+    };
+
+    // hashing a file is a lot cheaper than parsing it, so unchanged users are only read and never parsed
+    std::vector<UserFile> results(userFiles.size());
+    util::parallelFor(userFiles.size(), [&](size_t i) {
+        std::vector<u8> text{};
+        if (!util::loadFile((base / userFiles[i]).string(), text)) {
+            throw ParseError(std::format("Failed to open {}", userFiles[i]));
+        }
+        auto& result = results[i];
+        result.fileHash = util::calcXXHash64(text.data(), text.size());
+        if (const auto it = source.users.find(userFiles[i]); it != source.users.end() && it->second.fileHash == result.fileHash) {
+            return;
+        }
+        result.changed = true;
+
+        const ryml::Tree tree = ryml::parse_in_place(ryml::substr{reinterpret_cast<char*>(text.data()), text.size()});
+        const auto root = tree.rootref();
+        if (!root.is_map() || root.num_children() != 1) {
+            throw ParseError(std::format("{} should contain exactly one user", userFiles[i]));
+        }
+        loadUserIsolated(result.loaded, root.first_child());
+    });
+
+    // anything that came from a file that's gone or was rewritten is dropped before the new versions go in
+    std::map<std::string, SplitSource::UserFile> seen;
+    for (size_t i = 0; i < userFiles.size(); ++i) {
+        if (!results[i].changed) {
+            seen.emplace(userFiles[i], source.users.at(userFiles[i]));
+        }
+    }
+    for (const auto& [file, entry] : source.users) {
+        if (!seen.contains(file)) {
+            mUsers.erase(entry.userHash);
+        }
+    }
+
+    // strings only used by the old versions stay in mStrings until eliminateDeadEntries gets rid of them
+    for (size_t i = 0; i < userFiles.size(); ++i) {
+        auto& result = results[i];
+        if (result.changed) {
+            seen.insert_or_assign(userFiles[i], SplitSource::UserFile{result.fileHash, result.loaded.hash});
+            mergeLoadedUser(result.loaded);
+        }
+    }
+    source.users = std::move(seen);
+
+    return true;
+}
+
+} // namespace banana